@@ -14,6 +14,7 @@ namespace element {
 
 class Context;
 class Settings;
+class RenderPool;
 class RootGraph;
 
 class AudioEngine final : public juce::ReferenceCountedObject {
@@ -61,6 +62,10 @@ public:
     void seekToAudioFrame (const int64 frame);
     void setMeter (int beatsPerBar, int beatDivisor);
 
+    /** Replace the transport's tempo map. The engine renders in pieces that
+        end on the map's tempo and meter changes. */
+    void setTempoMap (const TimeScale& map);
+
     void togglePlayPause();
 
     MidiKeyboardState& getKeyboardState();
@@ -78,9 +83,39 @@ public:
     void updateExternalLatencySamples();
     int getExternalLatencySamples() const;
 
+    /** Settings for an offline render. */
+    struct OfflineRender {
+        juce::File output; ///< WAV or FLAC file to write
+        juce::File midiInput; ///< Optional MIDI file played into the graphs
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int numChannels = 2;
+        int bitDepth = 24;
+        double lengthSeconds = 0.0; ///< 0 renders until the MIDI file ends
+        double tailSeconds = 2.0; ///< Extra time rendered after the end
+        bool stems = false; ///< Write each graph to its own file, rendering graphs in parallel
+
+        /** Called after each block with the progress from 0 to 1. Return false to cancel. */
+        std::function<bool (double)> progress;
+    };
+
+    /** Render the session to a file without an audio device, as fast as the
+        graphs allow. The transport plays from zero for the whole render.
+
+        With stems enabled every graph renders on its own, regardless of the
+        session's graph mode, into a file named after the output and the graph.
+
+        Must be called on the message thread while no device or host is
+        driving the engine.
+     */
+    juce::Result renderOffline (const OfflineRender& options);
+
     Context& context() const;
     MidiIOMonitorPtr getMidiIOMonitor() const;
 
+    /** Returns the pool of threads graphs use to render nodes in parallel. */
+    RenderPool& getRenderPool() noexcept;
+
     struct LevelMeter : public juce::ReferenceCountedObject {
         LevelMeter() noexcept {}
         inline double level() const noexcept { return _level.get(); }
@@ -129,6 +129,10 @@ public:
 
     Signal<void (const Node&)> sigNodeRemoved;
 
+    /** Emitted once every root graph of a reloaded session has finished
+        loading its nodes. */
+    Signal<void()> sigGraphsLoaded;
+
 private:
     friend struct RootGraphHolder;
     class RootGraphs;
@@ -18,10 +18,12 @@ public:
     ~LV2NodeProvider();
     juce::String format() const override { return "LV2"; }
     Processor* create (const juce::String&) override;
+    bool canCreateInBackground() const override { return true; }
     FileSearchPath defaultSearchPath() override;
     juce::StringArray findTypes (const juce::FileSearchPath&, bool, bool) override;
     String nameForURI (const String& uri) const noexcept;
     void scan (const String& URI, OwnedArray<PluginDescription>& out) override;
+    juce::File fileForType (const juce::String& URI) override;
 
 private:
     class LV2;
@@ -207,6 +207,16 @@ public:
     /** Change the mute status of inputs on this Node */
     void setMuteInput (bool);
 
+    /** Returns true if this Node stops processing while its inputs are silent */
+    bool sleepsOnSilence() const { return (bool) getProperty (tags::sleepOnSilence, false); }
+
+    /** Let this Node stop processing while its inputs are silent */
+    void setSleepOnSilence (bool);
+
+    /** Returns render time statistics of this Node's processor. Empty if
+        the Node has no processor. */
+    Processor::RenderStats getRenderStats() const;
+
     //=========================================================================
     /** Returns the number of connections on this node */
     int getNumConnections() const;
@@ -380,11 +390,24 @@ public:
     bool canConnect (const uint32 sourceNode, const uint32 sourcePort, const uint32 destNode, const uint32 destPort) const;
 
     //=========================================================================
-    /** Saves the node state from Processor to state property */
-    void savePluginState();
+    /** Saves the node state from Processor to state property
+
+        @param recursive Pass false to skip the nodes of a graph.
+    */
+    void savePluginState (bool recursive = true);
+
+    /** Decode a state property into a block. State is stored as raw binary
+        once saved, but older sessions and copies made through XML hold it as
+        base64 text, and sessions read from an archive keep it compressed
+        until it's decoded here. Returns false if there is no data. */
+    static bool decodeState (const var& property, MemoryBlock& block);
 
-    /** Reads state property and applies to Processor */
-    void restorePluginState();
+    /** Reads state property and applies to Processor
+
+        @param withStateData Pass false to skip the program and state data,
+                             e.g. when it was already restored elsewhere.
+    */
+    void restorePluginState (bool withStateData = true);
 
     //=========================================================================
     /** Get the number of factory presets */
@@ -490,10 +513,11 @@ public:
     /** Load node data from file */
     static ValueTree parse (const File& file);
 
-    /** Removes properties that can't be saved to a file. e.g. object properties */
+    /** Removes properties that can't be saved to a file. e.g. object properties.
+        State still compressed from a session archive is decoded. */
     static void sanitizeProperties (ValueTree node, const bool recursive = false);
 
-    /** This is just an alias right now */
+    /** Removes runtime objects, but leaves state as it is. */
     static void sanitizeRuntimeProperties (ValueTree node, const bool recursive = false);
 
     /** Create a value tree version of an arc */
@@ -20,6 +20,9 @@ public:
     virtual String format() const = 0;
     /** Create the instance by ID string. */
     virtual Processor* create (const String&) = 0;
+    /** Return true if create() and restoring state on the new instance
+        can happen off the message thread. */
+    virtual bool canCreateInBackground() const { return false; }
     /** return a list of types contained in this provider. */
     virtual StringArray findTypes (const FileSearchPath& path,
                                    bool recursive,
@@ -30,6 +33,10 @@ public:
     virtual FileSearchPath defaultSearchPath() { return {}; }
 
     virtual void scan (const String& fileOrID, OwnedArray<PluginDescription>& out) {}
+
+    /** Return the file a type is loaded from when its ID isn't a path.
+        Scans compare its modification time to tell when the type changed. */
+    virtual File fileForType (const String& ID) { return {}; }
 };
 
 //==========================================================================
@@ -57,6 +57,17 @@ public:
     */
     virtual void setValue (float newValue) = 0;
 
+    /** Schedule a value change at a frame offset within the block about to
+        be rendered.
+
+        This is called on the audio thread before the owning node renders.
+        Parameters that can only change between blocks return false, which is
+        what the default implementation does.
+
+        The value passed will be between 0 and 1.0.
+    */
+    virtual bool setValueAtFrame (float newValue, int frame);
+
     /** This should return the default value for this parameter. */
     virtual float getDefaultValue() const = 0;
 
@@ -170,6 +181,14 @@ public:
     */
     void setValueNotifyingHost (float newValue);
 
+    /** Like setValueNotifyingHost, but applies the value at a frame offset in
+        the next rendered block. Returns false without changing anything if
+        the parameter doesn't support it.
+
+        @see setValueAtFrame
+    */
+    bool setValueNotifyingHostAtFrame (float newValue, int frame);
+
     /** Sends a signal to the host to tell it that the user is about to start changing this
         parameter.
         This allows the host to know when a parameter is actively being held by the user, and
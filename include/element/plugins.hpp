@@ -15,6 +15,7 @@ class Node;
 class NodeFactory;
 class NodeProvider;
 class PluginScannerCoordinator;
+class PluginScanCache;
 class PluginScanner;
 
 class PluginManager : public juce::ChangeBroadcaster {
@@ -38,6 +39,11 @@ public:
     /** Scan/Add a description to the known plugins */
     void addToKnownPlugins (const juce::PluginDescription& desc);
 
+    /** Search the known plugins by name, manufacturer, category and format.
+        Results are ranked best first and limited to maxResults when it is
+        above zero. The index behind this follows the known plugins list. */
+    juce::Array<juce::PluginDescription> searchPlugins (const juce::String& query, int maxResults = 0) const;
+
     /** Returns the audio plugin format manager */
     juce::AudioPluginFormatManager& getAudioPluginFormats();
 
@@ -100,6 +106,19 @@ public:
     juce::AudioPluginInstance* createAudioPlugin (const juce::PluginDescription& desc, juce::String& errorMsg);
     Processor* createGraphNode (const juce::PluginDescription& desc, juce::String& errorMsg);
 
+    /** Returns true if createGraphNode can be called from a background thread
+        for this description. Audio plugin formats always create on the message
+        thread, so this is only true for node providers that allow it. */
+    bool canCreateGraphNodeInBackground (const juce::PluginDescription& desc) const;
+
+    /** Create a graph node without blocking the message thread. Audio plugin
+        formats instantiate with createPluginInstanceAsync, everything else is
+        created right away. The callback is always called on the message
+        thread, with a null node and an error message on failure. The caller
+        owns the node. */
+    void createGraphNodeAsync (const juce::PluginDescription& desc,
+                               std::function<void (Processor*, const juce::String&)> callback);
+
     /** Set the play config used when instantiating plugins */
     void setPlayConfig (double sampleRate, int blockSize);
 
@@ -183,20 +202,27 @@ public:
     /** Set a specific scanner exe. */
     void setScannerExe (const juce::File& exe) { _scannerExe = exe; }
 
+    /** Set how many scanner processes run at the same time. Can't be changed
+        while scanning. */
+    void setNumWorkers (int numWorkers);
+
+    /** Returns the number of scanner processes used. */
+    int getNumWorkers() const noexcept { return numWorkers; }
+
 private:
     friend class PluginScannerCoordinator;
     PluginManager& _manager;
-    std::unique_ptr<PluginScannerCoordinator> superprocess;
+    juce::OwnedArray<PluginScannerCoordinator> workers;
     juce::ListenerList<Listener> listeners;
-    juce::StringArray identifiers, failedIdentifiers;
+    juce::StringArray identifiers, failedIdentifiers, crashedIdentifiers;
     juce::KnownPluginList& list;
+    int numWorkers = 1;
+    juce::WaitableEvent resultReady;
+    std::unique_ptr<PluginScanCache> cache;
     juce::Atomic<int> cancelFlag { 0 };
     juce::File _scannerExe;
 
     void scanAudioFormat (const juce::String& formatName);
-    bool retrieveDescriptions (const juce::String& formatName,
-                               const juce::String& fileOrIdentifier,
-                               juce::OwnedArray<juce::PluginDescription>& result);
 };
 
 } // namespace element
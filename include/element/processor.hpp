@@ -29,6 +29,7 @@ class AtomBuffer;
 class Editor;
 class GraphNode;
 class ProcessBufferOp;
+class RenderProfile;
 
 struct RenderContext {
     juce::AudioSampleBuffer audio;
@@ -136,6 +137,11 @@ public:
     virtual void setPlayHead (AudioPlayHead* playhead) { _playhead = playhead; }
     AudioPlayHead* getPlayHead() const noexcept { return _playhead; }
 
+    /** Tell the node it renders without a realtime deadline, like an offline
+        render. Plugins may switch to higher quality processing. */
+    virtual void setNonRealtime (bool isNonRealtime) noexcept { _nonRealtime = isNonRealtime; }
+    bool isNonRealtime() const noexcept { return _nonRealtime; }
+
     //==========================================================================
     virtual void prepareToRender (double sampleRate, int maxBufferSize) = 0;
     virtual void releaseResources() = 0;
@@ -415,6 +421,51 @@ public:
     void setMuteInput (bool shouldMuteInput) { muteInput.set (shouldMuteInput ? 1 : 0); }
     bool isMutingInputs() const { return muteInput.get() == 1; }
 
+    //==========================================================================
+    /** Let the node stop processing once its inputs have been silent for
+        longer than its tail. It wakes up when audio or MIDI arrives again.
+     */
+    void setSleepOnSilence (bool shouldSleep) { sleepOnSilence.set (shouldSleep ? 1 : 0); }
+    bool sleepsOnSilence() const { return sleepOnSilence.get() == 1; }
+
+    /** Returns true while the node is skipped because its inputs are silent. */
+    bool isSleeping() const { return sleeping.get() == 1; }
+
+    //==========================================================================
+    /** Render time statistics over the most recent blocks. */
+    struct RenderStats
+    {
+        double minMicros = 0.0; ///< Fastest block.
+        double avgMicros = 0.0; ///< Average block.
+        double maxMicros = 0.0; ///< Slowest block.
+        double p99Micros = 0.0; ///< 99th percentile.
+        double budgetPercent = 0.0; ///< Average share of the block duration used.
+        double peakBudgetPercent = 0.0; ///< Highest share of a block duration used.
+        int64 blocks = 0; ///< Blocks recorded since the last reset.
+        int64 dropped = 0; ///< Blocks overwritten before anybody read them.
+    };
+
+    /** Returns render time statistics. Not realtime safe. */
+    RenderStats getRenderStats() const;
+
+    /** Forget the recorded render times. */
+    void resetRenderStats();
+
+    /** Tail to assume for nodes that cannot report one. Long enough for
+        most reverbs and delays to ring out. */
+    static constexpr double unknownTailSeconds = 10.0;
+
+    /** Returns how long the node keeps making sound after its input stops.
+        Uses the audio processor's tail length by default. Called from the
+        render thread, and may be infinite.
+     */
+    virtual double getTailSeconds() const
+    {
+        if (auto* const proc = getAudioProcessor())
+            return proc->getTailLengthSeconds();
+        return 0.0;
+    }
+
     //==========================================================================
     virtual void getState (MemoryBlock&) = 0;
     virtual void setState (const void*, int sizeInBytes) = 0;
@@ -504,6 +555,9 @@ private:
     Atomic<int> bypassed { 0 };
     Atomic<int> mute { 0 };
     Atomic<int> muteInput { 0 };
+    Atomic<int> sleepOnSilence { 0 };
+    Atomic<int> sleeping { 0 };
+    std::unique_ptr<RenderProfile> profile;
 
     double sampleRate = 0.0;
     int blockSize = 0;
@@ -573,6 +627,7 @@ private:
     int delayCompSamples = 0;
 
     juce::AudioPlayHead* _playhead { nullptr };
+    bool _nonRealtime { false };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Processor)
 };
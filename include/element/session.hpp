@@ -100,8 +100,12 @@ public:
     void setActiveGraph (int index);
     bool containsGraph (const Node& graph) const;
 
-    /** Writes an encoded file */
+    /** Writes a chunked session archive. Saving over an existing archive
+        only writes the chunks that changed. */
     bool writeToFile (const File&) const;
+
+    /** Reads a session archive or an older gzipped session. Returns an
+        invalid tree if the file is neither. */
     static ValueTree readFromFile (const File&);
 
     Value getActiveGraphIndexObject (bool syncUpdate = false) const
@@ -50,6 +50,8 @@ public:
     static const char* updateKeyKey;
     static const char* updateKeyUserKey;
     static const char* transportStartStopContinue;
+    static const char* renderThreadsKey;
+    static const char* autosaveIntervalKey;
 
     bool getBool (std::string_view key, bool fallback = false) const noexcept;
 
@@ -162,6 +164,16 @@ public:
     void setTransportRespondToStartStopContinue (bool shouldRespond);
     bool transportRespondToStartStopContinue() const;
 
+    /** Returns the number of extra threads used to render graphs in parallel.
+        Zero means graphs render on the audio thread only. */
+    int getRenderThreads() const;
+    void setRenderThreads (int numThreads);
+
+    /** Returns the minutes between background saves of a changed session.
+        Zero means autosave is off. */
+    int getAutosaveInterval() const;
+    void setAutosaveInterval (int minutes);
+
 private:
     juce::PropertiesFile* getProps() const;
 };
@@ -4,13 +4,20 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 
 #include <element/juce/audio_processors.hpp>
 #include <element/timescale.hpp>
 
 namespace element {
 
-/** A mini-transport for use in a processable that can loop */
+/** A mini-transport for use in a processable that can loop.
+
+    Positions follow the tempo map in getTimeScale(), so beat positions
+    stay exact across tempo and meter changes. Callers that render in
+    blocks should split them with getFramesUntilChange() to see every
+    change on the frame it happens.
+ */
 class Shuttle : public juce::AudioPlayHead {
 public:
     static const int PPQ;
@@ -47,10 +54,22 @@ public:
 
     int64_t getRemainingFrames() const;
 
+    /** Returns the number of frames from the current position to the next
+        tempo/meter node or loop point, but no more than maxFrames. */
+    int getFramesUntilChange (int maxFrames) const;
+
+    /** Convert between frames and quarter note beats using the tempo map. */
+    double beatsFromFrame (int64_t frame) const;
+    int64_t frameFromBeats (double beats) const;
+
     void resetRecording();
 
     const TimeScale& getTimeScale() const;
+
+    /** Returns the tempo at the current position. */
     float getTempo() const;
+
+    /** Set the tempo of the first node in the tempo map. */
     void setTempo (float bpm);
 
     double getSampleRate() const;
@@ -60,14 +79,22 @@ public:
     inline void seekAudioFrame (int64_t frame)
     {
         framePos = frame;
+        locate();
     }
 
     juce::Optional<juce::AudioPlayHead::PositionInfo> getPosition() const override;
 
 protected:
-    TimeScale ts;
+    std::unique_ptr<TimeScale> ts;
     bool playing, recording, looping;
 
+    /** Find the tempo map node at the current position. Call after the
+        map changes. */
+    void locate();
+
+    /** Replace the tempo map and return the old one. Doesn't allocate. */
+    TimeScale* exchangeTimeScale (TimeScale* newScale);
+
 private:
     double framesPerBeat;
     double beatsPerFrame;
@@ -76,6 +103,13 @@ private:
     uint32_t duration;
     double sampleRate;
 
+    // the map node at framePos and the beat position where it starts.
+    const TimeScale::Node* segment = nullptr;
+    double segmentBeats = 0.0;
+
+    void updateSegmentRate();
+    void stepSegments();
+
     [[maybe_unused]] double ppqLoopStart;
     [[maybe_unused]] double ppqLoopEnd;
 };
@@ -119,6 +119,7 @@ static const juce::Identifier port = "port";
 static const juce::Identifier ports = "ports";
 static const juce::Identifier preset = "preset";
 static const juce::Identifier program = "program";
+static const juce::Identifier sleepOnSilence = "sleepOnSilence";
 static const juce::Identifier sourceNode = "sourceNode";
 static const juce::Identifier sourcePort = "sourcePort";
 static const juce::Identifier sourceChannel = "sourceChannel";
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 
 #include <element/atomic.hpp>
@@ -24,6 +25,7 @@ public:
         juce::Atomic<bool> playing;
         juce::Atomic<bool> recording;
         juce::Atomic<int64_t> positionFrames;
+        juce::Atomic<double> positionBeats;
 
         double beatRatio() const noexcept;
         double getPositionSeconds() const;
@@ -57,6 +59,10 @@ public:
     }
     void requestMeter (int beatsPerBar, int beatType);
 
+    /** Replace the tempo map. Call from the message thread, the new map
+        takes over at the start of the next block. */
+    void requestTempoMap (const TimeScale& map);
+
     void requestAudioFrame (const int64_t frame);
 
     void preProcess (int nframes);
@@ -71,6 +77,13 @@ private:
     juce::Atomic<bool> seekWanted;
     AtomicValue<int64_t> seekFrame;
     MonitorPtr monitor;
+
+    // maps go to the audio thread through nextMap and come back through
+    // the retired fifo to be deleted on the message thread.
+    std::atomic<TimeScale*> nextMap { nullptr };
+    juce::AbstractFifo retiredFifo { 8 };
+    TimeScale* retired[8] {};
+    void reclaimTempoMaps();
 };
 
 } // namespace element
@@ -0,0 +1,78 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+/// The audio engine.
+// Transport control for the running engine. Get one with `Context:audio()`.
+// @classmod el.AudioEngine
+// @pragma nostrip
+
+#include <element/element.h>
+#include <element/audioengine.hpp>
+#include <element/timescale.hpp>
+
+#include "sol_helpers.hpp"
+
+// clang-format off
+EL_PLUGIN_EXPORT
+int luaopen_el_AudioEngine (lua_State* L)
+{
+    using namespace element;
+
+    sol::state_view lua (L);
+    auto M = lua.create_table();
+    M.new_usertype<AudioEngine> ("AudioEngine", sol::no_constructor,
+        sol::meta_function::to_string, [](AudioEngine& self) { return lua::to_string (self, "AudioEngine"); },
+
+        /// Set the transport's tempo map.
+        // Each change is a table with fields: bar (1 based), tempo,
+        // beatsPerBar and beatDivisor. Missing fields keep the value of the
+        // change before them. The first change always starts at bar 1.
+        // @function AudioEngine:setTempoMap
+        // @tparam table changes Array of tempo and meter changes
+        "setTempoMap", [](AudioEngine& self, sol::table changes) {
+            TimeScale map;
+            map.setSampleRate ((unsigned int) self.getTransportMonitor()->sampleRate.get());
+
+            float tempo = 120.f;
+            int beatsPerBar = 4, beatDivisor = 2;
+            for (size_t i = 1; i <= changes.size(); ++i)
+            {
+                sol::table change = changes[i];
+                tempo = juce::jlimit (20.f, 999.f, change.get_or ("tempo", tempo));
+                beatsPerBar = juce::jlimit (1, 99, change.get_or ("beatsPerBar", beatsPerBar));
+                beatDivisor = juce::jlimit (0, 4, change.get_or ("beatDivisor", beatDivisor));
+
+                if (i == 1)
+                {
+                    map.setTempo (tempo);
+                    map.setBeatsPerBar ((unsigned short) beatsPerBar);
+                    map.setBeatDivisor ((unsigned short) beatDivisor);
+                    map.updateScale();
+                    continue;
+                }
+
+                const int bar = juce::jmax (1, change.get_or ("bar", 1));
+                map.addNode (map.frameFromBar ((unsigned short) (bar - 1)), tempo, 2,
+                             (unsigned short) beatsPerBar, (unsigned short) beatDivisor);
+                map.updateScale();
+            }
+
+            self.setTempoMap (map);
+        },
+
+        /// Start or stop the transport.
+        // @function AudioEngine:setPlaying
+        // @bool playing True to play
+        "setPlaying", &AudioEngine::setPlaying,
+
+        /// Set the transport's time signature.
+        // @function AudioEngine:setMeter
+        // @int beatsPerBar Time signature numerator
+        // @int beatDivisor Time signature denominator as a power of two
+        "setMeter", &AudioEngine::setMeter
+    );
+
+    sol::stack::push (L, element::lua::removeAndClear (M, "AudioEngine"));
+    return 1;
+}
+// clang-format on
@@ -49,7 +49,12 @@ EL_PLUGIN_EXPORT int luaopen_el_Context (lua_State* L)
         // @within Instance Methods
         "session",  &Context::session,
 
+        /// Returns the el.AudioEngine.
+        // @function Context:audio
+        // @treturn el.AudioEngine
+        // @within Instance Methods
         "audio",    &Context::audio,
+
         "devices",  &Context::devices,
         "mapping",  &Context::mapping,
         "midi",     &Context::midi,
@@ -58,7 +63,9 @@ EL_PLUGIN_EXPORT int luaopen_el_Context (lua_State* L)
         "settings", &Context::settings);
 
     lua.script (R"(
+        require ('el.AudioEngine')
         require ('el.Node')
+        require ('el.PluginManager')
         require ('el.Session')
     )");
 
@@ -23,7 +23,27 @@ EL_PLUGIN_EXPORT int luaopen_el_Node (lua_State* L)
         // @function Node:hasEditor
         // @within Methods
         // @return bool True if yes.
-        "hasEditor", &Node::hasEditor
+        "hasEditor", &Node::hasEditor,
+
+        /// Returns render time statistics over the most recent blocks.
+        // Times are in microseconds. `budget` and `peakbudget` are the
+        // average and highest percentage of the block duration used.
+        // @function Node:renderStats
+        // @within Methods
+        // @treturn table Fields: min, avg, max, p99, budget, peakbudget, blocks, dropped
+        "renderStats", [](Node& self, sol::this_state L) {
+            const auto stats = self.getRenderStats();
+            auto t = sol::state_view (L).create_table();
+            t["min"] = stats.minMicros;
+            t["avg"] = stats.avgMicros;
+            t["max"] = stats.maxMicros;
+            t["p99"] = stats.p99Micros;
+            t["budget"] = stats.budgetPercent;
+            t["peakbudget"] = stats.peakBudgetPercent;
+            t["blocks"] = static_cast<lua_Integer> (stats.blocks);
+            t["dropped"] = static_cast<lua_Integer> (stats.dropped);
+            return t;
+        }
     );
 
     sol::stack::push (L, M);
@@ -0,0 +1,52 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+/// The plugin manager.
+// Known plugins and plugin search. Get one with `Context:plugins()`.
+// @classmod el.PluginManager
+// @pragma nostrip
+
+#include <element/element.h>
+#include <element/plugins.hpp>
+
+#include "sol_helpers.hpp"
+
+// clang-format off
+EL_PLUGIN_EXPORT
+int luaopen_el_PluginManager (lua_State* L)
+{
+    using namespace element;
+
+    sol::state_view lua (L);
+    auto M = lua.create_table();
+    M.new_usertype<PluginManager> ("PluginManager", sol::no_constructor,
+        sol::meta_function::to_string, [](PluginManager& self) { return lua::to_string (self, "PluginManager"); },
+
+        /// Search the known plugins.
+        // Matches name, manufacturer, category and format, tolerating small
+        // typos. Results are ranked best first.
+        // @function PluginManager:search
+        // @string query Text to search for
+        // @int[opt] limit Maximum number of results
+        // @treturn table Array of tables with fields: name, manufacturer, category, format, identifier
+        "search", [](PluginManager& self, const char* query, sol::optional<int> limit, sol::this_state L) {
+            auto results = sol::state_view (L).create_table();
+            int index = 0;
+            for (const auto& desc : self.searchPlugins (juce::String::fromUTF8 (query), limit.value_or (0)))
+            {
+                auto t = sol::state_view (L).create_table();
+                t["name"] = desc.name.toStdString();
+                t["manufacturer"] = desc.manufacturerName.toStdString();
+                t["category"] = desc.category.toStdString();
+                t["format"] = desc.pluginFormatName.toStdString();
+                t["identifier"] = desc.createIdentifierString().toStdString();
+                results[++index] = t;
+            }
+            return results;
+        }
+    );
+
+    sol::stack::push (L, element::lua::removeAndClear (M, "PluginManager"));
+    return 1;
+}
+// clang-format on
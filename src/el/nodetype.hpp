@@ -104,11 +104,11 @@ inline static sol::table new_nodetype (lua_State* L, const char* name, Args&&...
 
         /// Save state.
         // @function Node:saveState
-        "saveState",    &Node::savePluginState,
+        "saveState",    [] (Node& self) { self.savePluginState(); },
 
         /// Restore state.
         // @function Node:restoreState
-        "restoreState", &Node::restorePluginState,
+        "restoreState", [] (Node& self) { self.restorePluginState(); },
 
         "missing",     &Node::isMissing,
         
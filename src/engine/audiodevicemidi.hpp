@@ -0,0 +1,32 @@
+// Copyright 2024 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/audio_basics.hpp>
+
+namespace element {
+
+/** Implemented by audio devices that carry MIDI in their own process
+    callback, like JACK.
+
+    The engine reads and writes these from inside the device's audio
+    callback, so events keep their frame offsets instead of going through
+    the MIDI input collector and the MIDI output sender thread.
+ */
+class AudioDeviceMidi
+{
+public:
+    virtual ~AudioDeviceMidi() = default;
+
+    /** Returns MIDI received for the current block (audio thread). */
+    virtual const juce::MidiBuffer& getIncomingMidi() const noexcept = 0;
+
+    /** Returns true if outgoing MIDI has somewhere to go. */
+    virtual bool wantsOutgoingMidi() const noexcept = 0;
+
+    /** Queue MIDI to send with the current block (audio thread). */
+    virtual void addOutgoingMidi (const juce::MidiBuffer& midi, int numSamples) noexcept = 0;
+};
+
+} // namespace element
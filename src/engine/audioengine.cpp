@@ -1,18 +1,24 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <thread>
+
 #include <element/audioengine.hpp>
+#include <element/juce/audio_formats.hpp>
 #include <element/transport.hpp>
 #include <element/context.hpp>
 #include <element/settings.hpp>
 
+#include "engine/audiodevicemidi.hpp"
 #include "engine/internalformat.hpp"
+#include "engine/mappingengine.hpp"
 #include "engine/midiclock.hpp"
 #include "engine/midichannelmap.hpp"
 #include "engine/midiengine.hpp"
 #include "engine/miditranspose.hpp"
 #include "engine/rootgraph.hpp"
 #include "engine/midipanic.hpp"
+#include "engine/renderpool.hpp"
 #include "engine/trace.hpp"
 
 #include "tempo.hpp"
@@ -26,8 +32,13 @@ struct RootGraphRender : public AsyncUpdater
     RootGraphRender()
     {
         graphs.ensureStorageAllocated (32);
+        slots.ensureStorageAllocated (32);
+        concurrent.ensureStorageAllocated (32);
     }
 
+    /** Set the pool used to render parallel graphs concurrently. */
+    void setRenderPool (RenderPool* newPool) noexcept { pool = newPool; }
+
     void handleAsyncUpdate() override
     {
         if (onActiveGraphChanged)
@@ -57,17 +68,23 @@ struct RootGraphRender : public AsyncUpdater
     {
         numInputChans = numIns;
         numOutputChans = numOuts;
-        audioTemp.setSize (jmax (numIns, numOuts), numSamples);
-        audioOut.setSize (audioTemp.getNumChannels(), audioTemp.getNumSamples());
+        blockSize = numSamples;
+        audioOut.setSize (jmax (numIns, numOuts), numSamples);
+        for (auto* slot : slots)
+            slot->audio.setSize (audioOut.getNumChannels(), audioOut.getNumSamples());
     }
 
     void releaseBuffers()
     {
         numInputChans = numOutputChans = 0;
+        blockSize = 0;
         midiOut.clear();
-        midiTemp.clear();
-        audioTemp.setSize (1, 1);
         audioOut.setSize (1, 1);
+        for (auto* slot : slots)
+        {
+            slot->midi.clear();
+            slot->audio.setSize (1, 1);
+        }
     }
 
     void dumpGraphs()
@@ -104,15 +121,21 @@ struct RootGraphRender : public AsyncUpdater
         if (shouldProcess)
         {
             audioOut.setSize (numChans, numSamples, false, false, true);
-            audioTemp.setSize (numChans, numSamples, false, false, true);
 
             // clear the mixing area
             for (int i = numChans; --i >= 0;)
                 audioOut.clear (i, 0, numSamples);
             midiOut.clear();
 
-            for (auto* const graph : graphs)
+            concurrent.clearQuick();
+
+            for (auto* const slot : slots)
             {
+                auto* const graph = slot->graph;
+                auto& audioTemp = slot->audio;
+                auto& midiTemp = slot->midi;
+                audioTemp.setSize (numChans, numSamples, false, false, true);
+
                 // copy inputs, clear outs if more than input count
                 for (int i = 0; i < numInputChans; ++i)
                     audioTemp.copyFrom (i, 0, buffer, i, 0, numSamples);
@@ -147,18 +170,24 @@ struct RootGraphRender : public AsyncUpdater
                     midiTemp.addEvents (midi, 0, numSamples, 0);
                 }
 
-                {
-                    RenderContext rc (audioTemp, cvTemp, midiTemp, atomTemp, numSamples);
-                    const ScopedLock sl (graph->getPropertyLock());
-                    if (graph->isSuspended())
-                    {
-                        graph->renderBypassed (rc);
-                    }
-                    else
-                    {
-                        graph->render (rc);
-                    }
-                }
+                if (graph->isSingle())
+                    renderGraph (*slot, numSamples);
+                else
+                    concurrent.add (slot);
+            }
+
+            // parallel graphs don't depend on each other, so when there is more
+            // than one they are spread across the render pool.
+            renderJob.reset (pool, concurrent, numSamples);
+            if (concurrent.size() < 2 || pool == nullptr || ! pool->run (renderJob))
+                renderJob.perform();
+
+            // mix in graph order so the result matches a serial render exactly
+            for (auto* const slot : slots)
+            {
+                auto* const graph = slot->graph;
+                const auto& audioTemp = slot->audio;
+                const auto& midiTemp = slot->midi;
 
                 // clang-format off
                 if (graphChanged && ((current->isSingle() && graph == last) || 
@@ -217,12 +246,60 @@ struct RootGraphRender : public AsyncUpdater
         lastGraph = currentGraph;
     }
 
+    /** Render every graph on its own, in parallel when there is a pool.
+        Graph switching and fades don't apply. Renders numFrames of the input
+        starting at offset, so a block can be split where the transport
+        changes. The results are collected in each graph's stem buffer, see
+        getRenderedAudio().
+     */
+    void renderStems (const AudioSampleBuffer& input, const MidiBuffer& midi, const int offset, const int numFrames)
+    {
+        const int numSamples = input.getNumSamples();
+        const int numChans = input.getNumChannels();
+        const int numIns = jmin (numInputChans, numChans);
+
+        concurrent.clearQuick();
+        for (auto* const slot : slots)
+        {
+            if (offset == 0)
+                slot->stem.setSize (numChans, numSamples, false, false, true);
+
+            slot->audio.setSize (numChans, numFrames, false, false, true);
+            for (int i = 0; i < numIns; ++i)
+                slot->audio.copyFrom (i, 0, input, i, offset, numFrames);
+            for (int i = numIns; i < numChans; ++i)
+                slot->audio.clear (i, 0, numFrames);
+
+            slot->midi.clear();
+            slot->midi.addEvents (midi, offset, numFrames, -offset);
+            concurrent.add (slot);
+        }
+
+        renderJob.reset (pool, concurrent, numFrames);
+        if (concurrent.size() < 2 || pool == nullptr || ! pool->run (renderJob))
+            renderJob.perform();
+
+        for (auto* const slot : slots)
+            for (int i = 0; i < numChans; ++i)
+                slot->stem.copyFrom (i, offset, slot->audio, i, 0, numFrames);
+    }
+
+    /** Returns the audio a graph rendered in the last stems block. */
+    const AudioSampleBuffer& getRenderedAudio (const int index) const
+    {
+        return slots.getUnchecked (index)->stem;
+    }
+
     /** not realtime safe! */
     bool addGraph (RootGraph* graph)
     {
         graphs.add (graph);
         graph->engineIndex = graphs.size() - 1;
 
+        auto slot = slots.add (new GraphSlot (graph));
+        slot->audio.setSize (jmax (1, numInputChans, numOutputChans), jmax (1, blockSize));
+        concurrent.ensureStorageAllocated (slots.size());
+
         if (graph->engineIndex == 0)
         {
             setCurrentGraph (0);
@@ -237,6 +314,9 @@ struct RootGraphRender : public AsyncUpdater
     {
         jassert (graphs.contains (graph));
         graphs.removeFirstMatchingValue (graph);
+        for (int i = slots.size(); --i >= 0;)
+            if (slots.getUnchecked (i)->graph == graph)
+                slots.remove (i);
         graph->engineIndex = -1;
         updateIndexes();
         if (currentGraph >= graphs.size())
@@ -251,7 +331,58 @@ struct RootGraphRender : public AsyncUpdater
     const Array<RootGraph*>& getGraphs() const { return graphs; }
 
 private:
+    /** Scratch buffers a single graph renders into. Each graph gets its own so
+        several can render at the same time. */
+    struct GraphSlot
+    {
+        explicit GraphSlot (RootGraph* g) : graph (g) {}
+        RootGraph* const graph;
+        AudioSampleBuffer audio, cv, stem;
+        MidiBuffer midi;
+        AtomBuffer atom;
+    };
+
+    /** Renders a list of graph slots, each one claimed by whichever thread
+        gets to it first. */
+    struct RenderJob final : public RenderPool::Job
+    {
+        void reset (RenderPool* newPool, const Array<GraphSlot*>& newSlots, int newNumSamples) noexcept
+        {
+            pool = newPool;
+            items = newSlots.begin();
+            numItems = newSlots.size();
+            numSamples = newNumSamples;
+            next.store (0, std::memory_order_release);
+            done.store (0, std::memory_order_release);
+        }
+
+        void perform() noexcept override
+        {
+            int index;
+            while ((index = next.fetch_add (1, std::memory_order_acq_rel)) < numItems)
+            {
+                renderGraph (*items[index], numSamples);
+                done.fetch_add (1, std::memory_order_release);
+            }
+
+            // help nodes still rendering that fan work out to the pool.
+            while (done.load (std::memory_order_acquire) < numItems)
+                if (pool == nullptr || ! pool->helpWithTasks())
+                    std::this_thread::yield();
+        }
+
+        RenderPool* pool = nullptr;
+        GraphSlot* const* items = nullptr;
+        int numItems = 0;
+        int numSamples = 0;
+        std::atomic<int> next { 0 }, done { 0 };
+    };
+
     Array<RootGraph*> graphs;
+    OwnedArray<GraphSlot> slots;
+    Array<GraphSlot*> concurrent;
+    RenderJob renderJob;
+    RenderPool* pool = nullptr;
     int currentGraph = -1;
     int lastGraph = -1;
 
@@ -270,9 +401,24 @@ private:
 
     int numInputChans = -1;
     int numOutputChans = -1;
-    AudioSampleBuffer audioOut, audioTemp, cvTemp;
-    MidiBuffer midiOut, midiTemp;
-    AtomBuffer atomTemp;
+    int blockSize = 0;
+    AudioSampleBuffer audioOut;
+    MidiBuffer midiOut;
+
+    static void renderGraph (GraphSlot& slot, int numSamples) noexcept
+    {
+        auto* const graph = slot.graph;
+        RenderContext rc (slot.audio, slot.cv, slot.midi, slot.atom, numSamples);
+        const ScopedLock sl (graph->getPropertyLock());
+        if (graph->isSuspended())
+        {
+            graph->renderBypassed (rc);
+        }
+        else
+        {
+            graph->render (rc);
+        }
+    }
 
     void updateIndexes()
     {
@@ -296,6 +442,64 @@ private:
     }
 };
 
+//==============================================================================
+namespace detail {
+
+/** Reads every track of a MIDI file into one sequence timed in seconds. */
+static Result readMidiFile (const File& file, MidiMessageSequence& sequence)
+{
+    FileInputStream stream (file);
+    MidiFile midiFile;
+    if (! stream.openedOk() || ! midiFile.readFrom (stream))
+        return Result::fail ("Could not read MIDI file: " + file.getFullPathName());
+
+    midiFile.convertTimestampTicksToSeconds();
+    for (int i = 0; i < midiFile.getNumTracks(); ++i)
+        sequence.addSequence (*midiFile.getTrack (i), 0.0);
+
+    // tempo and other meta events were used for timing, graphs can't use them.
+    for (int i = sequence.getNumEvents(); --i >= 0;)
+        if (sequence.getEventPointer (i)->message.isMetaEvent())
+            sequence.deleteEvent (i, false);
+
+    return Result::ok();
+}
+
+static std::unique_ptr<AudioFormatWriter> createRenderWriter (const File& file, double sampleRate, int numChannels, int bitDepth, String& error)
+{
+    std::unique_ptr<AudioFormat> format;
+    if (file.hasFileExtension ("wav"))
+        format = std::make_unique<WavAudioFormat>();
+    else if (file.hasFileExtension ("flac"))
+        format = std::make_unique<FlacAudioFormat>();
+
+    if (format == nullptr)
+    {
+        error = "Can only render to .wav or .flac files: " + file.getFileName();
+        return nullptr;
+    }
+
+    file.getParentDirectory().createDirectory();
+    file.deleteFile();
+    auto stream = file.createOutputStream();
+    if (stream == nullptr)
+    {
+        error = "Could not open for writing: " + file.getFullPathName();
+        return nullptr;
+    }
+
+    std::unique_ptr<AudioFormatWriter> writer (format->createWriterFor (
+        stream.get(), sampleRate, (unsigned int) numChannels, bitDepth, {}, 0));
+    if (writer == nullptr)
+        error = String ("Unsupported format: ") << bitDepth << " bit " << format->getFormatName();
+    else
+        stream.release(); // owned by the writer now
+
+    return writer;
+}
+
+} // namespace detail
+
 class AudioEngine::Private : public AudioIODeviceCallback,
                              public MidiInputCallback,
                              public Value::Listener,
@@ -319,6 +523,7 @@ public:
         sessionWantsExternalClock.set (0);
         midiClock.addListener (this);
         graphs.onActiveGraphChanged = std::bind (&AudioEngine::Private::onCurrentGraphChanged, this);
+        graphs.setRenderPool (&renderPool);
         midiIOMonitor = new MidiIOMonitor();
         startTimerHz (90);
     }
@@ -424,8 +629,28 @@ public:
 
         AudioSampleBuffer buffer (channels, totalNumChans, numSamples);
         tempMidi.clear();
+        if (deviceMidi != nullptr)
+        {
+            // device MIDI is already on this block's timeline.
+            const auto& incoming = deviceMidi->getIncomingMidi();
+            if (! incoming.isEmpty())
+            {
+                midiIOMonitor->received();
+                tempMidi.addEvents (incoming, 0, numSamples, 0);
+            }
+        }
+
         processCurrentGraph (buffer, tempMidi);
 
+        if (deviceMidi != nullptr && deviceMidi->wantsOutgoingMidi())
+        {
+            if (! tempMidi.isEmpty())
+            {
+                midiIOMonitor->sent();
+                deviceMidi->addOutgoingMidi (tempMidi, numSamples);
+            }
+        }
+        else
         {
             ScopedLock lockMidiOut (engine.world.midi().getMidiOutputLock());
             if (auto* const midiOut = engine.world.midi().getDefaultMidiOutput())
@@ -463,6 +688,7 @@ public:
         const ScopedLock sl (lock);
         const bool wasPlaying = transport.isPlaying();
         transport.preProcess (numSamples);
+        const auto startFrame = transport.getPositionFrames();
 
         const bool generateClock = generateMidiClock.get() == 1;
         const bool clockToInput = sendMidiClockToInput.get() == 1;
@@ -494,7 +720,7 @@ public:
         {
             graphs.setCurrentGraph (nextGraph);
         }
-        graphs.renderGraphs (buffer, midi); // user requested index can be cancelled by program changed
+        renderSegments (buffer, midi); // user requested index can be cancelled by program changed
         if (nextGraph != graphs.getCurrentGraphIndex())
         {
             currentGraph.set (graphs.getCurrentGraphIndex());
@@ -507,7 +733,7 @@ public:
             {
                 if (transport.isPlaying())
                 {
-                    midi.addEvent (transport.getPositionFrames() <= 0
+                    midi.addEvent (startFrame <= 0
                                        ? MidiMessage::midiStart()
                                        : MidiMessage::midiContinue(),
                                    0);
@@ -522,12 +748,184 @@ public:
             midiClockMaster.render (midi, numSamples);
         }
 
-        if (transport.isPlaying())
-            transport.advance (numSamples);
+        transport.postProcess (numSamples);
+    }
+
+    /** Render the graphs and advance the transport. While playing, the block
+        is split where the tempo map or loop changes so every node sees an
+        exact playhead for each piece. Mapped controllers are applied to the
+        piece they land in.
+     */
+    void renderSegments (AudioSampleBuffer& buffer, MidiBuffer& midi)
+    {
+        const int numSamples = buffer.getNumSamples();
+        auto& mapping = engine.world.mapping();
+        if (! transport.isPlaying() || transport.getFramesUntilChange (numSamples) >= numSamples)
+        {
+            mapping.render (numSamples);
+            graphs.renderGraphs (buffer, midi);
+            if (transport.isPlaying())
+                transport.advance (numSamples);
+            return;
+        }
+
+        segmentMidiOut.clear();
+        int offset = 0;
+        while (offset < numSamples)
+        {
+            const int numFrames = transport.getFramesUntilChange (numSamples - offset);
+            AudioSampleBuffer segment (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), offset, numFrames);
+            segmentMidi.clear();
+            segmentMidi.addEvents (midi, offset, numFrames, -offset);
+            // mapped controllers land in the piece they belong to.
+            mapping.render (offset, numFrames, numSamples);
+            graphs.renderGraphs (segment, segmentMidi);
+            segmentMidiOut.addEvents (segmentMidi, 0, numFrames, offset);
+            transport.advance (numFrames);
+            offset += numFrames;
+        }
+
+        midi.swapWith (segmentMidiOut);
+    }
+
+    /** Like processCurrentGraph, but renders each graph separately. */
+    void processStems (const AudioBuffer<float>& input, const MidiBuffer& midi)
+    {
+        const int numSamples = input.getNumSamples();
+        const ScopedLock sl (lock);
+        transport.preProcess (numSamples);
+
+        // split at tempo, meter and loop changes the same as renderSegments.
+        auto& mapping = engine.world.mapping();
+        int offset = 0;
+        while (offset < numSamples)
+        {
+            const int numFrames = transport.isPlaying() ? transport.getFramesUntilChange (numSamples - offset)
+                                                        : numSamples - offset;
+            mapping.render (offset, numFrames, numSamples);
+            graphs.renderStems (input, midi, offset, numFrames);
+            if (transport.isPlaying())
+                transport.advance (numFrames);
+            offset += numFrames;
+        }
 
         transport.postProcess (numSamples);
     }
 
+    Result renderOffline (const AudioEngine::OfflineRender& options)
+    {
+        if (isPrepared)
+            return Result::fail ("The engine is running on a device");
+        if (options.sampleRate <= 0.0 || options.blockSize <= 0 || options.numChannels <= 0)
+            return Result::fail ("Invalid render settings");
+
+        MidiMessageSequence sequence;
+        double lengthSeconds = options.lengthSeconds;
+        if (options.midiInput != File())
+        {
+            auto result = detail::readMidiFile (options.midiInput, sequence);
+            if (result.failed())
+                return result;
+            if (lengthSeconds <= 0.0)
+                lengthSeconds = sequence.getEndTime();
+        }
+
+        if (lengthSeconds <= 0.0)
+            return Result::fail ("Nothing to render, set a length or a MIDI file");
+
+        const int numGraphs = graphs.size();
+        if (options.stems && numGraphs <= 0)
+            return Result::fail ("The session has no graphs");
+
+        String error;
+        OwnedArray<AudioFormatWriter> writers;
+        if (options.stems)
+        {
+            const auto& out = options.output;
+            for (int i = 0; i < numGraphs && error.isEmpty(); ++i)
+            {
+                // engine graphs are in the same order as the session's.
+                auto name = session != nullptr ? session->getGraph (i).getName() : String();
+                if (name.isEmpty())
+                    name = "Graph";
+                name = File::createLegalFileName (name);
+                const auto file = out.getSiblingFile (out.getFileNameWithoutExtension()
+                                                      + " - " + String (i + 1) + " " + name
+                                                      + out.getFileExtension());
+                writers.add (detail::createRenderWriter (file, options.sampleRate, options.numChannels, options.bitDepth, error).release());
+            }
+        }
+        else
+        {
+            writers.add (detail::createRenderWriter (options.output, options.sampleRate, options.numChannels, options.bitDepth, error).release());
+        }
+
+        if (error.isNotEmpty())
+            return Result::fail (error);
+
+        const double sampleRate = options.sampleRate;
+        const int blockSize = options.blockSize;
+        const auto totalFrames = (int64) std::ceil ((lengthSeconds + jmax (0.0, options.tailSeconds)) * sampleRate);
+
+        // without a deadline, plugins may trade speed for quality.
+        setGraphsNonRealtime (true);
+        audioAboutToStart (sampleRate, blockSize, 0, options.numChannels);
+        if (session != nullptr && (double) tempoValue.getValue() > 0.0)
+            transport.requestTempo ((float) tempoValue.getValue());
+        transport.requestAudioFrame (0);
+        transport.requestPlayState (true);
+
+        AudioSampleBuffer buffer (options.numChannels, blockSize);
+        MidiBuffer midi;
+        midi.ensureSize (4096);
+        int nextEvent = 0;
+        int64 frame = 0;
+
+        while (frame < totalFrames)
+        {
+            const int numSamples = (int) jmin ((int64) blockSize, totalFrames - frame);
+            buffer.setSize (options.numChannels, numSamples, false, false, true);
+            buffer.clear();
+
+            midi.clear();
+            for (; nextEvent < sequence.getNumEvents(); ++nextEvent)
+            {
+                const auto& msg = sequence.getEventPointer (nextEvent)->message;
+                const auto eventFrame = (int64) std::llround (msg.getTimeStamp() * sampleRate);
+                if (eventFrame >= frame + numSamples)
+                    break;
+                midi.addEvent (msg, (int) jmax ((int64) 0, eventFrame - frame));
+            }
+
+            if (options.stems)
+            {
+                processStems (buffer, midi);
+                for (int i = 0; i < numGraphs; ++i)
+                    writers.getUnchecked (i)->writeFromAudioSampleBuffer (graphs.getRenderedAudio (i), 0, numSamples);
+            }
+            else
+            {
+                processCurrentGraph (buffer, midi);
+                writers.getUnchecked (0)->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+            }
+
+            frame += numSamples;
+            if (options.progress && ! options.progress ((double) frame / (double) totalFrames))
+            {
+                error = "Render cancelled";
+                break;
+            }
+        }
+
+        transport.requestPlayState (false);
+        transport.requestAudioFrame (0);
+        audioStopped();
+        setGraphsNonRealtime (false);
+        writers.clear();
+
+        return error.isEmpty() ? Result::ok() : Result::fail (error);
+    }
+
     bool isTimeMaster() const
     {
         if (engine.getRunMode() == RunMode::Plugin)
@@ -541,6 +939,7 @@ public:
         const int newBlockSize = device->getCurrentBufferSizeSamples();
         const int numChansIn = device->getActiveInputChannels().countNumberOfSetBits();
         const int numChansOut = device->getActiveOutputChannels().countNumberOfSetBits();
+        deviceMidi = dynamic_cast<AudioDeviceMidi*> (device);
         audioAboutToStart (newSampleRate, newBlockSize, numChansIn, numChansOut);
     }
 
@@ -557,6 +956,8 @@ public:
         messageCollector.reset (sampleRate);
         keyboardState.addListener (&messageCollector);
         channels.calloc ((size_t) jmax (numChansIn, numChansOut) + 2);
+        segmentMidi.ensureSize (4096);
+        segmentMidiOut.ensureSize (4096);
 
         graphs.prepareBuffers (numInputChans, numOutputChans, blockSize);
 
@@ -572,18 +973,21 @@ public:
         }
 
         prepareToPlay (sampleRate, blockSize);
+        engine.world.mapping().prepareToRender (sampleRate, blockSize);
         isPrepared = true;
     }
 
     void audioDeviceStopped() override
     {
         audioStopped();
+        deviceMidi = nullptr;
     }
 
     void audioStopped()
     {
         const ScopedLock sl (lock);
         keyboardState.removeListener (&messageCollector);
+        engine.world.mapping().releaseResources();
         if (isPrepared)
             releaseResources();
         isPrepared = false;
@@ -736,6 +1140,7 @@ private:
     HeapBlock<float*> channels;
     AudioSampleBuffer tempBuffer;
     MidiBuffer tempMidi, extraMidi;
+    MidiBuffer segmentMidi, segmentMidiOut;
     MidiMessageCollector messageCollector;
     MidiKeyboardState keyboardState;
 
@@ -759,11 +1164,20 @@ private:
     int latencySamples = 0;
 
     MidiIOMonitorPtr midiIOMonitor;
+    AudioDeviceMidi* deviceMidi = nullptr;
 
     Atomic<double> midiOutLatency { 0.0 };
 
     ReferenceCountedArray<AudioEngine::LevelMeter> inMeters, outMeters;
 
+    RenderPool renderPool;
+
+    void setGraphsNonRealtime (bool nonRealtime)
+    {
+        for (auto* graph : graphs.getGraphs())
+            graph->setNonRealtime (nonRealtime);
+    }
+
     void prepareGraph (RootGraph* graph, double sampleRate, int estimatedBlockSize)
     {
         graph->setRenderDetails (sampleRate, blockSize);
@@ -858,6 +1272,14 @@ void AudioEngine::applySettings (Settings& settings)
     }
 
     priv->startStopCont.set (settings.transportRespondToStartStopContinue() ? 1 : 0);
+
+    const int renderThreads = jmin (settings.getRenderThreads(), RenderPool::getMaxWorkers());
+    if (renderThreads != priv->renderPool.getNumWorkers())
+    {
+        // workers can't be changed while a graph is rendering with them.
+        ScopedLock sl (priv->lock);
+        priv->renderPool.setNumWorkers (renderThreads);
+    }
 }
 
 bool AudioEngine::removeGraph (RootGraph* graph)
@@ -922,6 +1344,12 @@ void AudioEngine::setMeter (int beatsPerBar, int beatDivisor)
     transport.requestMeter (beatsPerBar, beatDivisor);
 }
 
+void AudioEngine::setTempoMap (const TimeScale& map)
+{
+    auto& transport (priv->transport);
+    transport.requestTempoMap (map);
+}
+
 void AudioEngine::togglePlayPause()
 {
     auto& transport (priv->transport);
@@ -962,6 +1390,13 @@ void AudioEngine::processExternalBuffers (AudioBuffer<float>& buffer, MidiBuffer
     }
 }
 
+Result AudioEngine::renderOffline (const OfflineRender& options)
+{
+    jassert (MessageManager::getInstance()->isThisTheMessageThread());
+    return priv != nullptr ? priv->renderOffline (options)
+                           : Result::fail ("No engine");
+}
+
 bool AudioEngine::isUsingExternalClock() const
 {
     return priv && priv->isUsingExternalClock();
@@ -1033,6 +1468,12 @@ MidiIOMonitorPtr AudioEngine::getMidiIOMonitor() const
     return priv != nullptr ? priv->midiIOMonitor : nullptr;
 }
 
+RenderPool& AudioEngine::getRenderPool() noexcept
+{
+    jassert (priv != nullptr);
+    return priv->renderPool;
+}
+
 int AudioEngine::getNumChannels (bool input) const noexcept
 {
     return input ? priv->numInputChans : priv->numOutputChans;
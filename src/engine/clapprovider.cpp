@@ -17,6 +17,8 @@
 
 #include "appinfo.hpp"
 #include "engine/clapprovider.hpp"
+#include "engine/graphnode.hpp"
+#include "engine/renderpool.hpp"
 #include "lv2/messages.hpp"
 #include "ui/resizelistener.hpp"
 #include "ui/nsviewwithparent.hpp"
@@ -196,7 +198,14 @@ public:
 
     bool threadCheckIsAudioThread() const noexcept
     {
-        return gThreadType == ThreadType::AudioThread;
+        return gThreadType == ThreadType::AudioThread
+               || gThreadType == ThreadType::AudioThreadPool;
+    }
+
+    /** Returns true once after the plugin asked to be woken up. */
+    bool takeProcessRequest() noexcept
+    {
+        return _processRequested.exchange (false, std::memory_order_acq_rel);
     }
 
 protected:
@@ -208,6 +217,7 @@ protected:
     void requestProcess() noexcept override
     {
         CLAP_LOG ("host:requestProcess()")
+        _processRequested.store (true, std::memory_order_release);
     }
     void requestCallback() noexcept override
     {
@@ -387,12 +397,48 @@ protected:
       // clap_host_tail
       virtual bool implementsTail() const noexcept { return false; }
       virtual void tailChanged() noexcept {}
-
-      // clap_host_thread_pool
-      virtual bool implementsThreadPool() const noexcept { return false; }
-      virtual bool threadPoolRequestExec(uint32_t numTasks) noexcept { return false; }
 #endif
 
+    // clap_host_thread_pool
+    /** Runs the plugin's tasks on the engine's render pool. */
+    struct PoolTasks final : public RenderPool::Tasks
+    {
+        PoolTasks (const clap_plugin_t* p, const clap_plugin_thread_pool_t* t)
+            : plugin (p), threadPool (t) {}
+
+        void perform (int index) noexcept override
+        {
+            const auto previous = gThreadType;
+            if (previous != ThreadType::AudioThread)
+                gThreadType = ThreadType::AudioThreadPool;
+            threadPool->exec (plugin, static_cast<uint32_t> (index));
+            gThreadType = previous;
+        }
+
+        const clap_plugin_t* plugin;
+        const clap_plugin_thread_pool_t* threadPool;
+    };
+
+    std::atomic<bool> _processRequested { false };
+    std::atomic<RenderPool*> _renderPool { nullptr };
+    const clap_plugin_thread_pool_t* _threadPool { nullptr };
+
+    void setPluginThreadPool (const clap_plugin_thread_pool_t* threadPool) { _threadPool = threadPool; }
+    void setRenderPool (RenderPool* pool) noexcept { _renderPool.store (pool, std::memory_order_release); }
+
+    bool implementsThreadPool() const noexcept override { return true; }
+
+    bool threadPoolRequestExec (uint32_t numTasks) noexcept override
+    {
+        auto* const pool = _renderPool.load (std::memory_order_acquire);
+        if (pool == nullptr || _plugin == nullptr || _threadPool == nullptr)
+            return false;
+
+        // returning false makes the plugin perform the tasks itself.
+        PoolTasks tasks (_plugin, _threadPool);
+        return pool->runTasks (tasks, static_cast<int> (numTasks));
+    }
+
 private:
     clap::helpers::EventList _evIn, _evOut;
 
@@ -532,6 +578,29 @@ public:
         });
     }
 
+    /** Like readAll, but in time order. Every event must be the same size,
+        which holds for parameter values. Usually already in order, so the
+        events are insertion sorted in place. */
+    template <typename Callback>
+    void readAllInTimeOrder (Callback&& callback)
+    {
+        read (mutex, [&] {
+            if (data.empty())
+                return;
+
+            const auto size = (size_t) ((const clap_event_header_t*) data.data())->size;
+            jassert (size <= maxSortedSize && data.size() % size == 0);
+            if (size <= maxSortedSize)
+                sortByTime (size);
+
+            const auto end = data.data() + data.size();
+            for (auto ptr = data.data(); ptr < end; ptr += size)
+                callback ((clap_event_header_t*) ptr);
+
+            data.resize (0);
+        });
+    }
+
 private:
     using Read = typename Locks::Read;
     Read read;
@@ -540,8 +609,62 @@ private:
     Write write;
 
     static constexpr auto initialSize = 8192;
+    static constexpr size_t maxSortedSize = 128;
     lvtk::SpinLock mutex;
     std::vector<char> data;
+
+    static uint32_t timeAt (const char* ptr) noexcept
+    {
+        return ((const clap_event_header_t*) ptr)->time;
+    }
+
+    void sortByTime (size_t size) noexcept
+    {
+        alignas (std::max_align_t) char moving[maxSortedSize];
+        auto* const begin = data.data();
+        auto* const end = begin + data.size();
+        for (auto* ptr = begin + size; ptr < end; ptr += size)
+        {
+            if (timeAt (ptr - size) <= timeAt (ptr))
+                continue;
+
+            std::memcpy (moving, ptr, size);
+            auto* hole = ptr;
+            for (; hole > begin && timeAt (hole - size) > timeAt (moving); hole -= size)
+                std::memcpy (hole, hole - size, size);
+            std::memcpy (hole, moving, size);
+        }
+    }
+};
+
+//==============================================================================
+/** Where in the next block a change made now should land. Changes are
+    spread over it by when they arrived during the previous block, like
+    mapped MIDI controllers. */
+class CLAPBlockClock final
+{
+public:
+    /** Called by the render thread as a block starts. */
+    void begin (double sampleRate, int numSamples) noexcept
+    {
+        rate.store (sampleRate, std::memory_order_relaxed);
+        size.store (numSamples, std::memory_order_relaxed);
+        start.store (Time::getMillisecondCounterHiRes() * 0.001, std::memory_order_relaxed);
+    }
+
+    /** Returns the frame for a change made now, from any thread. */
+    uint32_t frameForNow() const noexcept
+    {
+        const auto numSamples = size.load (std::memory_order_relaxed);
+        if (numSamples <= 0)
+            return 0;
+        const auto elapsed = Time::getMillisecondCounterHiRes() * 0.001 - start.load (std::memory_order_relaxed);
+        return (uint32_t) jlimit (0, numSamples - 1, roundToInt (elapsed * rate.load (std::memory_order_relaxed)));
+    }
+
+private:
+    std::atomic<double> rate { 44100.0 }, start { 0.0 };
+    std::atomic<int> size { 0 };
 };
 
 //==============================================================================
@@ -791,7 +914,8 @@ private:
 class CLAPParameter : public Parameter
 {
     using Queue = CLAPEventQueue<lvtk::RealtimeReadTrait>;
-    Queue& _queue;
+    Queue& _timed;
+    const CLAPBlockClock& _clock;
     const clap_plugin_t* _plugin;
     const clap_plugin_params_t* _params;
     const clap_param_info_t _info;
@@ -800,13 +924,15 @@ class CLAPParameter : public Parameter
     juce::NormalisableRange<double> _range;
 
 public:
-    explicit CLAPParameter (Queue& events,
+    explicit CLAPParameter (Queue& timedEvents,
+                            const CLAPBlockClock& clock,
                             const clap_plugin_t* plugin,
                             const clap_plugin_params_t* params,
                             const clap_param_info_t* pi,
                             int portIndex,
                             int paramIndex)
-        : _queue (events),
+        : _timed (timedEvents),
+          _clock (clock),
           _plugin (plugin),
           _params (params),
           _info (*pi),
@@ -821,6 +947,25 @@ public:
 
     ~CLAPParameter() {}
 
+    clap_event_param_value_t makeValueEvent (float newValue, uint32_t frame) const noexcept
+    {
+        clap_event_param_value_t ev;
+        ev.header.type = CLAP_EVENT_PARAM_VALUE;
+        ev.header.flags = 0; //CLAP_EVENT_IS_LIVE;
+        ev.header.size = sizeof (ev);
+        ev.header.space_id = CLAP_CORE_EVENT_SPACE_ID;
+        ev.header.time = frame;
+        ev.port_index = 0;
+        ev.cookie = _info.cookie;
+        ev.param_id = _info.id;
+        ev.value = _range.convertFrom0to1 (newValue);
+
+        ev.key = -1;
+        ev.note_id = -1;
+        ev.channel = -1;
+        return ev;
+    }
+
     void syncAndNotify()
     {
         double value = 0.0;
@@ -843,25 +988,17 @@ public:
     void setValue (float newValue) override
     {
         _value.store (newValue);
+        // host automation goes in frame order with everything else.
+        auto ev = makeValueEvent (newValue, _clock.frameForNow());
+        _timed.push (&ev.header);
+    }
 
-        clap_event_param_value_t ev;
-        ev.header.type = CLAP_EVENT_PARAM_VALUE;
-        ev.header.flags = 0; //CLAP_EVENT_IS_LIVE;
-        ev.header.size = sizeof (ev);
-        ev.header.space_id = CLAP_CORE_EVENT_SPACE_ID;
-        ev.header.time = 0;
-        ev.port_index = 0;
-        ev.cookie = _info.cookie;
-        ev.param_id = _info.id;
-        ev.value = _range.convertFrom0to1 (newValue);
-
-        ev.key = -1;
-        ev.note_id = -1;
-        ev.channel = -1;
-
-        _queue.push (&ev.header);
-
-        // std::cout << "[param] send: " << ev.value << std::endl;
+    bool setValueAtFrame (float newValue, int frame) override
+    {
+        _value.store (newValue);
+        auto ev = makeValueEvent (newValue, (uint32_t) jmax (0, frame));
+        _timed.push (&ev.header);
+        return true;
     }
 
     float getDefaultValue() const override { return static_cast<float> (_info.default_value); }
@@ -1229,14 +1366,22 @@ public:
             return;
         const auto maxChans = std::max ((int) detail::totalChannels (_audioIns),
                                         (int) detail::totalChannels (_audioOuts));
-        _tmpAudio.setSize (maxChans, maxBufferSize);
+        _tmpAudio.setSize (_inPlace ? 1 : maxChans, maxBufferSize);
+        _processing = _sleeping = false;
+        _steadyTime = 0;
         _plugin->activate (_plugin, sampleRate, 16U, (uint32_t) maxBufferSize);
+        _sampleRate = sampleRate;
+        updateTail();
     }
 
     void releaseResources() override
     {
         if (_plugin == nullptr)
             return;
+        // audio has stopped by now, so nothing else is processing.
+        if (_processing)
+            _plugin->stop_processing (_plugin);
+        _processing = _sleeping = false;
         _plugin->deactivate (_plugin);
         _tmpAudio.setSize (1, 1);
     }
@@ -1244,9 +1389,12 @@ public:
     void render (RenderContext& rc) override
     {
         gThreadType = ThreadType::AudioThread;
+        if (auto graph = getParentGraph())
+            _host.setRenderPool (graph->getRenderPool());
 
-        _proc.steady_time = -1;
+        _proc.steady_time = _steadyTime;
         _proc.frames_count = (uint32_t) rc.audio.getNumSamples();
+        _steadyTime += _proc.frames_count;
 
         clap_event_transport_t _transport = {};
         if (auto pos = getPlayHead()->getPosition())
@@ -1299,46 +1447,66 @@ public:
         _proc.in_events = _eventIn.clapInputEvents();
         _proc.out_events = _eventOut.clapOutputEvents();
 
+        _eventIn.clear();
         _eventOut.clear();
 
-        _queueIn.readAll ([this] (const clap_event_header_t* ev) {
+        static const MidiBuffer noMidi;
+        auto mb = _notes != nullptr ? rc.midi.getReadBuffer (0) : &noMidi;
+        auto midiIter = mb->begin();
+        const auto pushMidiUntil = [&] (int frame) {
+            for (; midiIter != mb->end() && (*midiIter).samplePosition <= frame; ++midiIter)
+                pushMidi (*midiIter);
+        };
+
+        _timedIn.readAllInTimeOrder ([&] (clap_event_header_t* ev) {
+            // a change meant for a longer block goes at the end of this one.
+            if (ev->time >= _proc.frames_count && _proc.frames_count > 0)
+                ev->time = _proc.frames_count - 1;
+            pushMidiUntil ((int) ev->time - 1);
             _eventIn.push (ev);
         });
+        pushMidiUntil (std::numeric_limits<int>::max());
+        _clock.begin (_sampleRate, (int) _proc.frames_count);
 
-        if (_notes != nullptr)
-        {
-            auto mb = rc.midi.getReadBuffer (0);
-            for (auto i : *mb)
-            {
-                if (i.numBytes != 3)
-                    continue;
-                clap_event_midi_t ev;
-                ev.header.flags = CLAP_EVENT_IS_LIVE;
-                ev.header.size = sizeof (clap_event_midi_t);
-                ev.header.space_id = 0;
-                ev.header.time = static_cast<uint32_t> (i.samplePosition);
-                ev.header.type = CLAP_EVENT_MIDI;
-                ev.port_index = 0;
-                std::memcpy (ev.data, i.data, 3);
-                _eventIn.push (&ev.header);
-            }
-        }
-
+        const int numSamples = rc.audio.getNumSamples();
+        bool quietInput = true;
         int rcc = 0;
         for (uint32_t i = 0; i < _proc.audio_inputs_count; ++i)
         {
             auto b = &_proc.audio_inputs[i];
             for (uint32_t j = 0; j < b->channel_count; ++j)
             {
+                if (quietInput && rc.audio.getMagnitude (rcc, 0, numSamples) > quietLevel)
+                    quietInput = false;
                 b->data32[j] = (float*) rc.audio.getReadPointer (rcc++);
             }
         }
 
-        _tmpAudio.setSize (rc.audio.getNumChannels(),
-                           rc.audio.getNumSamples(),
-                           true,
-                           false,
-                           true);
+        const int numOutputs = (int) detail::totalChannels (_audioOuts);
+        const bool requested = _host.takeProcessRequest();
+        if (_sleeping && ! requested && quietInput && _eventIn.size() == 0)
+        {
+            for (int c = 0; c < numOutputs; ++c)
+                rc.audio.clear (c, 0, numSamples);
+            return;
+        }
+
+        _sleeping = false;
+        if (! _processing)
+        {
+            _processing = _plugin->start_processing (_plugin);
+            if (! _processing)
+            {
+                for (int c = 0; c < numOutputs; ++c)
+                    rc.audio.clear (c, 0, numSamples);
+                return;
+            }
+        }
+
+        // in place, the plugin writes straight into the graph's buffer.
+        auto& out = _inPlace ? rc.audio : _tmpAudio;
+        if (! _inPlace)
+            _tmpAudio.setSize (rc.audio.getNumChannels(), numSamples, true, false, true);
 
         rcc = 0;
         for (uint32_t i = 0; i < _proc.audio_outputs_count; ++i)
@@ -1346,17 +1514,46 @@ public:
             auto b = &_proc.audio_outputs[i];
             for (uint32_t j = 0; j < b->channel_count; ++j)
             {
-                b->data32[j] = _tmpAudio.getWritePointer (rcc++);
+                b->data32[j] = out.getWritePointer (rcc++);
             }
         }
 
-        _plugin->start_processing (_plugin);
-        _plugin->process (_plugin, &_proc);
-        _plugin->stop_processing (_plugin);
+        const auto status = _plugin->process (_plugin, &_proc);
 
+        bool quietOutput = true;
         while (--rcc >= 0)
         {
-            rc.audio.copyFrom (rcc, 0, _tmpAudio, rcc, 0, rc.audio.getNumSamples());
+            if (status == CLAP_PROCESS_ERROR)
+                out.clear (rcc, 0, numSamples);
+            else if (quietOutput && out.getMagnitude (rcc, 0, numSamples) > quietLevel)
+                quietOutput = false;
+            if (! _inPlace)
+                rc.audio.copyFrom (rcc, 0, _tmpAudio, rcc, 0, numSamples);
+        }
+
+        switch (status)
+        {
+            case CLAP_PROCESS_SLEEP:
+                _sleeping = true;
+                break;
+            // without the tail extension, a finished tail is a quiet output.
+            case CLAP_PROCESS_CONTINUE_IF_NOT_QUIET:
+            case CLAP_PROCESS_TAIL:
+                _sleeping = quietOutput && quietInput;
+                break;
+            default:
+                break;
+        }
+
+        // the tail can change with parameters, the extension is audio thread safe.
+        if (_tail != nullptr)
+            updateTail();
+
+        // plugins are told before going to sleep, and started again on wake up.
+        if (_sleeping)
+        {
+            _plugin->stop_processing (_plugin);
+            _processing = false;
         }
 
         gThreadType = ThreadType::AudioThread;
@@ -1364,6 +1561,107 @@ public:
 
     void renderBypassed (RenderContext&) override {}
 
+    void setNonRealtime (bool isNonRealtime) noexcept override
+    {
+        Processor::setNonRealtime (isNonRealtime);
+        if (_render != nullptr)
+            _render->set (_plugin, isNonRealtime ? CLAP_RENDER_OFFLINE : CLAP_RENDER_REALTIME);
+    }
+
+    double getTailSeconds() const override
+    {
+        return _tailSeconds.load (std::memory_order_relaxed);
+    }
+
+    /** Translate a MIDI message to the event the plugin's note port prefers. */
+    void pushMidi (const MidiMessageMetadata& msg) noexcept
+    {
+        const auto time = static_cast<uint32_t> (msg.samplePosition);
+        const auto* data = msg.data;
+
+        if (data[0] == 0xf0)
+        {
+            if (! _midiDialect)
+                return;
+            clap_event_midi_sysex_t ev;
+            setHeader (ev.header, sizeof (ev), time, CLAP_EVENT_MIDI_SYSEX);
+            ev.port_index = 0;
+            ev.buffer = data;
+            ev.size = static_cast<uint32_t> (msg.numBytes);
+            _eventIn.push (&ev.header);
+            return;
+        }
+
+        if (msg.numBytes < 1 || msg.numBytes > 3)
+            return;
+
+        const int status = data[0] & 0xf0;
+        const int16_t channel = data[0] & 0x0f;
+        const int16_t key = msg.numBytes > 1 ? data[1] : 0;
+        const int value = msg.numBytes > 2 ? data[2] : 0;
+
+        if (_clapDialect && (status == 0x80 || status == 0x90))
+        {
+            clap_event_note_t ev;
+            const bool on = status == 0x90 && value > 0;
+            setHeader (ev.header, sizeof (ev), time, on ? CLAP_EVENT_NOTE_ON : CLAP_EVENT_NOTE_OFF);
+            ev.note_id = -1;
+            ev.port_index = 0;
+            ev.channel = channel;
+            ev.key = key;
+            ev.velocity = value / 127.0;
+            _eventIn.push (&ev.header);
+            return;
+        }
+
+        // pressure maps to an expression. Everything else needs MIDI, except
+        // pitch bend which becomes tuning when the plugin has no MIDI dialect.
+        const bool pressure = status == 0xa0 || status == 0xd0;
+        const bool bend = status == 0xe0 && ! _midiDialect;
+        if (_clapDialect && (pressure || bend))
+        {
+            clap_event_note_expression_t ev;
+            setHeader (ev.header, sizeof (ev), time, CLAP_EVENT_NOTE_EXPRESSION);
+            ev.note_id = -1;
+            ev.port_index = 0;
+            ev.channel = channel;
+            if (bend)
+            {
+                ev.expression_id = CLAP_NOTE_EXPRESSION_TUNING;
+                ev.key = -1;
+                ev.value = 2.0 * ((key | (value << 7)) - 8192) / 8192.0;
+            }
+            else
+            {
+                ev.expression_id = CLAP_NOTE_EXPRESSION_PRESSURE;
+                ev.key = status == 0xa0 ? key : -1;
+                ev.value = (status == 0xa0 ? value : key) / 127.0;
+            }
+            _eventIn.push (&ev.header);
+            return;
+        }
+
+        if (! _midiDialect)
+            return;
+
+        clap_event_midi_t ev;
+        setHeader (ev.header, sizeof (ev), time, CLAP_EVENT_MIDI);
+        ev.port_index = 0;
+        ev.data[0] = data[0];
+        ev.data[1] = (uint8_t) key;
+        ev.data[2] = (uint8_t) value;
+        _eventIn.push (&ev.header);
+    }
+
+    static void setHeader (clap_event_header_t& header, size_t size, uint32_t time, uint16_t type) noexcept
+    {
+        header.size = static_cast<uint32_t> (size);
+        header.time = time;
+        header.space_id = CLAP_CORE_EVENT_SPACE_ID;
+        header.type = type;
+        header.flags = CLAP_EVENT_IS_LIVE;
+    }
+
     //==========================================================================
     void refreshPorts() override {}
 
@@ -1441,7 +1739,8 @@ protected:
             return nullptr;
         clap_param_info_t info;
         _params->get_info (_plugin, (uint32_t) port.channel, &info);
-        return new CLAPParameter (_queueIn,
+        return new CLAPParameter (_timedIn,
+                                  _clock,
                                   _plugin,
                                   _params,
                                   &info,
@@ -1465,13 +1764,29 @@ private:
     const clap_plugin_note_ports_t* _notes { nullptr };
     const clap_plugin_params_t* _params { nullptr };
     const clap_plugin_gui_t* _gui { nullptr };
+    const clap_plugin_tail_t* _tail { nullptr };
+    const clap_plugin_render_t* _render { nullptr };
+    std::atomic<double> _tailSeconds { unknownTailSeconds };
+    double _sampleRate { 44100.0 };
 
     clap_process_t _proc;
     std::vector<clap_audio_buffer_t> _audioIns, _audioOuts;
+    // Processing state between blocks. Only touched on the audio thread,
+    // and in prepare/release while audio is stopped.
+    bool _processing { false }, _sleeping { false };
+    int64_t _steadyTime { 0 };
+    // Outputs can be written straight into the graph's buffer.
+    bool _inPlace { false };
+    // Dialects of the first input note port.
+    bool _clapDialect { false }, _midiDialect { true };
+    static constexpr float quietLevel = 1.0e-6f; // about -120 dB
     AudioBuffer<float> _tmpAudio;
 
     clap::helpers::EventList _eventIn, _eventOut;
-    CLAPEventQueue<lvtk::RealtimeReadTrait> _queueIn;
+    // Parameter changes for the next block, read in frame order and merged
+    // with incoming MIDI since CLAP wants input events sorted by time.
+    CLAPEventQueue<lvtk::RealtimeReadTrait> _timedIn;
+    CLAPBlockClock _clock;
     CLAPEventQueue<lvtk::RealtimeWriteTrait> _queueOut;
 
     CLAPProcessor (CLAPModule::Ptr m, const String& i)
@@ -1501,17 +1816,31 @@ private:
         {
             _audio = audio;
 
-            initAudioBuffers (_audioIns, true);
+            std::vector<clap_audio_port_info_t> inInfo, outInfo;
+            initAudioBuffers (_audioIns, true, inInfo);
             _proc.audio_inputs_count = _audio->count (_plugin, true);
             _proc.audio_inputs = _audioIns.data();
             pc.inputs[PortType::Audio] = detail::totalChannels (_audioIns);
             jassert (_proc.audio_inputs_count == _audioIns.size());
 
-            initAudioBuffers (_audioOuts, false);
+            initAudioBuffers (_audioOuts, false, outInfo);
             _proc.audio_outputs_count = _audio->count (_plugin, false);
             _proc.audio_outputs = _audioOuts.data();
             pc.outputs[PortType::Audio] = detail::totalChannels (_audioOuts);
             jassert (_proc.audio_outputs_count == _audioOuts.size());
+
+            // input and output channels share the graph's buffer, so every
+            // output port overlapping an input has to be its in-place pair.
+            _inPlace = true;
+            for (size_t i = 0; i < outInfo.size() && i < inInfo.size(); ++i)
+            {
+                if (outInfo[i].in_place_pair != inInfo[i].id
+                    || _audioOuts[i].channel_count != _audioIns[i].channel_count)
+                {
+                    _inPlace = false;
+                    break;
+                }
+            }
         }
 
         if (auto notes = (const clap_plugin_note_ports_t*) extension (CLAP_EXT_NOTE_PORTS))
@@ -1521,6 +1850,14 @@ private:
             {
                 clap_note_port_info_t info;
                 notes->get (_plugin, i, true, &info);
+                if (i == 0)
+                {
+                    _clapDialect = (info.supported_dialects & CLAP_NOTE_DIALECT_CLAP) != 0;
+                    _midiDialect = (info.supported_dialects & CLAP_NOTE_DIALECT_MIDI) != 0;
+                    // plugins preferring MIDI still get MIDI note on/off.
+                    if (_midiDialect && info.preferred_dialect == CLAP_NOTE_DIALECT_MIDI)
+                        _clapDialect = false;
+                }
                 ++pc.inputs[PortType::Midi];
             }
 
@@ -1552,11 +1889,19 @@ private:
                 _gui = gui;
         }
 
+        _tail = (const clap_plugin_tail_t*) extension (CLAP_EXT_TAIL);
+        _render = (const clap_plugin_render_t*) extension (CLAP_EXT_RENDER);
+
         if (auto timer = (const clap_plugin_timer_support_t*) extension (CLAP_EXT_TIMER_SUPPORT))
         {
             _host.setPluginTimer (timer);
         }
 
+        if (auto threadPool = (const clap_plugin_thread_pool_t*) extension (CLAP_EXT_THREAD_POOL))
+        {
+            _host.setPluginThreadPool (threadPool);
+        }
+
         if (auto fd = (const clap_plugin_posix_fd_support_t*) extension (CLAP_EXT_POSIX_FD_SUPPORT))
         {
             juce::ignoreUnused (fd);
@@ -1565,8 +1910,26 @@ private:
         return true;
     }
 
+    /** Cache the plugin's tail, in seconds, for the graph's sleep check. */
+    void updateTail() noexcept
+    {
+        if (_tail == nullptr)
+        {
+            _tailSeconds.store (unknownTailSeconds, std::memory_order_relaxed);
+            return;
+        }
+
+        // frames are at the rate the plugin runs at, oversampling included.
+        const auto frames = _tail->get (_plugin);
+        _tailSeconds.store (frames >= (uint32_t) std::numeric_limits<int32_t>::max()
+                                ? std::numeric_limits<double>::infinity()
+                                : (double) frames / _sampleRate,
+                            std::memory_order_relaxed);
+    }
+
     void initAudioBuffers (std::vector<clap_audio_buffer_t>& bufs,
-                           bool isInput)
+                           bool isInput,
+                           std::vector<clap_audio_port_info_t>& infos)
     {
         auto numBuses = _audio->count (_plugin, isInput);
         for (uint32_t i = 0; i < numBuses; ++i)
@@ -1574,6 +1937,7 @@ private:
             uint32_t numChannels = 0;
             clap_audio_port_info_t info;
             _audio->get (_plugin, i, isInput, &info);
+            infos.push_back (info);
 
             const auto name = std::string (info.name);
             int ID = (int) info.id;
@@ -0,0 +1,93 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include "matrixstate.hpp"
+
+namespace element {
+
+/** A dense matrix of input to output gains for realtime routing.
+
+    Gains are stored in one contiguous block, row by row, so a crosspoint
+    is addressed by a single index. Like ToggleGrid, construction and
+    resizing allocate; everything else is realtime safe.
+ */
+class GainMatrix
+{
+public:
+    explicit GainMatrix (int ins = 4, int outs = 4)
+    {
+        resize (ins, outs);
+    }
+
+    /** Create a matrix with unity gain where the state is connected. */
+    explicit GainMatrix (const MatrixState& matrix)
+    {
+        resize (matrix.getNumRows(), matrix.getNumColumns());
+        for (int i = 0; i < numIns; ++i)
+            for (int o = 0; o < numOuts; ++o)
+                gains[index (i, o)] = matrix.connected (i, o) ? 1.0f : 0.0f;
+    }
+
+    void resize (int ins, int outs)
+    {
+        jassert (ins > 0 && outs > 0);
+        numIns = ins;
+        numOuts = outs;
+        gains.calloc ((size_t) (numIns * numOuts));
+    }
+
+    inline int getNumInputs() const noexcept { return numIns; }
+    inline int getNumOutputs() const noexcept { return numOuts; }
+    inline int size() const noexcept { return numIns * numOuts; }
+
+    inline bool sameSizeAs (const GainMatrix& other) const noexcept
+    {
+        return numIns == other.numIns && numOuts == other.numOuts;
+    }
+
+    inline int index (int in, int out) const noexcept
+    {
+        jassert (isPositiveAndBelow (in, numIns) && isPositiveAndBelow (out, numOuts));
+        return in * numOuts + out;
+    }
+
+    inline float get (int in, int out) const noexcept { return gains[index (in, out)]; }
+    inline void set (int in, int out, float gain) noexcept { gains[index (in, out)] = gain; }
+
+    inline float* getData() noexcept { return gains.get(); }
+    inline const float* getData() const noexcept { return gains.get(); }
+
+    inline void clear() noexcept { FloatVectorOperations::clear (gains.get(), size()); }
+
+    /** Copy gains from a matrix of the same size. */
+    inline void copyFrom (const GainMatrix& other) noexcept
+    {
+        jassert (sameSizeAs (other));
+        FloatVectorOperations::copy (gains.get(), other.gains.get(), size());
+    }
+
+    /** Add src to dst with a gain that moves by step every frame, starting
+        one step after gain. The loop has no branches so it vectorizes. */
+    static void addWithRamp (float* dst, const float* src, int numFrames, float gain, float step) noexcept
+    {
+        for (int i = 0; i < numFrames; ++i)
+            dst[i] += src[i] * (gain + step * (float) (i + 1));
+    }
+
+    /** Add src to dst with a fixed gain. */
+    static void addWithGain (float* dst, const float* src, int numFrames, float gain) noexcept
+    {
+        if (gain == 1.0f)
+            FloatVectorOperations::add (dst, src, numFrames);
+        else if (gain != 0.0f)
+            FloatVectorOperations::addWithMultiply (dst, src, gain, numFrames);
+    }
+
+private:
+    int numIns = 0, numOuts = 0;
+    HeapBlock<float> gains;
+};
+
+} // namespace element
@@ -8,6 +8,7 @@
 #include "engine/miditranspose.hpp"
 #include "engine/graphnode.hpp"
 #include "engine/graphbuilder.hpp"
+#include "engine/renderprofile.hpp"
 #include "engine/ionode.hpp"
 
 #ifndef EL_TRACE_GRAPH_OPS
@@ -37,6 +38,8 @@ public:
             ptr[f] = value.getNextValue();
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override { b.add (PortType::CV, cvIndex); }
+
 private:
     ParameterPtr param;
     LinearSmoothedValue<float> value;
@@ -85,20 +88,26 @@ public:
     {
     }
 
-    std::string traceStep() const noexcept
+    std::string traceStep() const noexcept override
     {
         String str;
         str << "CopyAtomBuffer: buffers " << srcBufferNum << " to " << dstBufferNum;
         return str.toStdString();
     }
 
-    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>&, const SharedAtom& atom, const int)
+    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>&, const SharedAtom& atom, const int) override
     {
         auto dst = atom.getUnchecked (dstBufferNum);
         dst->clear();
         dst->add (*atom.getUnchecked (srcBufferNum));
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.add (PortType::Atom, srcBufferNum, false);
+        b.add (PortType::Atom, dstBufferNum);
+    }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -114,12 +123,18 @@ public:
     {
     }
 
-    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>&, const SharedAtom& atom, const int numSamples)
+    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>&, const SharedAtom& atom, const int numSamples) override
     {
         atom.getUnchecked (dstBufferNum)
             ->add (*atom.getUnchecked (srcBufferNum)); // TODO: -> , 0, numSamples, 0);
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.add (PortType::Atom, srcBufferNum, false);
+        b.add (PortType::Atom, dstBufferNum);
+    }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -145,6 +160,8 @@ public:
     {
         atom.getUnchecked (bufferIdx)->clear (0, numSamples);
     }
+
+    void collectBuffers (GraphOpBuffers& b) const override { b.add (PortType::Atom, bufferIdx); }
 };
 
 class MidiToAtomOp : public GraphOp
@@ -165,6 +182,12 @@ public:
         atom.getUnchecked (_atomIdx)->add (*midi.getUnchecked (_midiIdx));
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.add (PortType::Midi, _midiIdx, false);
+        b.add (PortType::Atom, _atomIdx);
+    }
+
 private:
     const int _midiIdx, _atomIdx;
 };
@@ -201,6 +224,12 @@ public:
         }
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.add (PortType::Atom, _atomIdx, false);
+        b.add (PortType::Midi, _midiIdx);
+    }
+
 private:
     const int _atomIdx, _midiIdx;
     const uint32_t midi_MidiEvent;
@@ -215,11 +244,13 @@ public:
     {
     }
 
-    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples)
+    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples) override
     {
         sharedBufferChans.clear (channelNum, 0, numSamples);
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override { b.add (PortType::Audio, channelNum); }
+
 private:
     const int channelNum;
 
@@ -235,11 +266,17 @@ public:
     {
     }
 
-    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples)
+    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples) override
     {
         sharedBufferChans.copyFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.add (PortType::Audio, srcChannelNum, false);
+        b.add (PortType::Audio, dstChannelNum);
+    }
+
 private:
     const int srcChannelNum, dstChannelNum;
 
@@ -255,11 +292,17 @@ public:
     {
     }
 
-    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples)
+    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples) override
     {
         sharedBufferChans.addFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.add (PortType::Audio, srcChannelNum, false);
+        b.add (PortType::Audio, dstChannelNum);
+    }
+
 private:
     const int srcChannelNum, dstChannelNum;
 
@@ -274,11 +317,13 @@ public:
     {
     }
 
-    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>& sharedMidiBuffers, const SharedAtom&, const int)
+    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>& sharedMidiBuffers, const SharedAtom&, const int) override
     {
         sharedMidiBuffers.getUnchecked (bufferNum)->clear();
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override { b.add (PortType::Midi, bufferNum); }
+
 private:
     const int bufferNum;
 
@@ -295,11 +340,17 @@ public:
     {
     }
 
-    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>& sharedMidiBuffers, const SharedAtom&, const int)
+    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>& sharedMidiBuffers, const SharedAtom&, const int) override
     {
         *sharedMidiBuffers.getUnchecked (dstBufferNum) = *sharedMidiBuffers.getUnchecked (srcBufferNum);
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.add (PortType::Midi, srcBufferNum, false);
+        b.add (PortType::Midi, dstBufferNum);
+    }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -315,12 +366,18 @@ public:
     {
     }
 
-    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>& sharedMidiBuffers, const SharedAtom&, const int numSamples)
+    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>& sharedMidiBuffers, const SharedAtom&, const int numSamples) override
     {
         sharedMidiBuffers.getUnchecked (dstBufferNum)
             ->addEvents (*sharedMidiBuffers.getUnchecked (srcBufferNum), 0, numSamples, 0);
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        b.add (PortType::Midi, srcBufferNum, false);
+        b.add (PortType::Midi, dstBufferNum);
+    }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -339,7 +396,7 @@ public:
         buffer.calloc ((size_t) bufferSize);
     }
 
-    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples)
+    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples) override
     {
         float* data = sharedBufferChans.getWritePointer (channel, 0);
 
@@ -355,6 +412,8 @@ public:
         }
     }
 
+    void collectBuffers (GraphOpBuffers& b) const override { b.add (PortType::Audio, channel); }
+
 private:
     HeapBlock<float> buffer;
     const int channel, bufferSize;
@@ -539,8 +598,17 @@ public:
             }
         };
 
+        const bool canSleep = node->sleepsOnSilence();
+        const bool asleep = canSleep && updateSleep (context, numSamples);
+        const auto startTicks = Time::getHighResolutionTicks();
+
         const auto osFactor = node->getOversamplingFactor();
-        if (osFactor > 1)
+        if (asleep)
+        {
+            for (int ch = 0; ch < numAudioOuts; ++ch)
+                context.audio.clear (ch, 0, numSamples);
+        }
+        else if (osFactor > 1)
         {
             auto osProcessor = node->getOversamplingProcessor();
 
@@ -600,6 +668,28 @@ public:
             pluginProcessBlock (context, node->isSuspended());
         }
 
+        const auto renderTicks = Time::getHighResolutionTicks() - startTicks;
+        // sleeping blocks cost nothing and would drag the stats down.
+        if (! asleep)
+            node->profile->record (renderTicks, numSamples, node->getSampleRate());
+
+        if (! canSleep)
+        {
+            silentSamples = 0;
+            node->sleeping.set (0);
+        }
+        else if (asleep)
+        {
+            if (auto* graph = node->getParentGraph())
+                graph->addSleepSavings ((int64) (awakeTicksPerSample * numSamples));
+        }
+        else
+        {
+            const auto ticks = (double) renderTicks / numSamples;
+            awakeTicksPerSample = awakeTicksPerSample > 0.0 ? awakeTicksPerSample + 0.1 * (ticks - awakeTicksPerSample)
+                                                            : ticks;
+        }
+
         if (muted && ! muteInput)
         {
             if (lastMute != muted)
@@ -634,6 +724,52 @@ public:
             node->setOutputRMS (i, context.audio.getRMSLevel (i, 0, numSamples));
     }
 
+    /** Tracks input silence of a node that sleeps on silence. Returns true
+        once the inputs have been silent for longer than the node's tail. */
+    bool updateSleep (RenderContext& context, int numSamples) noexcept
+    {
+        // generators and instruments without audio inputs never sleep.
+        bool silent = numAudioIns > 0;
+        for (int i = 0; i < numAudioIns && silent; ++i)
+            silent = context.audio.getMagnitude (i, 0, numSamples) <= silenceLevel;
+        for (int i = 0; i < context.midi.getNumBuffers() && silent; ++i)
+            silent = context.midi.getReadBuffer (i)->isEmpty();
+
+        if (! silent)
+        {
+            silentSamples = 0;
+            node->sleeping.set (0);
+            return false;
+        }
+
+        if (node->isSleeping())
+            return true;
+
+        silentSamples += numSamples;
+        const auto tail = node->getTailSeconds();
+        if (! std::isfinite (tail))
+            return false;
+
+        const auto tailSamples = (int64) std::ceil (tail * node->getSampleRate()) + node->getLatencySamples();
+        if (silentSamples <= tailSamples)
+            return false;
+
+        node->sleeping.set (1);
+        return true;
+    }
+
+    void collectBuffers (GraphOpBuffers& b) const override
+    {
+        for (const auto& index : audioChannelsToUse)
+            b.add (PortType::Audio, index);
+        for (const auto& index : cvChannelsToUse)
+            b.add (PortType::CV, index);
+        for (const auto& index : midiChannelsToUse)
+            b.add (PortType::Midi, index);
+        for (const auto& index : atomChannelsToUse)
+            b.add (PortType::Atom, index);
+    }
+
     const ProcessorPtr node;
     AudioProcessor* const processor;
 
@@ -653,6 +789,11 @@ private:
 
     std::unique_ptr<float*> osChans;
     int osChanSize = 0;
+
+    static constexpr float silenceLevel = 1.0e-6f; // about -120 dB
+    int64 silentSamples = 0;
+    double awakeTicksPerSample = 0.0;
+
     JUCE_DECLARE_NON_COPYABLE (ProcessBufferOp)
 };
 
@@ -668,13 +809,32 @@ GraphBuilder::GraphBuilder (GraphNode& graph_,
     {
         allNodes[i].add ((uint32) zeroNodeID); // first buffer is read-only zeros
         allPorts[i].add (EL_INVALID_PORT);
+        bufferUses[i].add (BufferUse());
+    }
+
+    for (int i = 0; i < orderedNodes.size(); ++i)
+        nodeSteps.set (((Processor*) orderedNodes.getUnchecked (i))->nodeId, i);
+
+    stepInputs.resize (orderedNodes.size());
+    stepOutputs.resize (orderedNodes.size());
+    for (int i = 0; i < graph.getNumConnections(); ++i)
+    {
+        const auto* const c = graph.getConnection (i);
+        if (nodeSteps.contains (c->destNode))
+            stepInputs.getReference (nodeSteps[c->destNode]).add (c);
+        if (nodeSteps.contains (c->sourceNode))
+            stepOutputs.getReference (nodeSteps[c->sourceNode]).add (c);
     }
 
     for (int i = 0; i < orderedNodes.size(); ++i)
     {
-        createRenderingOpsForNode ((Processor*) orderedNodes.getUnchecked (i),
-                                   renderingOps,
-                                   i);
+        auto node = (Processor*) orderedNodes.getUnchecked (i);
+        const int firstOp = renderingOps.size();
+
+        currentStep = i;
+        updateAncestors (i);
+        createRenderingOpsForNode (node, renderingOps, i);
+        addTask (node, renderingOps, firstOp);
         markUnusedBuffersFree (i);
     }
 
@@ -722,43 +882,159 @@ GraphBuilder::GraphBuilder (GraphNode& graph_,
 #endif
 }
 
-int GraphBuilder::buffersNeeded (PortType _type)
+bool GraphBuilder::hasConcurrentTasks() const noexcept
 {
-    const auto type = _type == PortType::CV ? PortType::Audio : _type;
-    return allNodes[type.id()].size();
+    int numRoots = 0;
+    for (const auto& task : tasks)
+    {
+        if (task.successors.size() > 1)
+            return true;
+        if (task.numDependencies == 0 && ++numRoots > 1)
+            return true;
+    }
+
+    return false;
+}
+
+void GraphBuilder::updateAncestors (const int step)
+{
+    BigInteger result;
+
+    for (const auto* const c : stepInputs.getReference (step))
+    {
+        if (! nodeSteps.contains (c->sourceNode))
+            continue;
+
+        // sources ordered after us are feedback loops and never share data.
+        const int sourceStep = nodeSteps[c->sourceNode];
+        if (sourceStep < step)
+        {
+            result |= ancestors.getReference (sourceStep);
+            result.setBit (sourceStep);
+        }
+    }
+
+    ancestors.add (result);
 }
 
-int GraphBuilder::getNodeDelay (const uint32 nodeID) const { return nodeDelays[nodeDelayIDs.indexOf (nodeID)]; }
+bool GraphBuilder::canReuseBuffer (PortType type, int bufferIndex) const noexcept
+{
+    // A free buffer is only handed to a node downstream of every node which
+    // used it. Reusing buffers across unrelated branches would force those
+    // branches to render one after the other.
+    const auto& uses = bufferUses[(type == PortType::CV ? PortType::Audio : type).id()];
+    if (! isPositiveAndBelow (bufferIndex, uses.size()))
+        return true;
+
+    const auto& ours = ancestors.getReference (currentStep);
+    const auto isUpstream = [&] (int step) { return step < 0 || step == currentStep || ours[step]; };
+    const auto& use = uses.getReference (bufferIndex);
+    if (! isUpstream (use.writer))
+        return false;
+    for (const auto step : use.readers)
+        if (! isUpstream (step))
+            return false;
+    return true;
+}
 
-void GraphBuilder::setNodeDelay (const uint32 nodeID, const int latency)
+void GraphBuilder::addTask (Processor* const node, const Array<void*>& renderingOps, int firstOp)
 {
-    const int index = nodeDelayIDs.indexOf (nodeID);
+    if (firstOp >= renderingOps.size())
+    {
+        stepTasks.add (-1);
+        return;
+    }
+
+    GraphTask task;
+    task.firstOp = firstOp;
+    task.numOps = renderingOps.size() - firstOp;
+    const int taskIndex = tasks.size();
+
+    GraphOpBuffers used;
+    for (int i = firstOp; i < renderingOps.size(); ++i)
+        static_cast<GraphOp*> (renderingOps.getUnchecked (i))->collectBuffers (used);
+
+    SortedSet<int> dependencies;
+    const auto dependOn = [&] (int step) {
+        if (step >= 0 && step != currentStep && stepTasks[step] >= 0)
+            dependencies.add (stepTasks[step]);
+    };
 
-    if (index >= 0)
+    for (int type = 0; type < PortType::Unknown; ++type)
     {
-        nodeDelays.set (index, latency);
+        auto& uses = bufferUses[type];
+        for (const auto& index : used.buffers[type])
+        {
+            // buffer zero is the shared read-only empty buffer.
+            if (index <= 0)
+                continue;
+
+            while (uses.size() <= index)
+                uses.add (BufferUse());
+
+            // reads only wait for the writer, so readers of one source can
+            // render together. A write waits for those readers as well.
+            auto& use = uses.getReference (index);
+            dependOn (use.writer);
+            if (used.writes[type].contains (index))
+            {
+                for (const auto step : use.readers)
+                    dependOn (step);
+                use.readers.clearQuick();
+                use.writer = currentStep;
+            }
+            else if (use.writer != currentStep)
+            {
+                use.readers.addIfNotAlreadyThere (currentStep);
+            }
+        }
     }
-    else
+
+    // IO nodes read and write the graph's own buffers.
+    if (node->isAudioIONode() || node->isMidiIONode())
     {
-        nodeDelayIDs.add (nodeID);
-        nodeDelays.add (latency);
+        if (lastIOTask >= 0)
+            dependencies.add (lastIOTask);
+        lastIOTask = taskIndex;
     }
+
+    for (const auto& dependency : dependencies)
+        tasks.getReference (dependency).successors.add (taskIndex);
+
+    task.numDependencies = dependencies.size();
+    tasks.add (task);
+    stepTasks.add (taskIndex);
+}
+
+int GraphBuilder::buffersNeeded (PortType _type)
+{
+    const auto type = _type == PortType::CV ? PortType::Audio : _type;
+    return allNodes[type.id()].size();
 }
 
-int GraphBuilder::getInputLatency (const uint32 nodeID) const
+int GraphBuilder::getNodeDelay (const uint32 nodeID) const { return nodeDelays[nodeID]; }
+
+void GraphBuilder::setNodeDelay (const uint32 nodeID, const int latency)
+{
+    nodeDelays.set (nodeID, latency);
+}
+
+int GraphBuilder::getInputLatency (const int step) const
 {
     int maxLatency = 0;
 
-    for (int i = graph.getNumConnections(); --i >= 0;)
-    {
-        const auto* const c = graph.getConnection (i);
-        if (c->destNode == nodeID)
-            maxLatency = jmax (maxLatency, getNodeDelay (c->sourceNode));
-    }
+    for (const auto* const c : stepInputs.getReference (step))
+        maxLatency = jmax (maxLatency, getNodeDelay (c->sourceNode));
 
     return maxLatency;
 }
 
+Processor* GraphBuilder::getNodeForId (const uint32 nodeId) const
+{
+    return nodeSteps.contains (nodeId) ? (Processor*) orderedNodes.getUnchecked (nodeSteps[nodeId])
+                                       : graph.getNodeForId (nodeId);
+}
+
 void GraphBuilder::createRenderingOpsForNode (Processor* const node,
                                               Array<void*>& renderingOps,
                                               const int ourRenderingIndex)
@@ -777,7 +1053,7 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
     }
 
     Array<int> channelsToUse[PortType::Unknown];
-    int maxLatency = getInputLatency (node->nodeId);
+    int maxLatency = getInputLatency (ourRenderingIndex);
 
     const uint32 numPorts (node->getNumPorts());
     for (uint32 port = 0; port < numPorts; ++port)
@@ -830,14 +1106,15 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
         Array<uint32> sourcePorts;
         Array<PortType> sourceTypes;
 
-        for (int i = graph.getNumConnections(); --i >= 0;)
+        const auto& inputs = stepInputs.getReference (ourRenderingIndex);
+        for (int i = inputs.size(); --i >= 0;)
         {
-            const auto* const c = graph.getConnection (i);
-            if (c->destNode == node->nodeId && c->destPort == port)
+            const auto* const c = inputs.getUnchecked (i);
+            if (c->destPort == port)
             {
                 sourceNodes.add (c->sourceNode);
                 sourcePorts.add (c->sourcePort);
-                auto src = graph.getNodeForId (c->sourceNode);
+                auto src = getNodeForId (c->sourceNode);
                 sourceTypes.add (src->getPortType (c->sourcePort));
             }
         }
@@ -880,7 +1157,7 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
             // port with a straight forward single input..
             const uint32 srcNode = sourceNodes.getUnchecked (0);
             const uint32 srcPort = sourcePorts.getUnchecked (0);
-            auto srcObj = graph.getNodeForId (srcNode);
+            auto srcObj = getNodeForId (srcNode);
             const auto srcType = srcObj->getPortType (srcPort);
 
             bufIndex = getBufferContaining (srcType, srcNode, srcPort);
@@ -893,18 +1170,21 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
                 jassert (bufIndex >= 0);
             }
 
-            const bool bufNeededLater = isBufferNeededLater (ourRenderingIndex, port, srcNode, srcPort);
+            // nodes on other branches reading the source would have to finish
+            // before this one could process it in place.
+            const bool bufNeededLater = isBufferNeededLater (ourRenderingIndex, port, srcNode, srcPort)
+                                        || (bufIndex > 0 && ! canReuseBuffer (srcType, bufIndex));
 
             if (portType == PortType::Control)
             {
-                auto src = graph.getNodeForId (srcNode);
+                auto src = getNodeForId (srcNode);
                 renderingOps.add (new BindParameterOp (
                     src->getParameter ((int) srcPort),
                     node->getParameter ((int) port)));
             }
             else if (srcType.isControl() && portType.isCv())
             {
-                auto src = graph.getNodeForId (srcNode);
+                auto src = getNodeForId (srcNode);
                 const int newFreeBuffer = getFreeBuffer (portType);
                 renderingOps.add (new ApplyParamToCVOp (src->getParameter ((int) srcPort), newFreeBuffer));
                 bufIndex = newFreeBuffer;
@@ -972,7 +1252,8 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
                     && ! isBufferNeededLater (ourRenderingIndex,
                                               port,
                                               sourceNodes.getUnchecked (i),
-                                              sourcePorts.getUnchecked (i)))
+                                              sourcePorts.getUnchecked (i))
+                    && (sourceBufIndex == 0 || canReuseBuffer (sourceTypes.getUnchecked (i), sourceBufIndex)))
                 {
                     // we've found one of our input chans that can be re-used..
                     reusableInputIndex = i;
@@ -1113,6 +1394,16 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
     if (node->isAudioIONode() && node->getNumPorts (PortType::Audio, false) == 0)
         totalLatency = maxLatency;
 
+    if (channelsToUse[PortType::Midi].isEmpty())
+    {
+        // nodes without MIDI get a private buffer so they never write to the
+        // read-only empty buffer, which is shared by every node in the graph.
+        const int bufIndex = getFreeBuffer (PortType::Midi);
+        markBufferAsContaining (bufIndex, PortType::Midi, anonymousNodeID, 0);
+        renderingOps.add (new ClearMidiBufferOp (bufIndex));
+        channelsToUse[PortType::Midi].add (bufIndex);
+    }
+
     int totalChans = jmax (node->getNumPorts (PortType::Audio, true),
                            node->getNumPorts (PortType::Audio, false));
     int totalCV = jmax (node->getNumPorts (PortType::CV, true),
@@ -1127,10 +1418,12 @@ int GraphBuilder::getFreeBuffer (PortType _type)
 
     Array<uint32>& nodes = allNodes[type.id()];
     for (int i = 1; i < nodes.size(); ++i)
-        if (nodes.getUnchecked (i) == freeNodeID)
+        if (nodes.getUnchecked (i) == freeNodeID && canReuseBuffer (type, i))
             return i;
 
     nodes.add ((uint32) freeNodeID);
+    while (bufferUses[type.id()].size() < nodes.size())
+        bufferUses[type.id()].add (BufferUse());
     return nodes.size() - 1;
 }
 
@@ -1173,48 +1466,18 @@ bool GraphBuilder::isBufferNeededLater (int stepIndexToSearchFrom,
                                         const uint32 sourceNode,
                                         const uint32 outputPortIndex) const
 {
-    while (stepIndexToSearchFrom < orderedNodes.size())
-    {
-        const Processor* const node = (const Processor*) orderedNodes.getUnchecked (stepIndexToSearchFrom);
-
-        {
-            for (uint32 port = 0; port < node->getNumPorts(); ++port)
-            {
-                if (port != inputChannelOfIndexToIgnore && graph.getConnectionBetween (sourceNode, outputPortIndex, node->nodeId, port) != nullptr)
-                {
-                    return true;
-                }
-            }
-        }
-
-        inputChannelOfIndexToIgnore = EL_INVALID_PORT;
-        ++stepIndexToSearchFrom;
-    }
-
-    return false;
-}
+    if (! nodeSteps.contains (sourceNode))
+        return false;
 
-bool GraphBuilder::isBufferNeededLater2 (int stepIndexToSearchFrom,
-                                         uint32 inputChannelOfIndexToIgnore,
-                                         const uint32 sourceNode,
-                                         const uint32 outputPortIndex) const
-{
-    while (stepIndexToSearchFrom < orderedNodes.size())
+    for (const auto* const c : stepOutputs.getReference (nodeSteps[sourceNode]))
     {
-        const Processor* const node = (const Processor*) orderedNodes.getUnchecked (stepIndexToSearchFrom);
-
-        {
-            for (uint32 port = 0; port < node->getNumPorts(); ++port)
-            {
-                if (port != inputChannelOfIndexToIgnore && graph.getConnectionBetween (sourceNode, outputPortIndex, node->nodeId, port) != nullptr)
-                {
-                    return true;
-                }
-            }
-        }
+        if (c->sourcePort != outputPortIndex || ! nodeSteps.contains (c->destNode))
+            continue;
 
-        inputChannelOfIndexToIgnore = EL_INVALID_PORT;
-        ++stepIndexToSearchFrom;
+        const int destStep = nodeSteps[c->destNode];
+        if (destStep > stepIndexToSearchFrom
+            || (destStep == stepIndexToSearchFrom && c->destPort != inputChannelOfIndexToIgnore))
+            return true;
     }
 
     return false;
@@ -11,6 +11,22 @@ class AtomBuffer;
 class GraphNode;
 class Processor;
 
+/** Shared buffer indexes touched by a GraphOp. */
+struct GraphOpBuffers
+{
+    Array<int> buffers[PortType::Unknown];
+    Array<int> writes[PortType::Unknown];
+
+    /** Add a buffer the op reads, and writes unless write is false. */
+    void add (PortType type, int index, bool write = true)
+    {
+        const auto t = type == PortType::CV ? PortType::Audio : type;
+        buffers[t.id()].addIfNotAlreadyThere (index);
+        if (write)
+            writes[t.id()].addIfNotAlreadyThere (index);
+    }
+};
+
 class GraphOp
 {
 public:
@@ -19,6 +35,11 @@ public:
 
     virtual std::string traceStep() const noexcept { return {}; }
 
+    /** Add the shared buffers this op reads or writes. Used to work out which
+        nodes can be rendered at the same time, so only mark a buffer read-only
+        when the op never changes it. */
+    virtual void collectBuffers (GraphOpBuffers&) const {}
+
     virtual void perform (juce::AudioSampleBuffer& sharedBufferChans,
                           const juce::OwnedArray<MidiBuffer>& sharedMidiBuffers,
                           const juce::OwnedArray<AtomBuffer>& sharedAtomBuffers,
@@ -28,6 +49,19 @@ private:
     JUCE_LEAK_DETECTOR (GraphOp)
 };
 
+/** A contiguous run of rendering ops which process a single node.
+
+    Tasks only share buffers with the tasks they depend on, so any task whose
+    dependencies have completed can be performed concurrently with others.
+ */
+struct GraphTask
+{
+    int firstOp = 0;
+    int numOps = 0;
+    int numDependencies = 0;
+    Array<int> successors;
+};
+
 /** Used to calculate the correct sequence of rendering ops needed, based on
     the best re-use of shared buffers at each stage. */
 class GraphBuilder
@@ -40,6 +74,12 @@ public:
     int buffersNeeded (PortType type);
     int getTotalLatencySamples() const { return totalLatency; }
 
+    /** Returns the rendering ops grouped per node in dependency order. */
+    const Array<GraphTask>& getTasks() const noexcept { return tasks; }
+
+    /** Returns true if at least two tasks could run at the same time. */
+    bool hasConcurrentTasks() const noexcept;
+
 private:
     //==============================================================================
     GraphNode& graph;
@@ -57,14 +97,34 @@ private:
 
     static bool isNodeBusy (uint32 nodeID) noexcept { return nodeID != freeNodeID && nodeID != zeroNodeID; }
 
-    Array<uint32> nodeDelayIDs;
-    Array<int> nodeDelays;
+    HashMap<uint32, int> nodeDelays;
     int totalLatency;
 
+    Array<GraphTask> tasks;
+    Array<BigInteger> ancestors;
+    /** The last step to write a shared buffer, and the steps which have
+        read it since. */
+    struct BufferUse
+    {
+        int writer = -1;
+        Array<int> readers;
+    };
+    Array<BufferUse> bufferUses[PortType::Unknown];
+    Array<int> stepTasks;
+    HashMap<uint32, int> nodeSteps;
+    Array<Array<const Arc*>> stepInputs, stepOutputs;
+    int currentStep = 0;
+    int lastIOTask = -1;
+
+    void updateAncestors (const int step);
+    bool canReuseBuffer (PortType type, int bufferIndex) const noexcept;
+    void addTask (Processor* const node, const Array<void*>& renderingOps, int firstOp);
+
     int getNodeDelay (const uint32 nodeID) const;
     void setNodeDelay (const uint32 nodeID, const int latency);
 
-    int getInputLatency (const uint32 nodeID) const;
+    int getInputLatency (const int step) const;
+    Processor* getNodeForId (const uint32 nodeId) const;
 
     void createRenderingOpsForNode (Processor* const node, Array<void*>& renderingOps, const int ourRenderingIndex);
 
@@ -73,7 +133,6 @@ private:
     int getBufferContaining (const PortType type, const uint32 nodeId, const uint32 outputPort) noexcept;
     void markUnusedBuffersFree (const int stepIndex);
     bool isBufferNeededLater (int stepIndexToSearchFrom, uint32 inputChannelOfIndexToIgnore, const uint32 sourceNode, const uint32 outputPortIndex) const;
-    bool isBufferNeededLater2 (int stepIndexToSearchFrom, uint32 inputChannelOfIndexToIgnore, const uint32 sourceNode, const uint32 outputPortIndex) const;
 
     void markBufferAsContaining (int bufferNum, PortType type, uint32 nodeId, uint32 portIndex);
 
@@ -183,7 +183,8 @@ private:
             data.addChild (newPorts, index, nullptr);
             manager.removeIllegalConnections();
         }
-        if (object->isGraph())
+        // the IO nodes and arcs are settled when loading finishes.
+        if (object->isGraph() && ! manager.isLoading())
         {
             IONodeEnforcer enforce (manager);
         }
@@ -193,6 +194,191 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NodeModelUpdater)
 };
 
+//==============================================================================
+/** Creates the processors for a graph model without blocking the message
+    thread. Nodes which can be created off the message thread are instantiated
+    and have their state restored on a small thread pool, audio plugin formats
+    load with their async instantiation, and the rest are created one per
+    message. Items are handed to the loaded callback on the message thread in
+    the order they become ready, then finished is called once.
+ */
+class NodeLoader : private AsyncUpdater
+{
+public:
+    struct Item
+    {
+        Node node;
+        PluginDescription desc;
+        ProcessorPtr object;
+        String error;
+        bool background = false;
+        bool async = false;
+        bool restored = false;
+        int program = -1;
+        var state;
+    };
+
+    NodeLoader (PluginManager& pm, std::function<void (Item&)> loadedCallback, std::function<void()> finishedCallback)
+        : plugins (pm), loaded (loadedCallback), finished (finishedCallback) {}
+
+    ~NodeLoader()
+    {
+        cancelPendingUpdate();
+        if (pool != nullptr)
+            pool->removeAllJobs (true, -1);
+    }
+
+    /** Queue a node model for loading. */
+    void add (const Node& node)
+    {
+        auto* item = items.add (new Item());
+        item->node = node;
+        item->desc = plugins.findDescriptionFor (node);
+        item->background = plugins.canCreateGraphNodeInBackground (item->desc);
+        item->async = ! item->background && item->desc.pluginFormatName != "Internal"
+                      && plugins.getAudioPluginFormat (item->desc.pluginFormatName) != nullptr;
+        if (item->background)
+        {
+            // copy what the job needs so it never touches the model.
+            item->program = (int) node.getProperty (tags::program, -1);
+            item->state = node.getProperty (tags::state);
+            ++numBackground;
+        }
+    }
+
+    /** Start loading the queued items. Nothing is handed back before the
+        next message loop iteration. */
+    void start()
+    {
+        if (numBackground > 0)
+        {
+            pool = std::make_unique<ThreadPool> (jlimit (1, 4, numBackground));
+            for (auto* item : items)
+                if (item->background)
+                    pool->addJob (new Job (*this, *item), true);
+        }
+
+        for (auto* item : items)
+        {
+            if (! item->async)
+                continue;
+            WeakReference<NodeLoader> self (this);
+            plugins.createGraphNodeAsync (item->desc, [self, item] (Processor* node, const String& error) {
+                ProcessorPtr obj (node);
+                if (self == nullptr)
+                    return;
+                item->error = error;
+                self->itemReady (*item, obj);
+            });
+        }
+
+        triggerAsyncUpdate();
+    }
+
+private:
+    PluginManager& plugins;
+    std::function<void (Item&)> loaded;
+    std::function<void()> finished;
+    OwnedArray<Item> items;
+    int numBackground = 0, nextIndex = 0, numReturned = 0;
+    std::unique_ptr<ThreadPool> pool;
+    CriticalSection lock;
+    Array<Item*> ready;
+
+    /** Called from any thread when an item's object has been created. */
+    void itemReady (Item& item, ProcessorPtr obj)
+    {
+        {
+            const ScopedLock sl (lock);
+            item.object = obj;
+            ready.add (&item);
+        }
+
+        triggerAsyncUpdate();
+    }
+
+    void handleAsyncUpdate() override
+    {
+        WeakReference<NodeLoader> self (this);
+
+        for (;;)
+        {
+            Item* item = nullptr;
+            {
+                const ScopedLock sl (lock);
+                item = ready.removeAndReturn (0);
+            }
+
+            if (item == nullptr)
+                break;
+
+            ++numReturned;
+            loaded (*item);
+            if (self == nullptr)
+                return;
+        }
+
+        // create one message thread item at a time so the UI keeps running.
+        while (nextIndex < items.size() && (items.getUnchecked (nextIndex)->background || items.getUnchecked (nextIndex)->async))
+            ++nextIndex;
+
+        if (auto* item = items[nextIndex++])
+        {
+            item->object = plugins.createGraphNode (item->desc, item->error);
+            ++numReturned;
+            loaded (*item);
+            if (self == nullptr)
+                return;
+        }
+
+        if (nextIndex < items.size())
+        {
+            triggerAsyncUpdate();
+        }
+        else if (numReturned == items.size())
+        {
+            // this might delete the loader, so call a copy.
+            auto done = finished;
+            done();
+        }
+    }
+
+    class Job : public ThreadPoolJob
+    {
+    public:
+        Job (NodeLoader& l, Item& i)
+            : ThreadPoolJob (i.desc.name), loader (l), item (i) {}
+
+        JobStatus runJob() override
+        {
+            ProcessorPtr obj = loader.plugins.createGraphNode (item.desc, item.error);
+            if (obj != nullptr && obj->getAudioProcessor() == nullptr)
+            {
+                // The node isn't in a graph yet, so nothing else can be
+                // using it while the state is applied.
+                if (isPositiveAndBelow (item.program, obj->getNumPrograms()))
+                    obj->setCurrentProgram (item.program);
+
+                MemoryBlock block;
+                if (Node::decodeState (item.state, block))
+                    obj->setState (block.getData(), (int) block.getSize());
+
+                item.restored = true;
+            }
+
+            loader.itemReady (item, obj);
+            return jobHasFinished;
+        }
+
+    private:
+        NodeLoader& loader;
+        Item& item;
+    };
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (NodeLoader)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NodeLoader)
+};
+
 //==============================================================================
 class GraphManager::Binding
 {
@@ -211,8 +397,14 @@ public:
             auto sub = dynamic_cast<GraphNode*> (object.get());
             jassert (sub);
             manager = std::make_unique<GraphManager> (*sub, owner.pluginManager);
+            manager->sigNodeLoaded.connect ([this] (const Node& n) { owner.sigNodeLoaded (n); });
+            manager->sigLoaded.connect ([this]() { subGraphLoaded(); });
+
+            // the owner waits for sub graphs before restoring its arcs.
+            waiting = owner.isLoading();
+            if (waiting)
+                ++owner.numSubGraphsLoading;
             manager->setNodeModel (node);
-            IONodeEnforcer addIO (*manager);
         }
         else
         {
@@ -234,6 +426,9 @@ public:
             manager.reset();
         }
 
+        if (std::exchange (waiting, false))
+            owner.subGraphLoaded();
+
         node = Node();
         Node::sanitizeRuntimeProperties (data);
         data = ValueTree();
@@ -258,7 +453,16 @@ private:
     Node node;
     ValueTree data;
     std::unique_ptr<GraphManager> manager;
+    bool waiting = false;
     [[maybe_unused]] UndoManager* undo = nullptr;
+
+    void subGraphLoaded()
+    {
+        // IO nodes were added after this node's ports were first read.
+        node.resetPorts();
+        if (std::exchange (waiting, false))
+            owner.subGraphLoaded();
+    }
 };
 
 //==============================================================================
@@ -269,6 +473,7 @@ GraphManager::GraphManager (GraphNode& pg, PluginManager& pm)
 
 GraphManager::~GraphManager()
 {
+    cancelLoading();
     // Make sure to dereference Processor's so we don't leak memory
     // If you get warnings by juce's leak detector about graph related
     // objects, then there's probably "object" properties lingering that
@@ -317,6 +522,17 @@ bool GraphManager::contains (const uint32 nodeId) const
 
 Processor* GraphManager::createFilter (const PluginDescription* desc, double x, double y, uint32 nodeId)
 {
+    // nodes still loading own their ids already.
+    if (loading && (nodeId == 0 || nodeId == EL_INVALID_NODE))
+    {
+        nodeId = 0;
+        for (const auto& child : nodes)
+            nodeId = jmax (nodeId, (uint32) (int64) child.getProperty (tags::id));
+        for (int i = processor.getNumNodes(); --i >= 0;)
+            nodeId = jmax (nodeId, processor.getNode (i)->nodeId);
+        ++nodeId;
+    }
+
     String errorMessage;
     auto node = std::unique_ptr<Processor> (
         pluginManager.createGraphNode (*desc, errorMessage));
@@ -489,7 +705,16 @@ uint32 GraphManager::addNode (const PluginDescription* desc, double rx, double r
 void GraphManager::removeNode (const uint32 uid)
 {
     if (! processor.removeNode (uid))
+    {
+        // not attached yet, drop the model so the loader skips it.
+        if (loading)
+        {
+            const Node pending (Node (graph, false).getNodeById (uid));
+            if (pending.isValid() && pending.data().getParent() == nodes)
+                nodes.removeChild (pending.data(), nullptr);
+        }
         return;
+    }
     for (int i = 0; i < nodes.getNumChildren(); ++i)
     {
         const Node node (nodes.getChild (i), false);
@@ -557,7 +782,8 @@ void GraphManager::removeIllegalConnections()
 
 int GraphManager::getNumConnections() const noexcept
 {
-    jassert (arcs.getNumChildren() == processor.getNumConnections());
+    // the model's arcs are rebuilt when loading finishes.
+    jassert (loading || arcs.getNumChildren() == processor.getNumConnections());
     return processor.getNumConnections();
 }
 
@@ -599,7 +825,9 @@ void GraphManager::removeConnection (uint32 sourceNode, uint32 sourcePort, uint3
 
 void GraphManager::setNodeModel (const Node& node)
 {
+    cancelLoading();
     loaded = false;
+    loading = true;
 
     processor.clear();
     graph = node.data();
@@ -614,36 +842,64 @@ void GraphManager::setNodeModel (const Node& node)
 
     graph.setProperty (tags::updater, new NodeModelUpdater (*this, graph, &processor), nullptr);
 
-    Array<ValueTree> failed;
+    loader = std::make_unique<NodeLoader> (
+        pluginManager,
+        [this] (NodeLoader::Item& item) {
+            attachNode (item.node, item.object, item.restored, item.error);
+            item.object = nullptr;
+        },
+        [this]() { nodesLoaded(); });
     for (int i = 0; i < nodes.getNumChildren(); ++i)
+        loader->add (Node (nodes.getChild (i), false));
+    loader->start();
+}
+
+void GraphManager::attachNode (const Node& model, ProcessorPtr object, bool restored, const String& error)
+{
+    Node node (model);
+
+    // removed from the graph while it was loading.
+    if (node.data().getParent() != nodes)
     {
-        Node node (nodes.getChild (i), false);
-        const PluginDescription desc (pluginManager.findDescriptionFor (node));
-        if (ProcessorPtr obj = createFilter (&desc, 0, 0, node.getNodeId()))
-        {
-            setupNode (node.data(), obj);
-            obj->setEnabled (node.isEnabled());
-            node.setProperty (tags::enabled, obj->isEnabled());
-        }
-        else if (ProcessorPtr ph = createPlaceholder (node))
-        {
-            DBG ("[element] couldn't create node: " << node.getName() << ". Creating offline placeholder");
-            node.data().setProperty (tags::object, ph.get(), nullptr);
-            node.data().setProperty (tags::missing, true, nullptr);
-        }
-        else
-        {
-            DBG ("[element] couldn't create node: " << node.getName());
-            failed.add (node.data());
-        }
+        Node::sanitizeRuntimeProperties (node.data());
+        return;
+    }
+
+    if (error.isNotEmpty())
+        std::cerr << "[element] error creating audio plugin: " << error.toStdString() << std::endl;
+
+    ProcessorPtr obj = object != nullptr ? processor.addNode (object.get(), node.getNodeId())
+                                         : nullptr;
+
+    if (obj != nullptr)
+    {
+        setupNode (node.data(), obj, ! restored);
+        obj->setEnabled (node.isEnabled());
+        node.setProperty (tags::enabled, obj->isEnabled());
+        sigNodeLoaded (node);
     }
+    else if (ProcessorPtr ph = createPlaceholder (node))
+    {
+        DBG ("[element] couldn't create node: " << node.getName() << ". Creating offline placeholder");
+        node.data().setProperty (tags::object, ph.get(), nullptr);
+        node.data().setProperty (tags::missing, true, nullptr);
+        sigNodeLoaded (node);
+    }
+    else
+    {
+        DBG ("[element] couldn't create node: " << node.getName());
+        failedNodes.add (node.data());
+    }
+}
 
-    for (const auto& n : failed)
+void GraphManager::nodesLoaded()
+{
+    for (const auto& n : failedNodes)
     {
         nodes.removeChild (n, nullptr);
         Node::sanitizeRuntimeProperties (n);
     }
-    failed.clearQuick();
+    failedNodes.clearQuick();
 
     // If you hit this, then failed nodes didn't get handled properly
     jassert (nodes.getNumChildren() == processor.getNumNodes());
@@ -652,6 +908,22 @@ void GraphManager::setNodeModel (const Node& node)
     processor.triggerAsyncUpdate();
     processor.handleUpdateNowIfNeeded();
 
+    // safe, the loader doesn't touch itself after this callback.
+    loader.reset();
+    if (numSubGraphsLoading == 0)
+        finishLoading();
+}
+
+void GraphManager::subGraphLoaded()
+{
+    jassert (numSubGraphsLoading > 0);
+    if (--numSubGraphsLoading == 0 && loading && loader == nullptr)
+        finishLoading();
+}
+
+void GraphManager::finishLoading()
+{
+    Array<ValueTree> failed;
     for (int i = 0; i < arcs.getNumChildren(); ++i)
     {
         ValueTree arc (arcs.getChild (i));
@@ -665,7 +937,11 @@ void GraphManager::setNodeModel (const Node& node)
             DBG("connection " << src->getName() << " to " << dst->getName());
         }
 #endif
-        bool worked = processor.addConnection (sourceNode, (uint32) (int) arc.getProperty (tags::sourcePort), destNode, (uint32) (int) arc.getProperty (tags::destPort));
+        const auto sourcePort = (uint32) (int) arc.getProperty (tags::sourcePort);
+        const auto destPort = (uint32) (int) arc.getProperty (tags::destPort);
+        // it may have been connected again while loading.
+        bool worked = processor.getConnectionBetween (sourceNode, sourcePort, destNode, destPort) != nullptr
+                      || processor.addConnection (sourceNode, sourcePort, destNode, destPort);
 
         if (worked)
         {
@@ -695,12 +971,25 @@ void GraphManager::setNodeModel (const Node& node)
         for (const auto& n : failed)
             arcs.removeChild (n, nullptr);
 
+    loading = false;
     loaded = true;
-    jassert (arcs.getNumChildren() == processor.getNumConnections());
     failed.clearQuick();
 
+    // connections made while loading are only in the processor, this picks
+    // them up along with the ones restored above.
     IONodeEnforcer enforceIONodes (*this);
     processorArcsChanged();
+    sigLoaded();
+}
+
+void GraphManager::cancelLoading()
+{
+    loader.reset();
+    failedNodes.clearQuick();
+    for (auto* binding : bindings)
+        binding->waiting = false;
+    numSubGraphsLoading = 0;
+    loading = false;
 }
 
 void GraphManager::savePluginStates()
@@ -715,6 +1004,7 @@ void GraphManager::savePluginStates()
 void GraphManager::clear()
 {
     loaded = false;
+    cancelLoading();
 
     if (graph.isValid())
     {
@@ -733,6 +1023,10 @@ void GraphManager::clear()
 
 void GraphManager::processorArcsChanged()
 {
+    // the model's arcs aren't connected yet.
+    if (loading)
+        return;
+
     ValueTree newArcs = ValueTree (tags::arcs);
     for (int i = 0; i < processor.getNumConnections(); ++i)
         newArcs.addChild (Node::makeArc (*processor.getConnection (i)), -1, nullptr);
@@ -763,7 +1057,7 @@ void GraphManager::processorArcsChanged()
     changed();
 }
 
-void GraphManager::setupNode (const ValueTree& data, ProcessorPtr obj)
+void GraphManager::setupNode (const ValueTree& data, ProcessorPtr obj, bool restoreState)
 {
     jassert (obj && data.hasType (types::Node));
     Node node (data, false);
@@ -837,7 +1131,7 @@ void GraphManager::setupNode (const ValueTree& data, ProcessorPtr obj)
         resetPorts = true;
     }
 
-    node.restorePluginState();
+    node.restorePluginState (restoreState);
     node.resetPorts();
     if (node.isA ("Element", EL_NODE_ID_MIDI_INPUT_DEVICE) || node.isA ("Element", EL_NODE_ID_MIDI_OUTPUT_DEVICE))
     {
@@ -9,6 +9,7 @@
 
 namespace element {
 
+class NodeLoader;
 class PluginManager;
 class RootGraph;
 
@@ -78,6 +79,12 @@ public:
 
     void clear();
 
+    /** Load a graph model without blocking. Nodes that can be created off
+        the message thread are instantiated on a thread pool, audio plugins
+        load asynchronously and the rest are created one per message. Each is
+        attached as soon as it is ready and the arcs are connected once every
+        node and sub graph has loaded, see sigLoaded.
+     */
     void setNodeModel (const Node& node);
     inline Node getGraphModel() const { return Node (graph, false); }
 
@@ -92,11 +99,26 @@ public:
 
     inline bool isLoaded() const { return loaded; }
 
+    /** Returns true while a model set with setNodeModel is still loading. */
+    inline bool isLoading() const { return loading; }
+
+    /** Emitted as each node is attached while loading a model, including
+        nodes of sub graphs. */
+    Signal<void (const Node&)> sigNodeLoaded;
+
+    /** Emitted when a model set with setNodeModel has finished loading,
+        sub graphs included. */
+    Signal<void()> sigLoaded;
+
 private:
     PluginManager& pluginManager;
     GraphNode& processor;
     ValueTree graph, arcs, nodes;
     bool loaded = false;
+    bool loading = false;
+    std::unique_ptr<NodeLoader> loader;
+    Array<ValueTree> failedNodes;
+    int numSubGraphsLoading = 0;
 
     uint32 lastUID;
 
@@ -109,7 +131,13 @@ private:
     Processor* createFilter (const PluginDescription* desc, double x = 0.0f, double y = 0.0f, uint32 nodeId = 0);
     Processor* createPlaceholder (const Node& node);
 
-    void setupNode (const ValueTree& data, ProcessorPtr object);
+    void setupNode (const ValueTree& data, ProcessorPtr object, bool restoreState = true);
+
+    void attachNode (const Node& node, ProcessorPtr object, bool restored, const String& error);
+    void nodesLoaded();
+    void subGraphLoaded();
+    void finishLoading();
+    void cancelLoading();
 
     void processorArcsChanged();
 
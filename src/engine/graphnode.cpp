@@ -1,6 +1,8 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <thread>
+
 #include <element/audioengine.hpp>
 #include <element/midipipe.hpp>
 #include <element/node.hpp>
@@ -10,6 +12,7 @@
 
 #include "engine/graphbuilder.hpp"
 #include "engine/ionode.hpp"
+#include "engine/renderpool.hpp"
 #include "nodes/audioprocessor.hpp"
 #include "engine/miditranspose.hpp"
 #include "nodes/nodetypes.hpp"
@@ -21,6 +24,139 @@
 
 namespace element {
 
+static void deleteRenderOpArray (Array<void*>& ops)
+{
+    for (int i = ops.size(); --i >= 0;)
+        delete static_cast<GraphOp*> (ops.getUnchecked (i));
+    ops.clearQuick();
+}
+
+/** The rendering ops of a graph and the shared buffers they render into.
+
+    A program is built off the audio thread and is never changed once it has
+    been handed to the renderer, other than the contents of its buffers.
+ */
+struct GraphNode::RenderProgram
+{
+    RenderProgram() = default;
+    ~RenderProgram();
+
+    Array<void*> ops;
+    AudioSampleBuffer audio { 1, 1 };
+    OwnedArray<MidiBuffer> midi;
+    OwnedArray<AtomBuffer> atom;
+    std::unique_ptr<ParallelRender> parallel;
+
+    JUCE_DECLARE_NON_COPYABLE (RenderProgram)
+};
+
+/** Performs the rendering ops of a graph on the render pool.
+
+    Tasks are handed out through a lock-free ready queue. Every task is queued
+    exactly once per block, so the queue never needs more slots than there are
+    tasks.
+ */
+class GraphNode::ParallelRender final : public RenderPool::Job
+{
+public:
+    ParallelRender (RenderProgram& p, const Array<GraphTask>& t)
+        : program (p),
+          tasks (t),
+          numTasks (t.size()),
+          pending (new std::atomic<int>[(size_t) t.size()]),
+          ready (new std::atomic<int>[(size_t) t.size()])
+    {
+    }
+
+    /** Reset the queue for a new block. Call before handing this to the pool. */
+    void prepare (RenderPool& newPool, int newNumSamples) noexcept
+    {
+        pool = &newPool;
+        numSamples = newNumSamples;
+        readPos.store (0, std::memory_order_relaxed);
+        writePos.store (0, std::memory_order_relaxed);
+        finished.store (0, std::memory_order_relaxed);
+
+        for (int i = 0; i < numTasks; ++i)
+        {
+            ready[i].store (-1, std::memory_order_relaxed);
+            pending[i].store (tasks.getReference (i).numDependencies, std::memory_order_relaxed);
+        }
+
+        for (int i = 0; i < numTasks; ++i)
+            if (tasks.getReference (i).numDependencies == 0)
+                push (i);
+    }
+
+    void perform() noexcept override
+    {
+        while (finished.load (std::memory_order_acquire) < numTasks)
+        {
+            const int index = pop();
+            if (index < 0)
+            {
+                // a node might be fanning work out to the pool.
+                if (! pool->helpWithTasks())
+                    std::this_thread::yield();
+                continue;
+            }
+
+            const auto& task = tasks.getReference (index);
+            for (int i = task.firstOp; i < task.firstOp + task.numOps; ++i)
+            {
+                auto op = static_cast<GraphOp*> (program.ops.getUnchecked (i));
+                op->perform (program.audio, program.midi, program.atom, numSamples);
+            }
+
+            for (const auto& next : task.successors)
+                if (pending[next].fetch_sub (1, std::memory_order_acq_rel) == 1)
+                    push (next);
+
+            finished.fetch_add (1, std::memory_order_release);
+        }
+    }
+
+private:
+    RenderProgram& program;
+    const Array<GraphTask> tasks;
+    const int numTasks;
+    std::unique_ptr<std::atomic<int>[]> pending;
+    std::unique_ptr<std::atomic<int>[]> ready;
+    std::atomic<int> readPos { 0 }, writePos { 0 }, finished { 0 };
+    RenderPool* pool = nullptr;
+    int numSamples = 0;
+
+    void push (int index) noexcept
+    {
+        const int slot = writePos.fetch_add (1, std::memory_order_acq_rel);
+        ready[slot].store (index, std::memory_order_release);
+    }
+
+    int pop() noexcept
+    {
+        int slot = readPos.load (std::memory_order_acquire);
+        while (slot < writePos.load (std::memory_order_acquire))
+        {
+            if (readPos.compare_exchange_weak (slot, slot + 1, std::memory_order_acq_rel))
+            {
+                // claimed, but the writer may not have stored the index yet.
+                int index;
+                while ((index = ready[slot].load (std::memory_order_acquire)) < 0)
+                    std::this_thread::yield();
+                return index;
+            }
+        }
+
+        return -1;
+    }
+};
+
+GraphNode::RenderProgram::~RenderProgram()
+{
+    parallel.reset();
+    deleteRenderOpArray (ops);
+}
+
 GraphNode::Connection::Connection (const uint32 sourceNode_, const uint32 sourcePort_, const uint32 destNode_, const uint32 destPort_) noexcept
     : Arc (sourceNode_, sourcePort_, destNode_, destPort_) {}
 
@@ -31,7 +167,6 @@ GraphNode::GraphNode (Context& c)
                      .toPortList()),
       _context (c),
       lastNodeId (0),
-      renderingBuffers (1, 1),
       currentAudioInputBuffer (nullptr),
       currentAudioOutputBuffer (1, 1),
       currentMidiInputBuffer (nullptr)
@@ -44,8 +179,14 @@ GraphNode::GraphNode (Context& c)
 GraphNode::~GraphNode()
 {
     renderingSequenceChanged.disconnect_all_slots();
+    stopTimer();
     clearRenderingSequence();
     clear();
+
+    jassert (programInUse.load() == nullptr);
+    for (auto* retired : retiredPrograms)
+        delete retired;
+    retiredPrograms.clear();
 }
 
 void GraphNode::clear()
@@ -102,6 +243,7 @@ Processor* GraphNode::addNode (Processor* newNode, uint32 nodeId)
     }
 
     newNode->setPlayHead (playhead);
+    newNode->setNonRealtime (isNonRealtime());
     newNode->setParentGraph (this);
     newNode->refreshPorts();
     if (prepared())
@@ -357,23 +499,48 @@ void GraphNode::setVelocityCurveMode (const VelocityCurve::Mode mode) noexcept
     velocityCurve.setMode (mode);
 }
 
-static void deleteRenderOpArray (Array<void*>& ops)
+void GraphNode::clearRenderingSequence()
 {
-    for (int i = ops.size(); --i >= 0;)
-        delete static_cast<GraphOp*> (ops.getUnchecked (i));
-    ops.clearQuick();
+    swapRenderProgram (nullptr);
 }
 
-void GraphNode::clearRenderingSequence()
+void GraphNode::swapRenderProgram (RenderProgram* newProgram)
+{
+    if (auto* old = program.exchange (newProgram))
+    {
+        const ScopedLock sl (retiredLock);
+        retiredPrograms.add (old);
+    }
+
+    reclaimRenderPrograms();
+}
+
+void GraphNode::reclaimRenderPrograms()
 {
-    Array<void*> oldOps;
+    Array<RenderProgram*> unused;
 
     {
-        const ScopedLock sl (seqLock);
-        renderingOps.swapWith (oldOps);
+        const ScopedLock sl (retiredLock);
+        // a retired program can't be picked up again, so anything the
+        // renderer isn't holding right now is safe to delete.
+        auto* const inUse = programInUse.load();
+        for (int i = retiredPrograms.size(); --i >= 0;)
+            if (retiredPrograms.getUnchecked (i) != inUse)
+                unused.add (retiredPrograms.removeAndReturn (i));
+
+        if (retiredPrograms.isEmpty())
+            stopTimer();
+        else if (! isTimerRunning())
+            startTimer (50);
     }
 
-    deleteRenderOpArray (oldOps);
+    for (auto* old : unused)
+        delete old;
+}
+
+void GraphNode::timerCallback()
+{
+    reclaimRenderPrograms();
 }
 
 bool GraphNode::isAnInputTo (const uint32 possibleInputId,
@@ -398,83 +565,94 @@ bool GraphNode::isAnInputTo (const uint32 possibleInputId,
 
 void GraphNode::buildRenderingSequence()
 {
-    Array<void*> newRenderingOps;
-    int numRenderingBuffersNeeded = 2;
-    int numMidiBuffersNeeded = 1;
-    int numAtomBuffersNeeded = 1;
+    auto newProgram = std::make_unique<RenderProgram>();
 
     {
-        //XXX:
-        //MessageManagerLock mml;
-
         Array<void*> orderedNodes;
+        sortNodes (orderedNodes);
 
-        {
-            const LookupTable table (connections);
-
-            for (int i = 0; i < nodes.size(); ++i)
-            {
-                Processor* const node = nodes.getUnchecked (i);
-
-                int j = 0;
-                for (; j < orderedNodes.size(); ++j)
-                    if (table.isAnInputTo (node->nodeId, ((Processor*) orderedNodes.getUnchecked (j))->nodeId))
-                        break;
-
-                orderedNodes.insert (j, node);
-            }
-        }
-
-        GraphBuilder builder (*this, orderedNodes, newRenderingOps);
-        numRenderingBuffersNeeded = builder.buffersNeeded (PortType::Audio);
-        numMidiBuffersNeeded = builder.buffersNeeded (PortType::Midi);
-        numAtomBuffersNeeded = builder.buffersNeeded (PortType::Atom);
+        GraphBuilder builder (*this, orderedNodes, newProgram->ops);
         setLatencySamples (builder.getTotalLatencySamples());
-    }
 
-    {
-        // swap over to the new rendering sequence..
-        {
-            const ScopedLock sl (getPropertyLock());
-            renderingBuffers.setSize (numRenderingBuffersNeeded, 4096);
-            renderingBuffers.clear();
-            for (auto ab : atomBuffers)
-                ab->clear();
-            for (int i = midiBuffers.size(); --i >= 0;)
-                midiBuffers.getUnchecked (i)->clear();
-
-            while (midiBuffers.size() < numMidiBuffersNeeded)
-                midiBuffers.add (new MidiBuffer());
-            while (atomBuffers.size() < numAtomBuffersNeeded)
-            {
-                auto ab = atomBuffers.add (new AtomBuffer());
-                ab->setTypes (_context.symbols());
-            }
-        }
+        // buffers belong to the program, so nothing the renderer is
+        // currently using gets resized here.
+        newProgram->audio.setSize (builder.buffersNeeded (PortType::Audio), 4096);
+        newProgram->audio.clear();
 
-        ScopedLock sl (seqLock);
-        renderingOps.swapWith (newRenderingOps);
-    }
+        for (int i = builder.buffersNeeded (PortType::Midi); --i >= 0;)
+            newProgram->midi.add (new MidiBuffer());
+        for (int i = builder.buffersNeeded (PortType::Atom); --i >= 0;)
+            newProgram->atom.add (new AtomBuffer())->setTypes (_context.symbols());
 
-    // delete the old ones..
-    deleteRenderOpArray (newRenderingOps);
+        if (builder.hasConcurrentTasks())
+            newProgram->parallel = std::make_unique<ParallelRender> (*newProgram, builder.getTasks());
+    }
 
+    swapRenderProgram (newProgram.release());
     renderingSequenceChanged();
 }
 
 void GraphNode::getOrderedNodes (ReferenceCountedArray<Processor>& orderedNodes)
 {
-    const LookupTable table (connections);
+    Array<void*> sorted;
+    sortNodes (sorted);
+    for (auto* node : sorted)
+        orderedNodes.add ((Processor*) node);
+}
+
+void GraphNode::sortNodes (Array<void*>& orderedNodes) const
+{
+    // Kahn's algorithm. Ready nodes are taken in the order they were added to
+    // the graph so the result is stable between rebuilds.
+    HashMap<uint32, int> indexes (jmax (101, nodes.size() * 2));
     for (int i = 0; i < nodes.size(); ++i)
+        indexes.set (nodes.getUnchecked (i)->nodeId, i);
+
+    Array<int> numInputs;
+    numInputs.insertMultiple (0, 0, nodes.size());
+    Array<Array<int>> destinations;
+    destinations.resize (nodes.size());
+
+    for (const auto* const c : connections)
     {
-        Processor* const node = nodes.getUnchecked (i);
+        if (! indexes.contains (c->sourceNode) || ! indexes.contains (c->destNode))
+            continue;
+        const int dest = indexes[c->destNode];
+        destinations.getReference (indexes[c->sourceNode]).add (dest);
+        ++numInputs.getReference (dest);
+    }
 
-        int j = 0;
-        for (; j < orderedNodes.size(); ++j)
-            if (table.isAnInputTo (node->nodeId, ((Processor*) orderedNodes.getUnchecked (j))->nodeId))
-                break;
+    SortedSet<int> ready;
+    for (int i = 0; i < nodes.size(); ++i)
+        if (numInputs.getUnchecked (i) == 0)
+            ready.add (i);
+
+    BigInteger done;
+    int nextUnsorted = 0;
+    orderedNodes.ensureStorageAllocated (nodes.size());
 
-        orderedNodes.insert (j, node);
+    while (orderedNodes.size() < nodes.size())
+    {
+        int index;
+        if (ready.size() > 0)
+        {
+            index = ready.getFirst();
+            ready.remove (0);
+        }
+        else
+        {
+            // only feedback loops are left, break one at its earliest node.
+            while (done[nextUnsorted])
+                ++nextUnsorted;
+            index = nextUnsorted;
+        }
+
+        done.setBit (index);
+        orderedNodes.add (nodes.getUnchecked (index).get());
+
+        for (const auto dest : destinations.getReference (index))
+            if (! done[dest] && --numInputs.getReference (dest) == 0)
+                ready.add (dest);
     }
 }
 
@@ -494,6 +672,10 @@ void GraphNode::prepareToRender (double sampleRate, int estimatedSamplesPerBlock
     currentMidiOutputBuffer.clear();
     clearRenderingSequence();
 
+    auto engine = _context.audio();
+    renderPool.store (engine != nullptr ? &engine->getRenderPool() : nullptr);
+    sleepSavedTicks.store (0);
+
     _prepared = true;
     if (getSampleRate() != sampleRate || getBlockSize() != estimatedSamplesPerBlock)
         setRenderDetails (sampleRate, estimatedSamplesPerBlock);
@@ -504,6 +686,32 @@ void GraphNode::prepareToRender (double sampleRate, int estimatedSamplesPerBlock
     buildRenderingSequence();
 }
 
+double GraphNode::getSleepSavedSeconds() const noexcept
+{
+    return Time::highResolutionTicksToSeconds (sleepSavedTicks.load (std::memory_order_relaxed));
+}
+
+int GraphNode::getNumSleepingNodes() const
+{
+    int count = 0;
+    for (const auto* node : nodes)
+        if (node->isSleeping())
+            ++count;
+    return count;
+}
+
+void GraphNode::resetAllRenderStats()
+{
+    resetRenderStats();
+    for (auto* node : nodes)
+    {
+        if (auto* graph = dynamic_cast<GraphNode*> (node))
+            graph->resetAllRenderStats();
+        else
+            node->resetRenderStats();
+    }
+}
+
 void GraphNode::releaseResources()
 {
     if (! prepared())
@@ -514,8 +722,8 @@ void GraphNode::releaseResources()
 
     _prepared = false;
 
-    renderingBuffers.setSize (1, 1);
-    midiBuffers.clear();
+    renderPool.store (nullptr);
+    clearRenderingSequence();
 
     currentAudioInputBuffer = nullptr;
     currentAudioOutputBuffer.setSize (1, 1);
@@ -571,12 +779,22 @@ void GraphNode::render (RenderContext& rc)
     currentMidiOutputBuffer.clear();
 
     {
-        ScopedLock sl (seqLock);
-        for (auto ptr : renderingOps)
+        // publish the program we're about to use, then make sure it wasn't
+        // replaced in the meantime. see reclaimRenderPrograms()
+        auto* current = program.load();
+        for (;;)
         {
-            GraphOp* const op = static_cast<GraphOp*> (ptr);
-            op->perform (renderingBuffers, midiBuffers, atomBuffers, numSamples);
+            programInUse.store (current);
+            auto* const latest = program.load();
+            if (latest == current)
+                break;
+            current = latest;
         }
+
+        if (current != nullptr)
+            performRenderingOps (*current, numSamples);
+
+        programInUse.store (nullptr, std::memory_order_release);
     }
 
     for (int i = 0; i < rc.audio.getNumChannels(); ++i)
@@ -586,6 +804,23 @@ void GraphNode::render (RenderContext& rc)
     midiMessages.addEvents (currentMidiOutputBuffer, 0, numSamples, 0);
 }
 
+void GraphNode::performRenderingOps (RenderProgram& prog, int numSamples) noexcept
+{
+    auto* const pool = renderPool.load (std::memory_order_acquire);
+    if (prog.parallel != nullptr && pool != nullptr && pool->getNumWorkers() > 0)
+    {
+        prog.parallel->prepare (*pool, numSamples);
+        if (pool->run (*prog.parallel))
+            return;
+    }
+
+    for (auto ptr : prog.ops)
+    {
+        GraphOp* const op = static_cast<GraphOp*> (ptr);
+        op->perform (prog.audio, prog.midi, prog.atom, numSamples);
+    }
+}
+
 void GraphNode::getPluginDescription (PluginDescription& d) const
 {
     d.name = getName();
@@ -608,6 +843,13 @@ void GraphNode::setPlayHead (AudioPlayHead* newPlayHead)
         node->setPlayHead (playhead);
 }
 
+void GraphNode::setNonRealtime (bool isNonRealtime) noexcept
+{
+    Processor::setNonRealtime (isNonRealtime);
+    for (auto* const node : nodes)
+        node->setNonRealtime (isNonRealtime);
+}
+
 void GraphNode::refreshPorts()
 {
     if (! customPortsSet)
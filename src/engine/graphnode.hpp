@@ -12,10 +12,12 @@
 namespace element {
 
 class Context;
+class RenderPool;
 class SymbolMap;
 
 class GraphNode : public Processor,
-                  private AsyncUpdater
+                  private AsyncUpdater,
+                  private Timer
 {
 public:
     Signal<void()> renderingSequenceChanged;
@@ -178,6 +180,7 @@ public:
 
     void refreshPorts() override;
     void setPlayHead (AudioPlayHead*) override;
+    void setNonRealtime (bool isNonRealtime) noexcept override;
 
     void setNumPorts (PortType type, int count, bool inputs, bool async = true);
 
@@ -186,9 +189,28 @@ public:
 
     SymbolMap& symbols() noexcept;
 
+    /** Returns the pool used to render this graph, or nullptr if it isn't
+        prepared. Nodes may hand their own work to it while rendering. */
+    RenderPool* getRenderPool() const noexcept { return renderPool.load (std::memory_order_acquire); }
+
     /** Rebuild rendering ops immediately. */
     void rebuild() noexcept;
 
+    /** Returns the processing time nodes sleeping on silence have saved
+        since the graph was prepared. An estimate based on how long they
+        took while awake. */
+    double getSleepSavedSeconds() const noexcept;
+
+    /** Returns the number of nodes in this graph currently sleeping. */
+    int getNumSleepingNodes() const;
+
+    /** Forget the render times of this graph and all nodes in it, including
+        those of nested graphs. */
+    void resetAllRenderStats();
+
+    /** Called by sleeping nodes while rendering. */
+    void addSleepSavings (int64 ticks) noexcept { sleepSavedTicks.fetch_add (ticks, std::memory_order_relaxed); }
+
 protected:
     //==========================================================================
     virtual void preRenderNodes() {}
@@ -215,12 +237,21 @@ private:
     uint32 ioNodes[10];
 
     uint32 lastNodeId;
-    AudioSampleBuffer renderingBuffers;
-    OwnedArray<MidiBuffer> midiBuffers;
-    OwnedArray<AtomBuffer> atomBuffers;
-    Array<void*> renderingOps;
     bool _prepared = false;
 
+    class ParallelRender;
+    struct RenderProgram;
+
+    // The program being rendered is swapped in atomically. The render thread
+    // publishes the program it is using, and replaced programs are deleted on
+    // other threads once it has let go of them.
+    std::atomic<RenderProgram*> program { nullptr };
+    std::atomic<RenderProgram*> programInUse { nullptr };
+    CriticalSection retiredLock;
+    Array<RenderProgram*> retiredPrograms;
+    std::atomic<RenderPool*> renderPool { nullptr };
+    std::atomic<int64> sleepSavedTicks { 0 };
+
     AudioSampleBuffer* currentAudioInputBuffer;
     AudioSampleBuffer currentAudioOutputBuffer;
     MidiBuffer* currentMidiInputBuffer;
@@ -235,11 +266,15 @@ private:
     bool customPortsSet = false;
     PortList userPorts;
 
-    CriticalSection seqLock;
     friend class ScriptNode; // workaround so parameter connections work when params change.
     void handleAsyncUpdate() override;
+    void timerCallback() override;
     void clearRenderingSequence();
     void buildRenderingSequence();
+    void sortNodes (Array<void*>& orderedNodes) const;
+    void swapRenderProgram (RenderProgram* newProgram);
+    void reclaimRenderPrograms();
+    void performRenderingOps (RenderProgram& prog, int numSamples) noexcept;
     bool isAnInputTo (uint32 possibleInputId, uint32 possibleDestinationId, int recursionCheck) const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GraphNode)
@@ -22,7 +22,9 @@
 
 #include <jack/weakjack.h>
 #include <jack/jack.h>
+#include <jack/midiport.h>
 
+#include "engine/audiodevicemidi.hpp"
 #include "engine/jack.hpp"
 #include "dynlib.h"
 
@@ -84,6 +86,12 @@ JUCE_DECL_JACK_FUNCTION (int, jack_port_connected_to, (const jack_port_t* port,
 JUCE_DECL_JACK_FUNCTION (int, jack_set_xrun_callback, (jack_client_t * client, JackXRunCallback xrun_callback, void* arg), (client, xrun_callback, arg))
 JUCE_DECL_JACK_FUNCTION (int, jack_port_flags, (const jack_port_t* port), (port))
 JUCE_DECL_JACK_FUNCTION (jack_port_t*, jack_port_by_name, (jack_client_t * client, const char* name), (client, name))
+JUCE_DECL_JACK_FUNCTION (const char*, jack_port_type, (const jack_port_t* port), (port))
+
+JUCE_DECL_JACK_FUNCTION (uint32_t, jack_midi_get_event_count, (void* port_buffer), (port_buffer))
+JUCE_DECL_JACK_FUNCTION (int, jack_midi_event_get, (jack_midi_event_t * event, void* port_buffer, uint32_t event_index), (event, port_buffer, event_index))
+JUCE_DECL_VOID_JACK_FUNCTION (jack_midi_clear_buffer, (void* port_buffer), (port_buffer))
+JUCE_DECL_JACK_FUNCTION (int, jack_midi_event_write, (void* port_buffer, jack_nframes_t time, const jack_midi_data_t* data, size_t data_size), (port_buffer, time, data, data_size))
 
 JUCE_DECL_JACK_FUNCTION (int, jack_client_name_size, (), ());
 JUCE_DECL_JACK_FUNCTION (int, jack_port_name_size, (), ());
@@ -345,15 +353,16 @@ const char* JackPort::getName() const { return element::jack_port_name (port); }
 
 bool JackPort::isInput() const { return getFlags() & JackPortIsInput; }
 bool JackPort::isOutput() const { return getFlags() & JackPortIsOutput; }
-bool JackPort::isAudio() const { return true; }
-bool JackPort::isMidi() const { return false; }
+bool JackPort::isAudio() const { return std::strcmp (element::jack_port_type (port), JACK_DEFAULT_AUDIO_TYPE) == 0; }
+bool JackPort::isMidi() const { return std::strcmp (element::jack_port_type (port), JACK_DEFAULT_MIDI_TYPE) == 0; }
 
 int JackPort::connect (const JackPort& other) { return jack_connect (client, getName(), other.getName()); }
 
 int JackPort::getFlags() const { return element::jack_port_flags (port); }
 
 //==============================================================================
-class JackAudioIODevice : public AudioIODevice
+class JackAudioIODevice : public AudioIODevice,
+                          public AudioDeviceMidi
 {
 public:
     JackAudioIODevice (JackClient& _client,
@@ -406,6 +415,14 @@ public:
 
             inChans.calloc (totalNumberOfInputChannels + 2);
             outChans.calloc (totalNumberOfOutputChannels + 2);
+
+            // MIDI goes straight through the process callback.
+            midiInputPort = element::jack_port_register (
+                client, "midi_in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+            midiOutputPort = element::jack_port_register (
+                client, "midi_out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+            midiIn.ensureSize (midiBufferSize);
+            midiOut.ensureSize (midiBufferSize);
         }
     }
 
@@ -606,6 +623,14 @@ public:
         return latency;
     }
 
+    //==============================================================================
+    const MidiBuffer& getIncomingMidi() const noexcept override { return midiIn; }
+    bool wantsOutgoingMidi() const noexcept override { return midiOutputConnected.load (std::memory_order_relaxed); }
+    void addOutgoingMidi (const MidiBuffer& midi, int numSamples) noexcept override
+    {
+        midiOut.addEvents (midi, 0, numSamples, 0);
+    }
+
     String inputName, outputName;
 
 private:
@@ -651,22 +676,65 @@ private:
                     outChans[numActiveOutChans++] = (float*) out;
         }
 
-        const ScopedLock sl (callbackLock);
+        readMidiInput (numSamples);
+        midiOut.clear();
 
-        if (callback != nullptr)
         {
-            if ((numActiveInChans + numActiveOutChans) > 0)
-                callback->audioDeviceIOCallbackWithContext (inChans.getData(),
-                                                            numActiveInChans,
-                                                            outChans,
-                                                            numActiveOutChans,
-                                                            numSamples,
-                                                            {});
+            const ScopedLock sl (callbackLock);
+
+            if (callback != nullptr)
+            {
+                if ((numActiveInChans + numActiveOutChans) > 0)
+                    callback->audioDeviceIOCallbackWithContext (inChans.getData(),
+                                                                numActiveInChans,
+                                                                outChans,
+                                                                numActiveOutChans,
+                                                                numSamples,
+                                                                {});
+            }
+            else
+            {
+                for (int i = 0; i < numActiveOutChans; ++i)
+                    juce::zeromem (outChans[i], static_cast<size_t> (numSamples) * sizeof (float));
+            }
         }
-        else
+
+        writeMidiOutput (numSamples);
+    }
+
+    void readMidiInput (const int numSamples)
+    {
+        midiIn.clear();
+        if (midiInputPort == nullptr)
+            return;
+
+        auto* const buffer = element::jack_port_get_buffer (midiInputPort, static_cast<jack_nframes_t> (numSamples));
+        if (buffer == nullptr)
+            return;
+
+        jack_midi_event_t event;
+        const auto numEvents = element::jack_midi_get_event_count (buffer);
+        for (uint32_t i = 0; i < numEvents; ++i)
+            if (element::jack_midi_event_get (&event, buffer, i) == 0)
+                midiIn.addEvent (event.buffer, static_cast<int> (event.size), static_cast<int> (event.time));
+    }
+
+    void writeMidiOutput (const int numSamples)
+    {
+        if (midiOutputPort == nullptr)
+            return;
+
+        auto* const buffer = element::jack_port_get_buffer (midiOutputPort, static_cast<jack_nframes_t> (numSamples));
+        if (buffer == nullptr)
+            return;
+
+        // JACK wants this every cycle, even when nothing is written.
+        element::jack_midi_clear_buffer (buffer);
+        for (const auto metadata : midiOut)
         {
-            for (int i = 0; i < numActiveOutChans; ++i)
-                juce::zeromem (outChans[i], static_cast<size_t> (numSamples) * sizeof (float));
+            const auto frame = jlimit (0, numSamples - 1, metadata.samplePosition);
+            if (element::jack_midi_event_write (buffer, static_cast<jack_nframes_t> (frame), metadata.data, static_cast<size_t> (metadata.numBytes)) != 0)
+                break; // port buffer full
         }
     }
 
@@ -698,6 +766,9 @@ private:
             if (element::jack_port_connected (inputPorts.getUnchecked (i)))
                 newInputChannels.setBit (i);
 
+        midiOutputConnected.store (midiOutputPort != nullptr && element::jack_port_connected (midiOutputPort) > 0,
+                                   std::memory_order_relaxed);
+
         if (newOutputChannels != activeOutputChannels
             || newInputChannels != activeInputChannels)
         {
@@ -764,6 +835,12 @@ private:
     Array<jack_port_t*> inputPorts, outputPorts;
     BigInteger activeInputChannels, activeOutputChannels;
 
+    static constexpr int midiBufferSize = 4096;
+    jack_port_t* midiInputPort = nullptr;
+    jack_port_t* midiOutputPort = nullptr;
+    MidiBuffer midiIn, midiOut;
+    std::atomic<bool> midiOutputConnected { false };
+
     std::atomic<int> xruns { 0 };
 
     std::function<void()> notifyChannelsChanged;
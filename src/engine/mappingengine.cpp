@@ -16,7 +16,93 @@ public:
     virtual ~ControllerMapHandler() {}
 
     virtual bool wants (const MidiMessage& message) const = 0;
-    virtual void perform (const MidiMessage& message) = 0;
+
+    /** Apply a message. The frame is an offset in the block being rendered,
+        or -1 when called from the MIDI thread. Returns true if the handler
+        started smoothing and needs advance() called on following blocks.
+     */
+    virtual bool perform (const MidiMessage& message, int frame) = 0;
+
+    /** Advance smoothing by a block. Returns false once settled. */
+    virtual bool advance (int numSamples) { return false; }
+
+    /** Called with the engine's sample rate before rendering. */
+    virtual void prepare (double sampleRate) {}
+
+    /** True while the engine has this handler in its smoothing list. */
+    bool smoothingActive = false;
+
+    /** Tell the host and listeners about the last value set on the audio
+        thread, if any. Called on the message thread. */
+    void flushNotifications()
+    {
+        if (! changed.exchange (false, std::memory_order_acquire))
+            return;
+        if (auto* const param = getParameter())
+        {
+            param->beginChangeGesture();
+            param->sendValueChangedMessageToListeners (pendingValue.load (std::memory_order_relaxed));
+            param->endChangeGesture();
+        }
+    }
+
+protected:
+    /** Returns the mapped parameter, or nullptr if it isn't one. */
+    virtual Parameter* getParameter() const noexcept { return nullptr; }
+
+    /** Set a parameter right away, notifying the host. Only for the MIDI
+        thread, gestures and listeners aren't realtime safe. */
+    static void setParameterNotifying (Parameter& param, float value)
+    {
+        param.beginChangeGesture();
+        param.setValueNotifyingHost (value);
+        param.endChangeGesture();
+    }
+
+    /** Set a parameter as close to the frame as it supports. Parameters that
+        can only change between blocks are ramped if they are continuous.
+        On the audio thread the value is set quietly, and the host hears
+        about it from the next flushNotifications().
+     */
+    bool setParameter (Parameter& param, LinearSmoothedValue<float>& smoothed, float value, int frame)
+    {
+        if (frame < 0)
+        {
+            setParameterNotifying (param, value);
+            return false;
+        }
+
+        bool smoothing = false;
+        if (param.isDiscrete() || param.isBoolean())
+        {
+            param.setValue (value);
+        }
+        else if (! param.setValueAtFrame (value, frame))
+        {
+            if (! smoothed.isSmoothing())
+                smoothed.setCurrentAndTargetValue (param.getValue());
+            smoothed.setTargetValue (value);
+            smoothing = smoothed.isSmoothing();
+            if (! smoothing)
+                param.setValue (value);
+        }
+
+        markChanged (value);
+        return smoothing;
+    }
+
+    /** Note a value set on the audio thread for the next flush. */
+    void markChanged (float value) noexcept
+    {
+        pendingValue.store (value, std::memory_order_relaxed);
+        changed.store (true, std::memory_order_release);
+    }
+
+    static constexpr double smoothingSeconds = 0.02;
+
+private:
+    std::atomic<bool> changed { false };
+    std::atomic<float> pendingValue { 0.f };
 };
 
 struct MidiNoteControllerMap : public ControllerMapHandler,
@@ -74,7 +160,7 @@ struct MidiNoteControllerMap : public ControllerMapHandler,
         return wants;
     }
 
-    void perform (const MidiMessage& message) override
+    bool perform (const MidiMessage& message, int frame) override
     {
         const bool isInverse = inverse.get() == 1;
 
@@ -87,23 +173,35 @@ struct MidiNoteControllerMap : public ControllerMapHandler,
 
         if (parameter != nullptr)
         {
-            parameter->beginChangeGesture();
+            float value = 0.f;
             if (momentary.get() == 0)
             {
-                parameter->setValueNotifyingHost (parameter->getValue() < 0.5 ? 1.f : 0.f);
+                value = parameter->getValue() < 0.5 ? 1.f : 0.f;
             }
             else
             {
                 const bool onOrOff = isInverse ? message.isNoteOff() : message.isNoteOn();
-                parameter->setValueNotifyingHost (onOrOff ? 1.f : 0.f);
+                value = onOrOff ? 1.f : 0.f;
             }
 
-            parameter->endChangeGesture();
+            // on/off values are never ramped.
+            if (frame < 0)
+            {
+                setParameterNotifying (*parameter, value);
+            }
+            else
+            {
+                if (! parameter->setValueAtFrame (value, frame))
+                    parameter->setValue (value);
+                markChanged (value);
+            }
         }
         else if (parameterIndex == Processor::EnabledParameter || parameterIndex == Processor::BypassParameter || parameterIndex == Processor::MuteParameter)
         {
             triggerAsyncUpdate();
         }
+
+        return false;
     }
 
     void handleAsyncUpdate() override
@@ -155,6 +253,9 @@ struct MidiNoteControllerMap : public ControllerMapHandler,
         }
     }
 
+protected:
+    Parameter* getParameter() const noexcept override { return parameter.get(); }
+
 private:
     Control control;
     Node model;
@@ -246,15 +347,29 @@ struct MidiCCControllerMapHandler : public ControllerMapHandler,
         return message.isController() && message.getControllerNumber() == controllerNumber && (channel.get() == 0 || (channel.get() > 0 && message.getChannel() == channel.get()));
     }
 
-    void perform (const MidiMessage& message) override
+    void prepare (double sampleRate) override
+    {
+        smoothed.reset (sampleRate, smoothingSeconds);
+    }
+
+    bool advance (int numSamples) override
+    {
+        if (parameter == nullptr)
+            return false;
+        const auto value = smoothed.skip (numSamples);
+        parameter->setValue (value);
+        markChanged (value);
+        return smoothed.isSmoothing();
+    }
+
+    bool perform (const MidiMessage& message, int frame) override
     {
         const auto ccValue = message.getControllerValue();
+        bool smoothing = false;
 
         if (nullptr != parameter)
         {
-            parameter->beginChangeGesture();
-            parameter->setValueNotifyingHost (static_cast<float> (ccValue) / 127.f);
-            parameter->endChangeGesture();
+            smoothing = setParameter (*parameter, smoothed, static_cast<float> (ccValue) / 127.f, frame);
         }
         else if (parameterIndex == Processor::EnabledParameter || parameterIndex == Processor::BypassParameter || parameterIndex == Processor::MuteParameter)
         {
@@ -315,6 +430,7 @@ struct MidiCCControllerMapHandler : public ControllerMapHandler,
         }
 
         lastControllerValue = ccValue;
+        return smoothing;
     }
 
     void handleAsyncUpdate() override
@@ -343,6 +459,9 @@ struct MidiCCControllerMapHandler : public ControllerMapHandler,
         }
     }
 
+protected:
+    Parameter* getParameter() const noexcept override { return parameter.get(); }
+
 private:
     Control control;
     Node model;
@@ -352,6 +471,7 @@ private:
     const int controllerNumber { -1 };
     const int parameterIndex { -1 };
     int lastControllerValue = 0;
+    LinearSmoothedValue<float> smoothed;
 
     Value toggleValueObject;
     Atomic<int> toggleValue { 64 };
@@ -414,9 +534,12 @@ public:
         else if (message.isController())
             mapping.captureNextEvent (*this, controls[message.getControllerNumber()], message);
 
-        for (auto* handler : handlers)
-            if (handler->wants (message))
-                handler->perform (message);
+        const auto& candidates = message.isController()
+                                     ? ccHandlers[(size_t) message.getControllerNumber()]
+                                     : noteHandlers[(size_t) message.getNoteNumber()];
+        for (auto* handler : candidates)
+            if (handler->wants (message) && ! mapping.enqueue (*handler, message))
+                handler->perform (message, -1);
     }
 
     bool close()
@@ -471,19 +594,37 @@ public:
         return isInputFor (control.controller());
     }
 
-    void addHandler (ControllerMapHandler* handler)
+    void addHandler (ControllerMapHandler* handler, const MidiMessage& message)
     {
         stop();
         handlers.add (handler);
+        if (message.isController())
+            ccHandlers[(size_t) message.getControllerNumber()].add (handler);
+        else if (message.isNoteOnOrOff())
+            noteHandlers[(size_t) message.getNoteNumber()].add (handler);
         start();
     }
 
+    void prepare (double sampleRate)
+    {
+        for (auto* handler : handlers)
+            handler->prepare (sampleRate);
+    }
+
+    void flushNotifications()
+    {
+        for (auto* handler : handlers)
+            handler->flushNotifications();
+    }
+
 private:
     MidiEngine& midi;
     MappingEngine& mapping;
     Controller controllerDevice;
     std::unique_ptr<MidiInput> midiInput;
     OwnedArray<ControllerMapHandler> handlers;
+    // handlers by CC or note number. The channel is checked by the handler.
+    std::array<Array<ControllerMapHandler*>, 128> ccHandlers, noteHandlers;
     BigInteger controllerNumbers, noteNumbers;
     HashMap<int, Control> controls, notes;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ControllerMapInput)
@@ -559,6 +700,12 @@ public:
 
     bool isRunning() const { return running; }
 
+    void prepare (double sampleRate)
+    {
+        for (auto* input : inputs)
+            input->prepare (sampleRate);
+    }
+
     ControllerMapInput* const* begin() const noexcept { return inputs.begin(); }
     ControllerMapInput* const* end() const noexcept { return inputs.end(); }
     int size() const noexcept { return inputs.size(); }
@@ -574,10 +721,13 @@ MappingEngine::MappingEngine()
 {
     inputs.reset (new Inputs());
     capturedEvent.capture.set (true);
+    startTimerHz (30);
 }
 
 MappingEngine::~MappingEngine()
 {
+    stopTimer();
+    flushEvents();
     inputs->clear();
     inputs = nullptr;
 }
@@ -617,7 +767,9 @@ bool MappingEngine::addHandler (const Control& control,
 
             if (nullptr != handler)
             {
-                input->addHandler (handler.release());
+                const SpinLock::ScopedLockType sl (renderLock);
+                handler->prepare (sampleRate);
+                input->addHandler (handler.release(), message);
                 return true;
             }
         }
@@ -629,6 +781,9 @@ bool MappingEngine::removeInput (const Controller& controller)
 {
     if (! inputs->containsInputFor (controller))
         return true;
+    if (auto* input = inputs->findInput (controller))
+        input->close();
+    flushEvents();
     return inputs->remove (controller);
 }
 
@@ -650,6 +805,7 @@ bool MappingEngine::refreshInput (const Controller& device)
 void MappingEngine::clear()
 {
     stopMapping();
+    flushEvents();
     inputs->clear();
 }
 
@@ -664,6 +820,121 @@ void MappingEngine::stopMapping()
     inputs->stop();
 }
 
+void MappingEngine::prepareToRender (double newSampleRate, int maxBlockSize)
+{
+    ignoreUnused (maxBlockSize);
+    const SpinLock::ScopedLockType sl (renderLock);
+    sampleRate = newSampleRate;
+    inputs->prepare (sampleRate);
+    rendering.store (true);
+}
+
+void MappingEngine::releaseResources()
+{
+    rendering.store (false);
+    flushEvents();
+}
+
+void MappingEngine::timerCallback()
+{
+    for (auto* input : *inputs)
+        input->flushNotifications();
+}
+
+void MappingEngine::flushEvents()
+{
+    const SpinLock::ScopedLockType sl (renderLock);
+    fifo.reset();
+    for (int i = 0; i < numSmoothing; ++i)
+        smoothing[(size_t) i]->smoothingActive = false;
+    numSmoothing = 0;
+}
+
+bool MappingEngine::enqueue (ControllerMapHandler& handler, const MidiMessage& message)
+{
+    // MidiEngine serializes input callbacks, so there is only ever one writer.
+    if (! rendering.load() || message.getRawDataSize() != 3)
+        return false;
+
+    const auto scope = fifo.write (1);
+    if (scope.blockSize1 + scope.blockSize2 <= 0)
+        return false;
+
+    auto& event = events[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+    event.handler = &handler;
+    event.time = message.getTimeStamp() > 0.0 ? message.getTimeStamp()
+                                               : Time::getMillisecondCounterHiRes() * 0.001;
+    std::memcpy (event.data, message.getRawData(), 3);
+    return true;
+}
+
+void MappingEngine::render (int numSamples) noexcept
+{
+    render (0, numSamples, numSamples);
+}
+
+void MappingEngine::render (int start, int numFrames, int numSamples) noexcept
+{
+    const SpinLock::ScopedTryLockType sl (renderLock);
+    if (! sl.isLocked() || numFrames <= 0 || numSamples <= 0)
+        return;
+
+    // Events are spread over the block by when they arrived during the
+    // previous one, like MidiMessageCollector does.
+    if (start <= 0)
+        blockStart = Time::getMillisecondCounterHiRes() * 0.001 - numSamples / sampleRate;
+
+    // events arrive in time order, so this piece's events come first and
+    // the rest wait for a later one. The last piece takes everything.
+    const int end = start + numFrames;
+    const bool lastPiece = end >= numSamples;
+    const auto frameOf = [&] (const Event& event) {
+        return jlimit (0, numSamples - 1, roundToInt ((event.time - blockStart) * sampleRate));
+    };
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+    int count = 0;
+    for (; count < size1 + size2; ++count)
+    {
+        const auto index = count < size1 ? start1 + count : start2 + count - size1;
+        if (! lastPiece && frameOf (events[(size_t) index]) >= end)
+            break;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        const auto& event = events[(size_t) (i < size1 ? start1 + i : start2 + i - size1)];
+        const auto frame = jlimit (start, end - 1, frameOf (event)) - start;
+        const MidiMessage message (event.data[0], event.data[1], event.data[2], event.time);
+        auto* const handler = event.handler;
+        if (! handler->perform (message, frame) || handler->smoothingActive)
+            continue;
+
+        if (numSmoothing < maxSmoothing)
+        {
+            handler->smoothingActive = true;
+            smoothing[(size_t) numSmoothing++] = handler;
+        }
+        else
+        {
+            // no room to ramp it, finish the ramp now.
+            handler->advance (std::numeric_limits<int>::max());
+        }
+    }
+
+    fifo.finishedRead (count);
+
+    for (int i = numSmoothing; --i >= 0;)
+    {
+        auto* const handler = smoothing[(size_t) i];
+        if (handler->advance (numFrames))
+            continue;
+        handler->smoothingActive = false;
+        smoothing[(size_t) i] = smoothing[(size_t) --numSmoothing];
+    }
+}
+
 bool MappingEngine::captureNextEvent (ControllerMapInput& input,
                                       const Control& control,
                                       const MidiMessage& message)
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <array>
+
 #include <element/juce.hpp>
 #include <element/controller.hpp>
 #include <element/signals.hpp>
@@ -15,7 +17,10 @@ class Processor;
 class Node;
 class MidiEngine;
 
-class MappingEngine
+/** Applies mapped controller events to node parameters. Values set on the
+    audio thread are applied quietly, and the host and parameter listeners
+    are told about them from a timer on the message thread. */
+class MappingEngine : private Timer
 {
 public:
     using CapturedEventSignal = Signal<void()>;
@@ -32,6 +37,24 @@ public:
     void startMapping();
     void stopMapping();
 
+    /** Dispatch mapped events from the render pass from now on. Until this
+        is called, and after releaseResources(), events are applied on the
+        MIDI thread as they arrive. */
+    void prepareToRender (double sampleRate, int maxBlockSize);
+
+    /** Go back to applying events on the MIDI thread. */
+    void releaseResources();
+
+    /** Apply queued controller events at their frame offsets and advance
+        smoothed parameters. Call on the audio thread before the graphs render.
+     */
+    void render (int numSamples) noexcept;
+
+    /** Like render(), for a block rendered in pieces. Call once for each
+        piece in order, starting from zero. Only events that land in the
+        piece are applied, with frames relative to its start. */
+    void render (int start, int numFrames, int numSamples) noexcept;
+
     void capture (const bool start = true) { capturedEvent.capture.set (start); }
     MidiMessage getCapturedMidiMessage() const { return capturedEvent.message; }
     Control getCapturedControl() const { return capturedEvent.control; }
@@ -42,6 +65,30 @@ private:
     class Inputs;
     std::unique_ptr<Inputs> inputs;
 
+    struct Event
+    {
+        ControllerMapHandler* handler { nullptr };
+        double time { 0.0 };
+        uint8 data[3];
+    };
+
+    static constexpr int eventQueueSize = 1024;
+    AbstractFifo fifo { eventQueueSize };
+    std::array<Event, eventQueueSize> events;
+    std::atomic<bool> rendering { false };
+    double sampleRate { 44100.0 };
+    double blockStart { 0.0 }; ///< when the block being rendered started, in seconds
+    // held by the audio thread while it touches handlers, and by anything
+    // that deletes them.
+    SpinLock renderLock;
+    static constexpr int maxSmoothing = 128;
+    std::array<ControllerMapHandler*, maxSmoothing> smoothing;
+    int numSmoothing { 0 };
+
+    bool enqueue (ControllerMapHandler&, const MidiMessage&);
+    void flushEvents();
+    void timerCallback() override;
+
     class CapturedEvent : public AsyncUpdater
     {
     public:
@@ -24,6 +24,14 @@ void Parameter::setValueNotifyingHost (float newValue)
     sendValueChangedMessageToListeners (newValue);
 }
 
+bool Parameter::setValueNotifyingHostAtFrame (float newValue, int frame)
+{
+    if (! setValueAtFrame (newValue, frame))
+        return false;
+    sendValueChangedMessageToListeners (newValue);
+    return true;
+}
+
 void Parameter::beginChangeGesture()
 {
     // This method can't be used until the parameter has been attached to a processor!
@@ -76,6 +84,7 @@ bool Parameter::isOrientationInverted() const { return false; }
 bool Parameter::isAutomatable() const { return true; }
 bool Parameter::isMetaParameter() const { return false; }
 Parameter::Category Parameter::getCategory() const { return genericParameter; }
+bool Parameter::setValueAtFrame (float, int) { return false; }
 int Parameter::getNumSteps() const { return defaultNumSteps(); }
 bool Parameter::isDiscrete() const { return false; }
 bool Parameter::isBoolean() const { return false; }
@@ -13,6 +13,7 @@
 #include "nodes/audioprocessor.hpp"
 #include "nodes/mididevice.hpp"
 #include "nodes/placeholder.hpp"
+#include "engine/renderprofile.hpp"
 #include "engine/rootgraph.hpp"
 
 namespace element {
@@ -30,6 +31,7 @@ Processor::Processor (const PortList& portList)
     inputGain.set (1.0f);
     lastInputGain.set (1.0f);
     oversampler = std::make_unique<Oversampler<float>>();
+    profile = std::make_unique<RenderProfile>();
     // ports = portList;
     setPorts (portList);
 }
@@ -47,6 +49,7 @@ Processor::Processor (const uint32 nodeId_) noexcept
     inputGain.set (1.0f);
     lastInputGain.set (1.0f);
     oversampler = std::make_unique<Oversampler<float>>();
+    profile = std::make_unique<RenderProfile>();
 }
 
 Processor::~Processor()
@@ -701,6 +704,16 @@ void Processor::setParentGraph (GraphNode* const graph)
     }
 }
 
+Processor::RenderStats Processor::getRenderStats() const
+{
+    return profile->getStats();
+}
+
+void Processor::resetRenderStats()
+{
+    profile->reset();
+}
+
 void Processor::setMuted (bool muted)
 {
     bool wasMuted = isMuted();
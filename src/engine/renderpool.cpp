@@ -0,0 +1,227 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <thread>
+
+#include "engine/renderpool.hpp"
+#include "semaphore.hpp"
+
+namespace element {
+
+/* The high bit of the gate is set while a job accepts workers, the low bits
+   count the workers currently inside the job. */
+static constexpr uint32_t gateOpen = 1u << 31;
+
+struct RenderPool::TaskSet
+{
+    TaskSet (Tasks& t, int n) : tasks (t), numTasks (n) {}
+
+    /** Claim and perform tasks until none are left. Returns how many. */
+    int perform() noexcept
+    {
+        int count = 0, index;
+        while ((index = next.fetch_add (1, std::memory_order_acq_rel)) < numTasks)
+        {
+            tasks.perform (index);
+            done.fetch_add (1, std::memory_order_release);
+            ++count;
+        }
+        return count;
+    }
+
+    Tasks& tasks;
+    const int numTasks;
+    std::atomic<int> next { 0 }, done { 0 };
+};
+
+class RenderPool::Worker : public juce::Thread
+{
+public:
+    Worker (RenderPool& p, int index)
+        : juce::Thread ("element: render " + juce::String (index + 1)),
+          pool (p) {}
+
+    ~Worker()
+    {
+        signalThreadShouldExit();
+        wake.post();
+        stopThread (1000);
+    }
+
+    void run() override
+    {
+        // match the audio thread, plugins may be rendered here.
+        juce::FloatVectorOperations::disableDenormalisedNumberSupport();
+        while (! threadShouldExit())
+        {
+            wake.wait();
+            if (threadShouldExit())
+                break;
+            const auto started = juce::Time::getHighResolutionTicks();
+            pool.participate();
+            pool.busyTicks.fetch_add (juce::Time::getHighResolutionTicks() - started, std::memory_order_relaxed);
+        }
+    }
+
+    Semaphore wake;
+
+private:
+    RenderPool& pool;
+};
+
+RenderPool::RenderPool() {}
+
+RenderPool::~RenderPool()
+{
+    setNumWorkers (0);
+}
+
+int RenderPool::getMaxWorkers() noexcept
+{
+    // leave a core for the calling audio thread.
+    return juce::jmax (0, juce::SystemStats::getNumCpus() - 1);
+}
+
+void RenderPool::setNumWorkers (int newNumWorkers)
+{
+    newNumWorkers = juce::jlimit (0, getMaxWorkers(), newNumWorkers);
+    if (newNumWorkers == workers.size())
+        return;
+
+    jassert (! busy.load());
+    numWorkers.store (0);
+    workers.clear();
+
+    for (int i = 0; i < newNumWorkers; ++i)
+    {
+        auto worker = workers.add (new Worker (*this, i));
+        worker->startThread (juce::Thread::Priority::highest);
+    }
+
+    numWorkers.store (workers.size());
+}
+
+bool RenderPool::run (Job& job) noexcept
+{
+    if (numWorkers.load (std::memory_order_relaxed) <= 0)
+        return false;
+    if (busy.exchange (true, std::memory_order_acquire))
+        return false;
+
+    current.store (&job, std::memory_order_release);
+    gate.store (gateOpen, std::memory_order_release);
+
+    for (auto* worker : workers)
+        worker->wake.post();
+
+    numJobs.fetch_add (1, std::memory_order_relaxed);
+    job.perform();
+
+    // stop accepting workers, then wait for the ones still inside to leave.
+    gate.fetch_and (~gateOpen, std::memory_order_acq_rel);
+    while (gate.load (std::memory_order_acquire) != 0)
+        std::this_thread::yield();
+
+    current.store (nullptr, std::memory_order_relaxed);
+    busy.store (false, std::memory_order_release);
+    return true;
+}
+
+void RenderPool::participate() noexcept
+{
+    auto state = gate.load (std::memory_order_acquire);
+    while ((state & gateOpen) != 0)
+    {
+        if (gate.compare_exchange_weak (state, state + 1, std::memory_order_acq_rel))
+        {
+            if (auto* job = current.load (std::memory_order_acquire))
+                job->perform();
+            gate.fetch_sub (1, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+bool RenderPool::runTasks (Tasks& tasks, int count) noexcept
+{
+    if (count <= 0)
+        return true;
+    if (numWorkers.load (std::memory_order_relaxed) <= 0)
+        return false;
+
+    TaskSet set (tasks, count);
+    TaskSet* expected = nullptr;
+    if (! taskSet.compare_exchange_strong (expected, &set, std::memory_order_acq_rel))
+    {
+        numRejected.fetch_add (1, std::memory_order_relaxed);
+        return false;
+    }
+
+    taskGate.store (gateOpen, std::memory_order_release);
+
+    // Outside of a job the workers are asleep, so wake them with a job that
+    // only helps with the tasks. Inside one, its workers steal while waiting.
+    struct Helper final : public Job
+    {
+        Helper (RenderPool& p, TaskSet& s) : pool (p), set (s) {}
+        void perform() noexcept override
+        {
+            if (std::this_thread::get_id() == caller)
+                set.perform();
+            else
+                pool.helpWithTasks();
+        }
+
+        RenderPool& pool;
+        TaskSet& set;
+        const std::thread::id caller { std::this_thread::get_id() };
+    } helper (*this, set);
+
+    if (busy.load (std::memory_order_acquire) || ! run (helper))
+        set.perform();
+
+    while (set.done.load (std::memory_order_acquire) < count)
+        std::this_thread::yield();
+
+    taskGate.fetch_and (~gateOpen, std::memory_order_acq_rel);
+    while (taskGate.load (std::memory_order_acquire) != 0)
+        std::this_thread::yield();
+    taskSet.store (nullptr, std::memory_order_release);
+
+    numTaskSets.fetch_add (1, std::memory_order_relaxed);
+    numTasks.fetch_add (count, std::memory_order_relaxed);
+    return true;
+}
+
+bool RenderPool::helpWithTasks() noexcept
+{
+    auto state = taskGate.load (std::memory_order_acquire);
+    while ((state & gateOpen) != 0)
+    {
+        if (taskGate.compare_exchange_weak (state, state + 1, std::memory_order_acq_rel))
+        {
+            int count = 0;
+            if (auto* set = taskSet.load (std::memory_order_acquire))
+                count = set->perform();
+            taskGate.fetch_sub (1, std::memory_order_release);
+            numStolen.fetch_add (count, std::memory_order_relaxed);
+            return count > 0;
+        }
+    }
+
+    return false;
+}
+
+RenderPool::Stats RenderPool::getStats() const noexcept
+{
+    Stats stats;
+    stats.jobs = numJobs.load (std::memory_order_relaxed);
+    stats.taskSets = numTaskSets.load (std::memory_order_relaxed);
+    stats.rejectedTaskSets = numRejected.load (std::memory_order_relaxed);
+    stats.tasks = numTasks.load (std::memory_order_relaxed);
+    stats.stolenTasks = numStolen.load (std::memory_order_relaxed);
+    stats.busySeconds = juce::Time::highResolutionTicksToSeconds (busyTicks.load (std::memory_order_relaxed));
+    return stats;
+}
+
+} // namespace element
@@ -0,0 +1,123 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/core.hpp>
+
+namespace element {
+
+/** A fork/join pool of high priority threads used to render on more than one
+    core.
+
+    The pool does not schedule anything itself. A caller on the audio thread
+    hands a Job to run(), every available worker then calls Job::perform()
+    alongside the caller, and run() returns once all of them have left the job.
+    Jobs are expected to pull their own work items until none are left, so a
+    worker that wakes up late simply finds nothing to do.
+ */
+class RenderPool
+{
+public:
+    /** Work which can be performed by several threads at once. */
+    class Job
+    {
+    public:
+        Job() = default;
+        virtual ~Job() = default;
+
+        /** Called concurrently on the calling thread and on every worker that
+            joins the job. Implementations must return only when all their
+            work has been completed. */
+        virtual void perform() noexcept = 0;
+    };
+
+    /** Independent tasks which can be stolen by idle threads. */
+    class Tasks
+    {
+    public:
+        Tasks() = default;
+        virtual ~Tasks() = default;
+
+        /** Perform the task at index. Called once per index from any thread. */
+        virtual void perform (int index) noexcept = 0;
+    };
+
+    RenderPool();
+    ~RenderPool();
+
+    /** Change the number of worker threads. A value of zero disables the pool.
+        Not realtime safe and must not be called while a job is running. */
+    void setNumWorkers (int numWorkers);
+
+    /** Returns the number of worker threads. */
+    int getNumWorkers() const noexcept { return numWorkers.load (std::memory_order_relaxed); }
+
+    /** Perform a job on the calling thread and every worker.
+
+        Returns false without performing anything when the pool has no workers
+        or is already running a job, e.g. when called from inside another job.
+        In that case the caller should do the work itself.
+     */
+    bool run (Job& job) noexcept;
+
+    /** Perform a number of tasks on the calling thread and any worker that
+        is free to help, returning once all of them are done.
+
+        Unlike run(), this can be used from inside a running job: workers of
+        that job steal tasks while they wait for their own work. Returns false
+        without performing anything when the pool has no workers or another
+        set of tasks is running. In that case the caller should do the work
+        itself.
+     */
+    bool runTasks (Tasks& tasks, int numTasks) noexcept;
+
+    /** Steal tasks from a set being run by runTasks(), if there is one.
+        Jobs call this while they are waiting, returns true if anything was
+        performed. */
+    bool helpWithTasks() noexcept;
+
+    /** Counters to gauge how well the pool is used. */
+    struct Stats
+    {
+        juce::int64 jobs = 0; ///< Jobs performed by run().
+        juce::int64 taskSets = 0; ///< Task sets performed by runTasks().
+        juce::int64 rejectedTaskSets = 0; ///< Task sets the caller had to perform itself.
+        juce::int64 tasks = 0; ///< Tasks performed.
+        juce::int64 stolenTasks = 0; ///< Tasks performed by a thread other than the caller.
+        double busySeconds = 0.0; ///< Total time workers spent doing work.
+    };
+
+    /** Returns a snapshot of the counters. Safe to call from any thread.
+
+        Utilisation over a period is the change in busySeconds divided by the
+        period times the number of workers.
+     */
+    Stats getStats() const noexcept;
+
+    /** Returns the total number of worker threads worth using on this machine. */
+    static int getMaxWorkers() noexcept;
+
+private:
+    class Worker;
+    juce::OwnedArray<Worker> workers;
+    std::atomic<int> numWorkers { 0 };
+    std::atomic<bool> busy { false };
+    std::atomic<Job*> current { nullptr };
+    std::atomic<uint32_t> gate { 0 };
+
+    struct TaskSet;
+    std::atomic<TaskSet*> taskSet { nullptr };
+    std::atomic<uint32_t> taskGate { 0 };
+
+    std::atomic<juce::int64> numJobs { 0 }, numTaskSets { 0 }, numRejected { 0 },
+        numTasks { 0 }, numStolen { 0 }, busyTicks { 0 };
+
+    void participate() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderPool)
+};
+
+} // namespace element
@@ -0,0 +1,92 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <algorithm>
+
+#include "engine/renderprofile.hpp"
+
+using namespace juce;
+
+namespace element {
+
+void RenderProfile::record (int64 ticks, int numSamples, double sampleRate) noexcept
+{
+    if (numSamples <= 0 || sampleRate <= 0.0)
+        return;
+
+    const auto pos = written.load (std::memory_order_relaxed);
+    auto& slot = ring[(size_t) (pos % ringSize)];
+    slot.micros.store ((float) (Time::highResolutionTicksToSeconds (ticks) * 1000000.0), std::memory_order_relaxed);
+    slot.budgetMicros.store ((float) (numSamples * 1000000.0 / sampleRate), std::memory_order_relaxed);
+    written.store (pos + 1, std::memory_order_release);
+}
+
+void RenderProfile::drain()
+{
+    const auto end = written.load (std::memory_order_acquire);
+
+    // skip what was overwritten, and the slot the next block goes in.
+    if (end - readPos >= (uint64) ringSize)
+    {
+        const auto first = end - (uint64) ringSize + 1;
+        dropped += (int64) (first - readPos);
+        readPos = first;
+    }
+
+    for (; readPos < end; ++readPos)
+    {
+        const auto& slot = ring[(size_t) (readPos % ringSize)];
+        auto& entry = window[(size_t) windowPos];
+        entry.micros = slot.micros.load (std::memory_order_relaxed);
+        entry.budgetMicros = slot.budgetMicros.load (std::memory_order_relaxed);
+        windowPos = (windowPos + 1) % windowSize;
+        windowCount = jmin (windowSize, windowCount + 1);
+        ++totalBlocks;
+    }
+}
+
+RenderProfile::Stats RenderProfile::getStats()
+{
+    const ScopedLock sl (lock);
+    drain();
+
+    Stats stats;
+    stats.blocks = totalBlocks;
+    stats.dropped = dropped;
+    if (windowCount <= 0)
+        return stats;
+
+    std::array<float, windowSize> times;
+    double sum = 0.0, budget = 0.0;
+    stats.minMicros = std::numeric_limits<double>::max();
+
+    for (int i = 0; i < windowCount; ++i)
+    {
+        const auto& entry = window[(size_t) i];
+        times[(size_t) i] = entry.micros;
+        sum += entry.micros;
+        budget += entry.budgetMicros;
+        stats.minMicros = jmin (stats.minMicros, (double) entry.micros);
+        stats.maxMicros = jmax (stats.maxMicros, (double) entry.micros);
+        if (entry.budgetMicros > 0.f)
+            stats.peakBudgetPercent = jmax (stats.peakBudgetPercent, 100.0 * entry.micros / entry.budgetMicros);
+    }
+
+    stats.avgMicros = sum / windowCount;
+    stats.budgetPercent = budget > 0.0 ? 100.0 * sum / budget : 0.0;
+
+    const auto p99 = times.begin() + jmin (windowCount - 1, (windowCount * 99) / 100);
+    std::nth_element (times.begin(), p99, times.begin() + windowCount);
+    stats.p99Micros = *p99;
+    return stats;
+}
+
+void RenderProfile::reset()
+{
+    const ScopedLock sl (lock);
+    drain();
+    windowCount = windowPos = 0;
+    totalBlocks = dropped = 0;
+}
+
+} // namespace element
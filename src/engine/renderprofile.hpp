@@ -0,0 +1,69 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <element/processor.hpp>
+
+namespace element {
+
+/** Collects render times of a node.
+
+    The render thread records the time each block took into a preallocated
+    ring without locking, overwriting the oldest blocks when nobody reads
+    them. Readers drain the ring into a window of the most recent blocks
+    and compute statistics over it, so the cost of sorting for percentiles
+    is paid off the audio thread.
+ */
+class RenderProfile final
+{
+public:
+    using Stats = Processor::RenderStats;
+
+    RenderProfile() = default;
+
+    /** Record how long a block took. Called from the thread rendering the
+        node. Overwrites the oldest block if the ring is full. */
+    void record (int64 ticks, int numSamples, double sampleRate) noexcept;
+
+    /** Returns statistics for the most recent blocks. Not realtime safe. */
+    Stats getStats();
+
+    /** Forget everything recorded so far. Not realtime safe. */
+    void reset();
+
+    /** Number of blocks the statistics are computed over. */
+    static constexpr int windowSize = 512;
+
+private:
+    struct Entry
+    {
+        float micros = 0.f;
+        float budgetMicros = 0.f;
+    };
+
+    struct Slot
+    {
+        std::atomic<float> micros { 0.f };
+        std::atomic<float> budgetMicros { 0.f };
+    };
+
+    static constexpr int ringSize = 1024;
+    std::array<Slot, ringSize> ring;
+    std::atomic<uint64> written { 0 };
+
+    juce::CriticalSection lock;
+    std::array<Entry, windowSize> window;
+    int windowCount = 0, windowPos = 0;
+    uint64 readPos = 0;
+    int64 totalBlocks = 0, dropped = 0;
+
+    void drain();
+
+    JUCE_DECLARE_NON_COPYABLE (RenderProfile)
+};
+
+} // namespace element
@@ -2,10 +2,17 @@
 // SPDX-License-Identifier: GPL3-or-later
 
 #include <element/shuttle.hpp>
-#include "tempo.hpp"
 
 namespace element {
 
+namespace detail {
+/** Frames per quarter note for a tempo map node. */
+static double framesPerBeat (const TimeScale::Node& node, double sampleRate)
+{
+    return sampleRate * 60.0 / (double) node.tempoEx();
+}
+} // namespace detail
+
 const int Shuttle::PPQ = 1920;
 
 double Shuttle::scaledTick (double sourceTick, const int srcPpq)
@@ -17,18 +24,19 @@ double Shuttle::scaledTick (double sourceTick, const int srcPpq)
 }
 
 Shuttle::Shuttle()
+    : ts (std::make_unique<TimeScale>())
 {
-    ts.setTempo (120.0f);
-    ts.setSampleRate (44100);
-    ts.setTicksPerBeat (Shuttle::PPQ);
-    ts.updateScale();
+    ts->setTempo (120.0f);
+    ts->setSampleRate (44100);
+    ts->setTicksPerBeat (Shuttle::PPQ);
+    ts->updateScale();
 
     duration = 0;
     framePos = 0;
-    framesPerBeat = Tempo::audioFramesPerBeat ((double) ts.getSampleRate(), ts.getTempo());
-    beatsPerFrame = 1.0f / framesPerBeat;
+    sampleRate = (double) ts->getSampleRate();
     playing = recording = false;
     looping = true;
+    locate();
 }
 
 Shuttle::~Shuttle() {}
@@ -38,25 +46,32 @@ double Shuttle::getFramesPerBeat() const { return framesPerBeat; }
 
 juce::Optional<juce::AudioPlayHead::PositionInfo> Shuttle::getPosition() const
 {
+    const int beatsPerBar = segment != nullptr ? segment->beatsPerBar : ts->beatsPerBar();
+    const int beatDivisor = segment != nullptr ? segment->beatDivisor : ts->beatDivisor();
+
     juce::AudioPlayHead::PositionInfo info;
     info.setTimeInSamples (getPositionFrames());
     info.setTimeInSeconds (getPositionSeconds());
-    info.setBpm ((double) ts.getTempo());
+    info.setBpm ((double) getTempo());
     juce::AudioPlayHead::TimeSignature timesig;
-    timesig.numerator = ts.beatsPerBar();
-    timesig.denominator = (1 << ts.beatDivisor());
+    timesig.numerator = beatsPerBar;
+    timesig.denominator = (1 << beatDivisor);
     info.setTimeSignature (timesig);
     juce::AudioPlayHead::LoopPoints loops;
-    loops.ppqEnd = 0.0;
     loops.ppqStart = 0.0;
+    loops.ppqEnd = duration > 0 ? getLengthBeats() : 0.0;
     info.setLoopPoints (loops);
 
     {
-        auto posBeats = getPositionBeats();
+        // bars are counted from the start of the current node, which
+        // always falls on a bar line.
+        const auto posBeats = getPositionBeats();
+        const auto beatsPerBarQN = (double) beatsPerBar * 4.0 / (double) timesig.denominator;
+        const auto barsIn = std::floor ((posBeats - segmentBeats) / beatsPerBarQN);
+        const auto firstBar = segment != nullptr ? (int64_t) segment->bar : 0;
         info.setPpqPosition (posBeats);
-        auto bar = static_cast<int64_t> (std::floor (posBeats / (float) ts.beatsPerBar()));
-        info.setBarCount (bar);
-        info.setPpqPositionOfLastBarStart (static_cast<double> (bar * ts.beatsPerBar()));
+        info.setBarCount (firstBar + static_cast<int64_t> (barsIn));
+        info.setPpqPositionOfLastBarStart (segmentBeats + barsIn * beatsPerBarQN);
     }
 
     info.setEditOriginTime (0.0f);
@@ -71,18 +86,24 @@ juce::Optional<juce::AudioPlayHead::PositionInfo> Shuttle::getPosition() const
     return info;
 }
 
-const double Shuttle::getLengthBeats() const { return getLengthSeconds() * (getTempo() / 60.0f); }
+const double Shuttle::getLengthBeats() const { return beatsFromFrame ((int64_t) duration); }
 const int64_t Shuttle::getLengthFrames() const { return duration; }
-const double Shuttle::getLengthSeconds() const { return (double) duration / (double) ts.getSampleRate(); }
+const double Shuttle::getLengthSeconds() const { return (double) duration / (double) ts->getSampleRate(); }
+
+const double Shuttle::getPositionBeats() const
+{
+    if (segment == nullptr)
+        return getPositionSeconds() * (getTempo() / 60.0f);
+    return segmentBeats + (double) (framePos - (int64_t) segment->frame) * beatsPerFrame;
+}
 
-const double Shuttle::getPositionBeats() const { return getPositionSeconds() * (getTempo() / 60.0f); }
 const int64_t Shuttle::getPositionFrames() const { return framePos; }
-const double Shuttle::getPositionSeconds() const { return (double) framePos / (double) ts.getSampleRate(); }
+const double Shuttle::getPositionSeconds() const { return (double) framePos / (double) ts->getSampleRate(); }
 
 int64_t Shuttle::getRemainingFrames() const { return getLengthFrames() - framePos; }
-double Shuttle::getSampleRate() const { return (double) ts.getSampleRate(); }
-float Shuttle::getTempo() const { return ts.getTempo(); }
-const TimeScale& Shuttle::getTimeScale() const { return ts; }
+double Shuttle::getSampleRate() const { return (double) ts->getSampleRate(); }
+float Shuttle::getTempo() const { return segment != nullptr ? segment->tempoEx() : ts->getTempo(); }
+const TimeScale& Shuttle::getTimeScale() const { return *ts; }
 
 bool Shuttle::isLooping() const { return looping; }
 bool Shuttle::isPlaying() const { return playing; }
@@ -93,24 +114,66 @@ void Shuttle::resetRecording()
     // TODO:
 }
 
-void Shuttle::setLengthBeats (const float beats) { setLengthFrames (framesPerBeat * beats); }
+void Shuttle::setLengthBeats (const float beats) { setLengthFrames ((uint32_t) frameFromBeats (beats)); }
 void Shuttle::setLengthSeconds (const double seconds) { setLengthFrames (juce::roundToInt (getSampleRate() * seconds)); }
 void Shuttle::setLengthFrames (const uint32_t df) { duration = df; }
 
+int Shuttle::getFramesUntilChange (int maxFrames) const
+{
+    int64_t frames = maxFrames;
+    if (segment != nullptr && segment->next() != nullptr)
+        frames = juce::jmin (frames, (int64_t) segment->next()->frame - framePos);
+    if (duration > 0)
+        frames = juce::jmin (frames, (int64_t) duration - framePos);
+    return (int) juce::jlimit ((int64_t) 1, (int64_t) juce::jmax (1, maxFrames), frames);
+}
+
+double Shuttle::beatsFromFrame (int64_t frame) const
+{
+    const double rate = getSampleRate();
+    double beats = 0.0;
+    for (auto* node = ts->nodes().first(); node != nullptr; node = node->next())
+    {
+        const auto* next = node->next();
+        const double fpb = detail::framesPerBeat (*node, rate);
+        if (next == nullptr || (int64_t) next->frame > frame)
+            return beats + (double) (frame - (int64_t) node->frame) / fpb;
+        beats += (double) (next->frame - node->frame) / fpb;
+    }
+
+    return beats;
+}
+
+int64_t Shuttle::frameFromBeats (double beats) const
+{
+    const double rate = getSampleRate();
+    double start = 0.0;
+    for (auto* node = ts->nodes().first(); node != nullptr; node = node->next())
+    {
+        const auto* next = node->next();
+        const double fpb = detail::framesPerBeat (*node, rate);
+        const double end = next != nullptr ? start + (double) (next->frame - node->frame) / fpb : beats;
+        if (next == nullptr || beats < end)
+            return (int64_t) node->frame + llrint ((beats - start) * fpb);
+        start = end;
+    }
+
+    return llrint (beats * framesPerBeat);
+}
+
 void Shuttle::setTempo (float bpm)
 {
-    if (ts.getTempo() != bpm && bpm > 0.0f)
+    if (ts->getTempo() != bpm && bpm > 0.0f)
     {
-        double oldTime = getPositionBeats();
-        double oldLen = getLengthBeats();
+        const double oldTime = getPositionBeats();
+        const double oldLen = getLengthBeats();
 
-        ts.setTempo (bpm);
-        ts.updateScale();
-        framesPerBeat = (double) Tempo::audioFramesPerBeat ((double) ts.getSampleRate(), ts.getTempo());
+        ts->setTempo (bpm);
+        ts->updateScale();
 
-        beatsPerFrame = 1.0f / framesPerBeat;
-        framePos = llrint (oldTime * framesPerBeat);
-        duration = (uint32_t) llrint (oldLen * framesPerBeat);
+        framePos = frameFromBeats (oldTime);
+        duration = (uint32_t) frameFromBeats (oldLen);
+        locate();
     }
 }
 
@@ -121,20 +184,64 @@ void Shuttle::setSampleRate (double rate)
 
     const double oldTime = getPositionSeconds();
     const double oldLenSec = (double) getLengthSeconds();
-    ts.setSampleRate (rate);
-    ts.updateScale();
+    sampleRate = rate;
+    ts->setSampleRate ((unsigned int) rate);
+    ts->updateScale();
 
-    framePos = llrint (oldTime * ts.getSampleRate());
-    duration = (uint32_t) (oldLenSec * (float) ts.getSampleRate());
-    framesPerBeat = Tempo::audioFramesPerBeat (ts.getSampleRate(), ts.getTempo());
-    beatsPerFrame = 1.0f / framesPerBeat;
+    framePos = llrint (oldTime * ts->getSampleRate());
+    duration = (uint32_t) (oldLenSec * (float) ts->getSampleRate());
+    locate();
 }
 
 void Shuttle::advance (int nframes)
 {
     framePos += nframes;
     if (duration > 0 && framePos >= duration)
+    {
         framePos = framePos - duration;
+        locate();
+        return;
+    }
+
+    stepSegments();
+}
+
+void Shuttle::locate()
+{
+    segment = ts->nodes().first();
+    segmentBeats = 0.0;
+    updateSegmentRate();
+    stepSegments();
+}
+
+TimeScale* Shuttle::exchangeTimeScale (TimeScale* newScale)
+{
+    jassert (newScale != nullptr);
+    auto* const oldScale = ts.release();
+    ts.reset (newScale);
+    ts->setSampleRate (oldScale->getSampleRate());
+    ts->setTicksPerBeat (Shuttle::PPQ);
+    ts->updateScale();
+    locate();
+    return oldScale;
+}
+
+void Shuttle::updateSegmentRate()
+{
+    framesPerBeat = segment != nullptr ? detail::framesPerBeat (*segment, getSampleRate())
+                                       : getSampleRate() * 60.0 / (double) ts->getTempo();
+    beatsPerFrame = 1.0 / framesPerBeat;
+}
+
+void Shuttle::stepSegments()
+{
+    while (segment != nullptr && segment->next() != nullptr
+           && framePos >= (int64_t) segment->next()->frame)
+    {
+        segmentBeats += (double) (segment->next()->frame - segment->frame) * beatsPerFrame;
+        segment = segment->next();
+        updateSegmentRate();
+    }
 }
 
 } // namespace element
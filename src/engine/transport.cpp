@@ -47,7 +47,7 @@ double Transport::Monitor::getPositionSeconds() const
 
 float Transport::Monitor::getPositionBeats() const
 {
-    return getPositionSeconds() * (tempo.get() / 60.f);
+    return (float) positionBeats.get();
 }
 
 void Transport::Monitor::getBarsAndBeats (int& bars, int& beats, int& subBeats, int subDivisions)
@@ -69,15 +69,34 @@ Transport::Transport()
     seekFrame.set (0);
 
     nextBeatsPerBar.set (getBeatsPerBar());
-    nextBeatDivisor.set (getBeatType());
+    nextBeatDivisor.set (ts->beatDivisor());
 
     setLengthFrames (0);
 }
 
-Transport::~Transport() {}
+Transport::~Transport()
+{
+    delete nextMap.exchange (nullptr);
+    reclaimTempoMaps();
+}
 
 void Transport::preProcess (int nframes)
 {
+    // with nowhere to retire the old map, the new one waits for a later block.
+    auto* const map = retiredFifo.getFreeSpace() > 0 ? nextMap.exchange (nullptr) : nullptr;
+    if (map != nullptr)
+    {
+        const auto scope = retiredFifo.write (1);
+        retired[scope.startIndex1] = exchangeTimeScale (map);
+
+        // the new map's first tempo and meter win over older requests.
+        nextTempo.set (ts->getTempo());
+        nextBeatsPerBar.set (ts->beatsPerBar());
+        nextBeatDivisor.set (ts->beatDivisor());
+        monitor->beatsPerBar.set (ts->beatsPerBar());
+        monitor->beatDivisor.set (ts->beatDivisor());
+    }
+
     if (recording != recordState.get())
     {
         recording = recordState.get();
@@ -95,35 +114,33 @@ void Transport::preProcess (int nframes)
 
 void Transport::postProcess (int nframes)
 {
-    if (getTempo() != nextTempo.get())
+    // requested tempo and meter apply to the first node in the map.
+    if (ts->getTempo() != nextTempo.get())
     {
         setTempo (nextTempo.get());
-        nextTempo.set (getTempo());
-        monitor->tempo.set (nextTempo.get());
+        nextTempo.set (ts->getTempo());
     }
 
-    monitor->playing.set (playing);
-    monitor->recording.set (recording);
-    monitor->positionFrames.set (getPositionFrames());
-
     bool updateTimeScale = false;
     if (getBeatsPerBar() != nextBeatsPerBar.get())
     {
-        ts.setBeatsPerBar ((unsigned short) nextBeatsPerBar.get());
+        ts->setBeatsPerBar ((unsigned short) nextBeatsPerBar.get());
         monitor->beatsPerBar.set (getBeatsPerBar());
         updateTimeScale = true;
     }
 
-    if (ts.beatDivisor() != nextBeatDivisor.get())
+    if (ts->beatDivisor() != nextBeatDivisor.get())
     {
-        ts.setBeatType ((unsigned short) nextBeatDivisor.get());
-        ts.setBeatDivisor (1 << ts.beatType());
+        ts->setBeatDivisor ((unsigned short) nextBeatDivisor.get());
         monitor->beatDivisor.set (nextBeatDivisor.get());
         updateTimeScale = true;
     }
 
     if (updateTimeScale)
-        ts.updateScale();
+    {
+        ts->updateScale();
+        locate();
+    }
 
     if (seekWanted.get())
     {
@@ -131,6 +148,12 @@ void Transport::postProcess (int nframes)
             seekAudioFrame (seekFrame.get());
         seekWanted.set (false);
     }
+
+    monitor->tempo.set (getTempo());
+    monitor->playing.set (playing);
+    monitor->recording.set (recording);
+    monitor->positionFrames.set (getPositionFrames());
+    monitor->positionBeats.set (getPositionBeats());
 }
 
 void Transport::requestMeter (int beatsPerBar, int beatDivisor)
@@ -154,4 +177,22 @@ void Transport::requestAudioFrame (const int64_t frame)
     seekWanted.set (true);
 }
 
+void Transport::requestTempoMap (const TimeScale& map)
+{
+    reclaimTempoMaps();
+    auto* const newMap = new TimeScale (map);
+    newMap->setTicksPerBeat (Shuttle::PPQ);
+    // a map the audio thread never picked up can go right away.
+    delete nextMap.exchange (newMap);
+}
+
+void Transport::reclaimTempoMaps()
+{
+    const auto scope = retiredFifo.read (retiredFifo.getNumReady());
+    scope.forEach ([this] (int index) {
+        delete retired[index];
+        retired[index] = nullptr;
+    });
+}
+
 } // namespace element
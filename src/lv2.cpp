@@ -472,20 +472,19 @@ public:
 
         // if (! module->hasEditor())
         {
-            jassert (module->onPortNotify == nullptr);
             namespace ph = std::placeholders;
-            module->onPortNotify = std::bind (&LV2Processor::portEvent,
-                                              this,
-                                              ph::_1,
-                                              ph::_2,
-                                              ph::_3,
-                                              ph::_4);
+            module->setPortNotifier (std::bind (&LV2Processor::portEvent,
+                                                this,
+                                                ph::_1,
+                                                ph::_2,
+                                                ph::_3,
+                                                ph::_4));
         }
     }
 
     ~LV2Processor()
     {
-        module->onPortNotify = nullptr;
+        module->setPortNotifier (nullptr);
         module = nullptr;
     }
 
@@ -731,6 +730,8 @@ public:
     bool wantsContext() const noexcept override { return true; }
 
     double getTailLengthSeconds() const { return 0.0f; }
+    // LV2 has no way to describe a tail.
+    double getTailSeconds() const override { return unknownTailSeconds; }
     void* getPlatformSpecificData() { return module->getHandle(); }
 
     bool silenceInProducesSilenceOut() const { return false; }
@@ -1168,6 +1169,7 @@ public:
 
     LV2Processor* instantiate (const String& uri)
     {
+        const ScopedLock sl (world->getLock());
         LV2Processor* proc = nullptr;
 
         if (LV2Module* module = world->createModule (uri))
@@ -1267,6 +1269,23 @@ StringArray LV2NodeProvider::findTypes (const juce::FileSearchPath&, bool, bool)
     return types;
 }
 
+File LV2NodeProvider::fileForType (const String& uri)
+{
+    const auto* plugin = lv2->world->getPlugin (uri);
+    const auto* library = plugin != nullptr ? lilv_plugin_get_library_uri (plugin) : nullptr;
+    if (library == nullptr)
+        return {};
+
+    File binary;
+    if (char* path = lilv_file_uri_parse (lilv_node_as_uri (library), nullptr))
+    {
+        binary = File (String::fromUTF8 (path));
+        lilv_free (path);
+    }
+
+    return binary;
+}
+
 String LV2NodeProvider::nameForURI (const String& uri) const noexcept
 {
     auto plugin = lv2->world->getPlugin (uri);
@@ -0,0 +1,62 @@
+// Copyright 2014-2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "lv2/dispatcher.hpp"
+#include "lv2/module.hpp"
+
+namespace element {
+
+NotificationDispatcher::~NotificationDispatcher()
+{
+    jassert (modules.isEmpty());
+    stopTimer();
+}
+
+void NotificationDispatcher::add (LV2Module& module)
+{
+    modules.addIfNotAlreadyThere (&module);
+    if (! isTimerRunning())
+        startTimerHz (60);
+}
+
+void NotificationDispatcher::remove (LV2Module& module)
+{
+    modules.removeFirstMatchingValue (&module);
+    if (modules.isEmpty())
+        stopTimer();
+
+    // unlink the module if it is still waiting, keeping the others.
+    auto* list = pending.exchange (nullptr, std::memory_order_acquire);
+    while (list != nullptr)
+    {
+        auto* const next = list->nextPending;
+        if (list != &module)
+            modulePending (*list);
+        list = next;
+    }
+    module.nextPending = nullptr;
+}
+
+void NotificationDispatcher::modulePending (LV2Module& module) noexcept
+{
+    auto* head = pending.load (std::memory_order_relaxed);
+    do
+        module.nextPending = head;
+    while (! pending.compare_exchange_weak (head, &module, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void NotificationDispatcher::dispatch()
+{
+    // a module is only pushed again after its notifications are taken, so
+    // read the link before dispatching.
+    auto* list = pending.exchange (nullptr, std::memory_order_acquire);
+    while (list != nullptr)
+    {
+        auto* const next = list->nextPending;
+        list->nextPending = nullptr;
+        list->dispatchNotifications();
+        list = next;
+    }
+}
+
+} // namespace element
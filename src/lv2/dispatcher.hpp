@@ -0,0 +1,46 @@
+// Copyright 2014-2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/events.hpp>
+
+namespace element {
+
+class LV2Module;
+
+/** Delivers plugin to UI notifications for every LV2Module of a World
+    from a single timer on the message thread.
+
+    Modules push themselves on a lock-free list when they have queued
+    notifications, and a tick only visits the modules on that list.
+    Nothing happens on a tick when no module was flagged.
+ */
+class NotificationDispatcher final : private juce::Timer
+{
+public:
+    NotificationDispatcher() = default;
+    ~NotificationDispatcher() override;
+
+    /** Start dispatching for a module (message thread). */
+    void add (LV2Module& module);
+
+    /** Stop dispatching for a module (message thread). */
+    void remove (LV2Module& module);
+
+    /** Called by a module after it flagged itself (realtime). */
+    void modulePending (LV2Module& module) noexcept;
+
+    /** Drain flagged modules now. */
+    void dispatch();
+
+private:
+    juce::Array<LV2Module*> modules;
+    std::atomic<LV2Module*> pending { nullptr }; ///< flagged modules, linked by nextPending
+
+    void timerCallback() override { dispatch(); }
+};
+
+} // namespace element
@@ -172,9 +172,39 @@ public:
         uiptr->binaryPath = supportedUI.binary;
         uiptr->requireShow = supportedUI.useShowInterface;
         this->ui = uiptr;
+        updateListening();
         return uiptr;
     }
 
+    void updateListening()
+    {
+        const bool isListening = ui != nullptr || owner.onPortNotify != nullptr;
+        const bool wasListening = listening.exchange (isListening, std::memory_order_relaxed);
+        // a state restored before anyone listened still needs sending.
+        if (isListening && ! wasListening && inputsChanged.load (std::memory_order_acquire))
+            markDirty();
+    }
+
+    /** Flag notifications as queued (any thread). */
+    void markDirty() noexcept
+    {
+        if (! dirty.exchange (true, std::memory_order_acq_rel))
+            owner.world.getNotificationDispatcher().modulePending (owner);
+    }
+
+    /** Send control input values restored from a state (message thread). */
+    void sendControlInputs()
+    {
+        for (const auto port : controlInputs)
+        {
+            auto* const data = buffers.getUnchecked ((int) port)->getPortData();
+            if (ui)
+                ui->portEvent (port, sizeof (float), 0, data);
+            if (owner.onPortNotify)
+                owner.onPortNotify (port, sizeof (float), 0, data);
+        }
+    }
+
     void sendControlValues()
     {
         if (! ui && ! owner.onPortNotify)
@@ -197,18 +227,23 @@ public:
         }
     }
 
+    /** Returns the index of a port by symbol, or -1 if there isn't one. */
+    int findPort (const String& symbol) const noexcept
+    {
+        return portSymbols.contains (symbol) ? (int) portSymbols[symbol] : -1;
+    }
+
+    /** Returns the index of a control port by symbol, or -1 if there isn't one. */
+    int findControlPort (const char* symbol) const
+    {
+        const int index = findPort (String::fromUTF8 (symbol));
+        return index >= 0 && buffers.getUnchecked (index)->isControl() ? index : -1;
+    }
+
     static const void* getPortValue (const char* port_symbol, void* user_data, uint32_t* size, uint32_t* type)
     {
         LV2Module::Private* priv = static_cast<LV2Module::Private*> (user_data);
-        int portIdx = -1;
-        for (const auto* port : priv->ports.getPorts())
-        {
-            if (port->symbol == port_symbol && port->type == PortType::Control)
-            {
-                portIdx = port->index;
-                break;
-            }
-        }
+        const int portIdx = priv->findControlPort (port_symbol);
 
         if (portIdx >= 0)
         {
@@ -233,27 +268,18 @@ public:
                               uint32_t type)
     {
         auto* priv = (Private*) user_data;
-        auto& plugin = priv->owner;
-        lvtk::ignore (plugin);
         if (type != priv->owner.map (LV2_ATOM__Float))
             return;
 
-        int portIdx = -1;
-        const PortDescription* port = nullptr;
-        for (const auto* p : priv->ports.getPorts())
-        {
-            port = p;
-            if (port->symbol == port_symbol && port->type == PortType::Control)
-            {
-                portIdx = port->index;
-                break;
-            }
-        }
-
-        if (portIdx >= 0 && port)
+        const int portIdx = priv->findControlPort (port_symbol);
+        if (portIdx >= 0)
         {
             if (auto* const buffer = priv->buffers[portIdx])
+            {
                 buffer->setValue (*((float*) value));
+                priv->inputsChanged.store (true, std::memory_order_release);
+                priv->markDirty();
+            }
         }
     }
 
@@ -271,6 +297,13 @@ private:
 
     HeapBlock<float> mins, maxes, defaults, current;
     OwnedArray<PortBuffer> buffers;
+    HashMap<String, uint32> portSymbols; ///< port indexes by symbol
+    std::vector<uint32> controlInputs; ///< indexes of control input ports
+    std::vector<uint32> controlOutputs; ///< indexes of control output ports
+
+    std::atomic<bool> listening { false }; ///< true if there is a UI or notifier
+    std::atomic<bool> dirty { false }; ///< true if notifications are queued
+    std::atomic<bool> inputsChanged { false }; ///< true if a state set control inputs
 
     std::vector<LV2PatchInfo> patchParams;
     uint32_t atomControlInIndex { EL_INVALID_PORT };
@@ -314,6 +347,7 @@ void LV2Module::init()
     priv->current.allocate (numPorts, true);
 
     lilv_plugin_get_port_ranges_float (plugin, priv->mins, priv->maxes, priv->defaults);
+    priv->portSymbols.remapTable (jmax (101, (int) numPorts * 2));
 
     auto timeNode = world.makeURI (LV2_TIME__Position);
     // initialize each port
@@ -342,6 +376,7 @@ void LV2Module::init()
         const String symbol = lilv_node_as_string (lilv_port_get_symbol (plugin, port));
 
         priv->ports.add (type, p, priv->ports.size (type, isInput), symbol, name, isInput);
+        priv->portSymbols.set (symbol, p);
         priv->channels.addPort (type, p, isInput);
 
         uint32 capacity = sizeof (float);
@@ -378,7 +413,13 @@ void LV2Module::init()
             new PortBuffer (isInput, type, dataType, capacity));
 
         if (type == PortType::Control)
+        {
             buf->setValue (priv->defaults[p]);
+            if (isInput)
+                priv->controlInputs.push_back (p);
+            else
+                priv->controlOutputs.push_back (p);
+        }
 
         if (type == PortType::Atom && isInput)
         {
@@ -444,7 +485,6 @@ void LV2Module::loadDefaultState()
             const LV2_Feature* const features[] = { nullptr };
             lilv_state_restore (state, instance, Private::setPortValue, priv.get(), LV2_STATE_IS_POD, features);
             lilv_state_free (state);
-            priv->sendControlValues();
         }
 
         lilv_node_free (uriNode);
@@ -456,6 +496,7 @@ String LV2Module::getStateString() const
     if (instance == nullptr)
         return String();
 
+    const ScopedLock sl (world.getLock());
     auto* const map = (LV2_URID_Map*) world.getFeatures().getFeature (LV2_URID__map)->getFeature()->data;
     auto* const unmap = (LV2_URID_Unmap*) world.getFeatures().getFeature (LV2_URID__unmap)->getFeature()->data;
     const String descURI = "http://kushview.net/kv/state";
@@ -481,6 +522,7 @@ void LV2Module::setStateString (const String& stateStr)
 {
     if (instance == nullptr)
         return;
+    const ScopedLock sl (world.getLock());
     auto* const map = (LV2_URID_Map*) world.getFeatures().getFeature (LV2_URID__map)->getFeature()->data;
     auto* const unmap = (LV2_URID_Unmap*) world.getFeatures().getFeature (LV2_URID__unmap)->getFeature()->data;
     lvtk::ignore (unmap);
@@ -489,12 +531,12 @@ void LV2Module::setStateString (const String& stateStr)
         const LV2_Feature* const features[] = { nullptr };
         lilv_state_restore (state, instance, Private::setPortValue, priv.get(), LV2_STATE_IS_POD, features);
         lilv_state_free (state);
-        priv->sendControlValues();
     }
 }
 
 Result LV2Module::instantiate (double samplerate)
 {
+    const ScopedLock sl (world.getLock());
     freeInstance();
     jassert (instance == nullptr);
     currentSampleRate = samplerate;
@@ -509,7 +551,7 @@ Result LV2Module::instantiate (double samplerate)
         const LilvNode* node = lilv_nodes_get (nodes, iter);
         if (lilv_node_equals (node, world.work_interface))
         {
-            worker = std::make_unique<WorkerFeature> (world.getWorkThread(), 1);
+            worker = std::make_unique<WorkerFeature> (world.getWorkerPool(), 1);
             features.add (worker->getFeature());
         }
     }
@@ -540,7 +582,7 @@ Result LV2Module::instantiate (double samplerate)
     }
 
     loadDefaultState();
-    startTimerHz (60);
+    world.getNotificationDispatcher().add (*this);
     return Result::ok();
 }
 
@@ -577,7 +619,8 @@ bool LV2Module::isActive() const
 
 void LV2Module::freeInstance()
 {
-    stopTimer();
+    world.getNotificationDispatcher().remove (*this);
+    priv->dirty.store (false, std::memory_order_release);
     if (instance != nullptr)
     {
         deactivate();
@@ -902,10 +945,17 @@ void LV2Module::clearEditor()
     {
         auto ui = priv->ui;
         priv->ui = nullptr;
+        priv->updateListening();
         ui = nullptr;
     }
 }
 
+void LV2Module::setPortNotifier (PortNotificationFunction notifier)
+{
+    onPortNotify = notifier;
+    priv->updateListening();
+}
+
 PortBuffer* LV2Module::getPortBuffer (uint32 port) const
 {
     jassert (port < numPorts);
@@ -914,10 +964,8 @@ PortBuffer* LV2Module::getPortBuffer (uint32 port) const
 
 uint32 LV2Module::getPortIndex (const String& symbol) const
 {
-    for (const auto* port : priv->ports.getPorts())
-        if (port->symbol == symbol)
-            return static_cast<uint32> (port->index);
-    return LV2UI_INVALID_PORT_INDEX;
+    const int index = priv->findPort (symbol);
+    return index >= 0 ? static_cast<uint32> (index) : LV2UI_INVALID_PORT_INDEX;
 }
 
 LV2ModuleUI* LV2Module::createEditor()
@@ -960,8 +1008,14 @@ bool LV2Module::isPortOutput (uint32 index) const
     return lilv_port_is_a (plugin, getPort (index), world.lv2_OutputPort);
 }
 
-void LV2Module::timerCallback()
+void LV2Module::dispatchNotifications()
 {
+    priv->dirty.store (false, std::memory_order_release);
+
+    if (priv->listening.load (std::memory_order_relaxed)
+        && priv->inputsChanged.exchange (false, std::memory_order_acq_rel))
+        priv->sendControlInputs();
+
     priv->eventsOut.read_all ([this] (lvtk::MessageHeader header, uint32_t size, const void* data) {
         if (header.protocol == 0 || header.protocol == priv->atom_eventTransfer)
         {
@@ -1052,7 +1106,10 @@ void LV2Module::referBuffers (RenderContext& rc)
 
 void LV2Module::processEvents()
 {
-    priv->eventsIn.read_all ([this] (lvtk::MessageHeader header, [[maybe_unused]] uint32_t size, const void* data) {
+    const bool listening = priv->listening.load (std::memory_order_relaxed);
+    bool notified = false;
+
+    priv->eventsIn.read_all ([&] (lvtk::MessageHeader header, [[maybe_unused]] uint32_t size, const void* data) {
         const int index = static_cast<int> (header.portIndex);
 
         if (header.protocol == 0 || header.protocol == priv->ui_floatProtocol)
@@ -1061,7 +1118,18 @@ void LV2Module::processEvents()
             {
                 const auto value = juce::readUnaligned<float> (data);
                 if (buffer->getValue() != value)
+                {
                     buffer->setValue (value);
+                    priv->current[index] = value;
+
+                    // echo input changes so the UI and parameters agree.
+                    if (listening && buffer->isControl())
+                    {
+                        lvtk::MessageHeader echo = { header.portIndex, 0 };
+                        priv->eventsOut.push_message (echo, sizeof (float), &value);
+                        notified = true;
+                    }
+                }
             }
         }
         else if (auto* atomPort = index < priv->buffers.size() ? priv->buffers.getUnchecked (index) : nullptr)
@@ -1085,6 +1153,9 @@ void LV2Module::processEvents()
             }
         }
     });
+
+    if (notified)
+        priv->markDirty();
 }
 
 void LV2Module::run (uint32 nframes)
@@ -1097,14 +1168,19 @@ void LV2Module::run (uint32 nframes)
     if (worker)
         worker->endRun();
 
-    for (int i = priv->buffers.size(); --i >= 0;)
+    if (! priv->listening.load (std::memory_order_relaxed))
+        return;
+
+    bool notified = false;
+    for (const auto port : priv->controlOutputs)
     {
-        auto buffer = priv->buffers.getUnchecked (i);
-        if (buffer->isControl() && priv->current[i] != buffer->getValue())
+        const auto value = priv->buffers.getUnchecked ((int) port)->getValue();
+        if (priv->current[port] != value)
         {
-            priv->current[i] = buffer->getValue();
-            lvtk::MessageHeader header = { static_cast<uint32_t> (i), 0 };
-            priv->eventsOut.push_message (header, sizeof (float), &priv->current[i]);
+            priv->current[port] = value;
+            lvtk::MessageHeader header = { port, 0 };
+            priv->eventsOut.push_message (header, sizeof (float), &value);
+            notified = true;
         }
     }
 
@@ -1118,8 +1194,12 @@ void LV2Module::run (uint32 nframes)
             priv->eventsOut.push_message (header,
                                           lv2_atom_total_size (&ev->body),
                                           &ev->body);
+            notified = true;
         }
     }
+
+    if (notified)
+        priv->markDirty();
 }
 
 uint32 LV2Module::map (const String& uri) const
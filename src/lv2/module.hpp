@@ -112,7 +112,7 @@ struct SupportedUI
     Methods that are realtime/thread safe are excplicity documented as so.
     All other methods are NOT realtime safe
  */
-class LV2Module : private Timer
+class LV2Module
 {
 public:
     /** Create a new LV2Module */
@@ -121,10 +121,11 @@ public:
     /** Destructor */
     ~LV2Module();
 
-    /** If set will be called on the message thread when a notification
-        is received from the plugin. 
+    /** Set a function to be called on the message thread when a notification
+        is received from the plugin. Pass nullptr to clear it. Notifications
+        aren't collected while there is no function and no editor.
      */
-    PortNotificationFunction onPortNotify;
+    void setPortNotifier (PortNotificationFunction notifier);
 
     /** Get the total number of ports for this plugin */
     uint32 getNumPorts() const;
@@ -348,7 +349,11 @@ private:
     void freeInstance();
     void init();
 
-    void timerCallback() override;
+    friend class NotificationDispatcher;
+    PortNotificationFunction onPortNotify;
+    LV2Module* nextPending { nullptr }; ///< link in the dispatcher's pending list
+    /** Deliver queued notifications if there are any (message thread). */
+    void dispatchNotifications();
 
     class Private;
     std::unique_ptr<Private> priv;
@@ -17,213 +17,243 @@ using namespace juce;
 
 namespace element {
 
-WorkThread::WorkThread (const String& name, uint32_t bufsize, Thread::Priority priority)
-    : Thread (name)
+//==============================================================================
+class WorkerPool::Thread final : public juce::Thread
 {
-    nextWorkId = 0;
-    bufferSize = (uint32_t) nextPowerOfTwo (bufsize);
-    requests = std::make_unique<RingBuffer> (bufferSize);
-    startThread (priority);
-}
+public:
+    Thread (WorkerPool& p, const String& name, uint32_t bufsize)
+        : juce::Thread (name), pool (p)
+    {
+        buffer.allocate (bufsize, false);
+    }
 
-WorkThread::~WorkThread()
-{
-    doExit = true;
-    signalThreadShouldExit();
-    notify();
-    waitForThreadToExit (100);
-    requests = nullptr;
-}
+    ~Thread() override
+    {
+        signalThreadShouldExit();
+        notify();
+        stopThread (1000);
+    }
 
-WorkerBase* WorkThread::getWorker (uint32_t workerId) const
-{
-    if (workerId == 0)
-        return nullptr;
+    /** Wake the thread if it is waiting for work. */
+    bool wake() noexcept
+    {
+        if (! idle.exchange (false))
+            return false;
+        notify();
+        return true;
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (auto* worker = pool.pop())
+            {
+                idle.store (false);
+                if (pool.process (*worker, buffer))
+                    pool.push (worker);
+                continue;
+            }
 
-    for (int i = 0; i < workers.size(); ++i)
-        if (workers.getUnchecked (i)->workId == workerId)
-            return workers.getUnchecked (i);
+            // go idle, then look once more so a worker queued in between
+            // isn't missed.
+            idle.store (true);
+            if (auto* worker = pool.pop())
+            {
+                idle.store (false);
+                if (pool.process (*worker, buffer))
+                    pool.push (worker);
+                continue;
+            }
 
-    return nullptr;
-}
+            wait (100);
+        }
+    }
 
-void WorkThread::addWorker (WorkerBase* worker)
+private:
+    WorkerPool& pool;
+    HeapBlock<uint8_t> buffer;
+    std::atomic<bool> idle { false };
+};
+
+//==============================================================================
+WorkerPool::WorkerPool (const String& name, int numThreads, uint32_t bufsize, Priority priority)
+    : bufferSize ((uint32_t) nextPowerOfTwo ((int) bufsize))
 {
-    worker->workId = ++nextWorkId;
-    WORKER_LOG (getThreadName() + " registering worker: " + String (worker->workId));
-    workers.addIfNotAlreadyThere (worker);
+    slots.reset (new Slot[queueSize]);
+    for (size_t i = 0; i < queueSize; ++i)
+        slots[i].sequence.store (i, std::memory_order_relaxed);
+
+    for (int i = 0; i < jmax (1, numThreads); ++i)
+    {
+        auto* thread = threads.add (new Thread (*this, name + " " + String (i + 1), bufferSize));
+        thread->startThread (priority);
+    }
 }
 
-void WorkThread::removeWorker (WorkerBase* worker)
+WorkerPool::~WorkerPool()
 {
-    WORKER_LOG (getThreadName() + " removing worker: " + String (worker->workId));
-    workers.removeFirstMatchingValue (worker);
-    worker->workId = 0;
+    jassert (numWorkers.load() == 0);
+    threads.clear();
 }
 
-void WorkThread::run()
+bool WorkerPool::push (WorkerBase* worker) noexcept
 {
-    HeapBlock<uint8> buffer;
-    int32 readBufferSize = 0;
-
-    while (true)
+    auto pos = tail.load (std::memory_order_relaxed);
+    for (;;)
     {
-        this->wait (-1);
-
-        if (doExit || threadShouldExit())
-            break;
-
-        while (! validateMessage (*requests))
-            Thread::sleep (6);
-
-        if (doExit || threadShouldExit())
-            break;
-
-        uint32_t size = 0;
-        if (requests->read (&size, sizeof (size)) < sizeof (size))
-        {
-            WORKER_LOG ("error reading request: message size");
-            continue;
-        }
-
-        uint32_t workId;
-        if (requests->read (&workId, sizeof (workId)) < sizeof (workId))
+        auto& slot = slots[pos & (queueSize - 1)];
+        const auto seq = slot.sequence.load (std::memory_order_acquire);
+        const auto diff = (intptr_t) seq - (intptr_t) pos;
+        if (diff == 0)
         {
-            WORKER_LOG ("error reading request: worker id");
-            continue;
+            if (tail.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
+            {
+                slot.worker = worker;
+                slot.sequence.store (pos + 1, std::memory_order_release);
+                return true;
+            }
         }
-
-        if (workId == 0)
-            continue;
-
-        if (size > static_cast<uint32_t> (readBufferSize))
+        else if (diff < 0)
         {
-            readBufferSize = nextPowerOfTwo (size);
-            buffer.realloc (readBufferSize);
+            return false;
         }
-
-        if (requests->read (buffer.getData(), size) < size)
+        else
         {
-            WORKER_LOG ("error reading request: message body");
-            continue;
+            pos = tail.load (std::memory_order_relaxed);
         }
+    }
+}
 
+WorkerBase* WorkerPool::pop() noexcept
+{
+    auto pos = head.load (std::memory_order_relaxed);
+    for (;;)
+    {
+        auto& slot = slots[pos & (queueSize - 1)];
+        const auto seq = slot.sequence.load (std::memory_order_acquire);
+        const auto diff = (intptr_t) seq - (intptr_t) (pos + 1);
+        if (diff == 0)
         {
-            if (WorkerBase* const worker = getWorker (workId))
+            if (head.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
             {
-                while (! worker->flag.setWorking (true))
-                {
-                }
-                worker->processRequest (size, buffer.getData());
-                while (! worker->flag.setWorking (false))
-                {
-                }
+                auto* worker = slot.worker;
+                slot.sequence.store (pos + queueSize, std::memory_order_release);
+                return worker;
             }
         }
-
-        if (threadShouldExit() || doExit)
-            break;
+        else if (diff < 0)
+        {
+            return nullptr;
+        }
+        else
+        {
+            pos = head.load (std::memory_order_relaxed);
+        }
     }
-
-    buffer.free();
 }
 
-bool WorkThread::scheduleWork (WorkerBase* worker, uint32_t size, const void* data)
+void WorkerPool::schedule (WorkerBase& worker) noexcept
 {
-    jassert (size > 0 && worker && worker->workId != 0);
-    if (! requests->canWrite (getRequiredSpace (size)))
-        return false;
-
-    if (requests->write (&size, sizeof (size)) < sizeof (uint32_t))
-        return false;
-
-    if (requests->write (&worker->workId, sizeof (worker->workId)) < sizeof (worker->workId))
-        return false;
+    if (worker.scheduled.exchange (true))
+        return;
 
-    if (requests->write (data, size) < size)
-        return false;
+    if (! push (&worker))
+    {
+        // the request stays queued and goes out with the next one.
+        jassertfalse;
+        worker.scheduled.store (false);
+        return;
+    }
 
-    notify();
-    return true;
+    for (auto* thread : threads)
+        if (thread->wake())
+            break;
 }
 
-bool WorkThread::validateMessage (RingBuffer& ring)
+bool WorkerPool::process (WorkerBase& worker, HeapBlock<uint8_t>& buffer)
 {
+    // counted, so a thread that schedules the worker again cannot be
+    // hidden by this one finishing.
+    worker.running.fetch_add (1, std::memory_order_acq_rel);
+
+    int handled = 0;
     uint32_t size = 0;
-    ring.peak (&size, sizeof (size));
-    return ring.canRead (getRequiredSpace (size));
+    while (handled < maxBatchSize && (size = worker.requests.readMessage (buffer.getData(), bufferSize)) > 0)
+    {
+        if (worker.active.load())
+            worker.processRequest (size, buffer.getData());
+        ++handled;
+    }
+
+    bool more = worker.requests.getReadSpace() > 0 && worker.active.load();
+    if (! more)
+    {
+        // a request written after the last read may have seen the worker
+        // as scheduled, so look again once it isn't.
+        worker.scheduled.store (false);
+        more = worker.requests.getReadSpace() > 0 && worker.active.load() && ! worker.scheduled.exchange (true);
+    }
+
+    // nothing may touch the worker after this.
+    worker.running.fetch_sub (1, std::memory_order_acq_rel);
+    return more;
 }
 
-WorkerBase::WorkerBase (WorkThread& thread, uint32_t bufsize)
-    : owner (thread)
+//==============================================================================
+WorkerBase::WorkerBase (WorkerPool& pool, uint32_t bufsize)
+    : owner (pool),
+      requests ((int32) pool.bufferSize),
+      responses (1)
 {
-    bufsize = juce::nextPowerOfTwo (bufsize);
-    responses = std::make_unique<RingBuffer> (bufsize);
-    response.calloc (bufsize);
-    thread.addWorker (this);
+    setSize (bufsize);
+    owner.numWorkers.fetch_add (1);
+    jassert ((size_t) owner.numWorkers.load() < WorkerPool::queueSize);
 }
 
 WorkerBase::~WorkerBase()
 {
-    while (flag.isWorking())
-    {
-        Thread::sleep (100);
-    }
-
-    owner.removeWorker (this);
-    responses = nullptr;
+    stopWork();
+    owner.numWorkers.fetch_sub (1);
     response.free();
 }
 
-bool WorkerBase::scheduleWork (uint32_t size, const void* data)
+void WorkerBase::stopWork()
 {
-    return owner.scheduleWork (this, size, data);
+    active.store (false);
+    // a thread may hold the worker until it has finished with it. check
+    // scheduled first: process() counts itself in before clearing it.
+    while (scheduled.load() || running.load (std::memory_order_acquire) > 0)
+        Thread::sleep (1);
 }
 
-bool WorkerBase::respondToWork (uint32_t size, const void* data)
+bool WorkerBase::scheduleWork (uint32_t size, const void* data)
 {
-    if (! responses->canWrite (sizeof (size) + size))
-        return false;
-
-    if (responses->write (&size, sizeof (size)) < sizeof (size))
-        return false;
-
-    if (responses->write (data, size) < size)
+    jassert (size > 0 && data != nullptr);
+    if (! active.load() || ! requests.writeMessage (data, size))
         return false;
-
+    owner.schedule (*this);
     return true;
 }
 
-void WorkerBase::processWorkResponses()
+bool WorkerBase::respondToWork (uint32_t size, const void* data)
 {
-    uint32_t remaining = responses->getReadSpace();
-    uint32_t size = 0;
-
-    while (remaining >= sizeof (uint32_t))
-    {
-        /* respond next cycle if response isn't ready */
-        if (! validateMessage (*responses))
-            return;
-
-        responses->read (&size, sizeof (size));
-        responses->read (response.getData(), size);
-        processResponse (size, response.getData());
-        remaining -= (sizeof (uint32_t) + size);
-    }
+    return size <= responseSize && responses.writeMessage (data, size);
 }
 
-bool WorkerBase::validateMessage (RingBuffer& ring)
+void WorkerBase::processWorkResponses()
 {
-    // the worker only validates message size
     uint32_t size = 0;
-    ring.peak (&size, sizeof (size));
-    return ring.canRead (size + sizeof (size));
+    while ((size = responses.readMessage (response.getData(), responseSize)) > 0)
+        processResponse (size, response.getData());
 }
 
 void WorkerBase::setSize (uint32_t newSize)
 {
-    responses = std::make_unique<RingBuffer> (newSize);
+    newSize = (uint32_t) nextPowerOfTwo ((int) jmax ((uint32_t) 1, newSize));
+    responses.setCapacity ((int32) newSize);
     response.realloc (newSize);
+    responseSize = newSize;
 }
 
 } // namespace element
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 
 #include <element/juce/core.hpp>
@@ -13,77 +14,85 @@ namespace element {
 
 class WorkerBase;
 
-/** A worker thread
+/** A pool of worker threads
     Capable of scheduling non-realtime work from a realtime context.
+
+    Every worker has its own request and response queues, so a plugin
+    flooding its worker can't fill up anyone else's. Workers with pending
+    requests wait in a first-come first-served ready queue. A thread takes
+    one, handles a batch of its requests, and puts it at the back of the
+    queue if more are left. A worker is never handled by two threads at once.
  */
-class WorkThread : public juce::Thread
+class WorkerPool final
 {
 public:
     using Priority = juce::Thread::Priority;
-    WorkThread (const juce::String& name, uint32_t bufsize, Priority priority = Priority::normal);
-    ~WorkThread();
-
-    inline static uint32_t getRequiredSpace (uint32_t msgSize) { return msgSize + (2 * sizeof (uint32_t)); }
-
-protected:
-    friend class WorkerBase;
-
-    /** Register a worker for scheduling. Does not take ownership */
-    void addWorker (WorkerBase* worker);
-
-    /** Deregister a worker from scheduling. Does not delete the worker */
-    void removeWorker (WorkerBase* worker);
-
-    /** Schedule non-realtime work
-        Workers will call this in Worker::scheduleWork */
-    bool scheduleWork (WorkerBase* worker, uint32_t size, const void* data);
-
-private:
-    uint32_t bufferSize;
-
-    WorkerBase* getWorker (uint32_t workerId) const;
-    juce::Array<WorkerBase*, juce::CriticalSection> workers;
 
-    uint32_t nextWorkId;
-    bool doExit = false;
+    /** Create a pool.
+        @param name         Base name of the threads
+        @param numThreads   Number of threads, at least one is started
+        @param bufsize      Size of each worker's request queue
+        @param priority     Priority of the threads
+     */
+    WorkerPool (const juce::String& name, int numThreads, uint32_t bufsize, Priority priority = Priority::normal);
+    ~WorkerPool();
 
-    std::unique_ptr<RingBuffer> requests; ///< requests to process
+    /** Returns the number of threads in the pool. */
+    int getNumThreads() const noexcept { return threads.size(); }
 
-    /** @internal Validate a ringbuffer for message completeness */
-    bool validateMessage (RingBuffer& ring);
+    /** Returns the space a message of the given size takes in a queue. */
+    inline static uint32_t getRequiredSpace (uint32_t msgSize) { return msgSize + sizeof (uint32_t); }
 
-    /** @internal The work thread function */
-    void run();
-};
-
-/** A flag that indicates whether work is happening or not */
-class WorkFlag
-{
-public:
-    WorkFlag() { flag = 0; }
-    inline bool isWorking() const { return flag.get() != 0; }
+    /** Maximum number of requests handled before a worker goes to the back
+        of the ready queue. */
+    static constexpr int maxBatchSize = 16;
 
 private:
-    juce::Atomic<int32> flag;
-    inline bool setWorking (bool status) { return flag.compareAndSetBool (status ? 1 : 0, status ? 0 : 1); }
-    friend class WorkThread;
+    friend class WorkerBase;
+    class Thread;
+
+    const uint32_t bufferSize;
+    juce::OwnedArray<Thread> threads;
+
+    // bounded multi-producer multi-consumer queue of ready workers.
+    // A worker is queued at most once, so it can't overflow while there
+    // are fewer workers than slots.
+    struct Slot
+    {
+        std::atomic<size_t> sequence { 0 };
+        WorkerBase* worker { nullptr };
+    };
+    static constexpr size_t queueSize = 4096;
+    std::unique_ptr<Slot[]> slots;
+    alignas (64) std::atomic<size_t> head { 0 };
+    alignas (64) std::atomic<size_t> tail { 0 };
+    std::atomic<int> numWorkers { 0 };
+
+    bool push (WorkerBase* worker) noexcept;
+    WorkerBase* pop() noexcept;
+
+    /** Queue a worker with pending requests and wake an idle thread. */
+    void schedule (WorkerBase& worker) noexcept;
+
+    /** Handle a batch of requests. Returns true if more are pending. */
+    bool process (WorkerBase& worker, juce::HeapBlock<uint8_t>& buffer);
 };
 
 class WorkerBase
 {
 public:
     /** Create a new Worker
-        @param thread The WorkThread to use when scheduling
+        @param pool The WorkerPool to use when scheduling
         @param bufsize Size to use for internal response buffers */
-    WorkerBase (WorkThread& thread, uint32_t bufsize);
+    WorkerBase (WorkerPool& pool, uint32_t bufsize);
     virtual ~WorkerBase();
 
     /** Returns true if the worker is currently working */
-    inline bool isWorking() const { return flag.isWorking(); }
+    inline bool isWorking() const { return running.load() > 0; }
 
     /** Schedule work (realtime thread).
-        Work will be scheduled, and the thread will call Worker::processRequest
-        when the data is queued */
+        Work will be scheduled, and the pool will call Worker::processRequest
+        when a thread picks it up */
     bool scheduleWork (uint32_t size, const void* data);
 
     /** Respond from work (worker thread). Call this during processRequest if you
@@ -106,17 +115,22 @@ protected:
     /** Process work responses (realtime thread) */
     virtual void processResponse (uint32_t size, const void* data) = 0;
 
-private:
-    WorkThread& owner;
-    uint32_t workId; ///< The thread assigned id for this worker
-    WorkFlag flag; ///< A flag for when work is being processed
+    /** Stop handling requests and wait for the pool to let go of this worker.
+        Subclasses should call this first thing in their destructor. */
+    void stopWork();
 
-    std::unique_ptr<RingBuffer> responses; ///< responses from work
-    juce::HeapBlock<uint8_t> response; ///< buffer to write a response
+private:
+    WorkerPool& owner;
+    RingBuffer requests; ///< requests to process
+    RingBuffer responses; ///< responses from work
+    juce::HeapBlock<uint8_t> response; ///< buffer to read a response
+    uint32_t responseSize = 0;
 
-    bool validateMessage (RingBuffer& ring);
+    std::atomic<bool> active { true }; ///< false once stopped
+    std::atomic<bool> scheduled { false }; ///< true while queued or being handled
+    std::atomic<int> running { 0 }; ///< number of threads handling requests
 
-    friend class WorkThread;
+    friend class WorkerPool;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WorkerBase)
 };
 
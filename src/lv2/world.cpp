@@ -11,6 +11,7 @@
 #include <lvtk/ext/bufsize.hpp>
 #include <lvtk/ext/state.hpp>
 
+#include "lv2/dispatcher.hpp"
 #include "lv2/lv2features.hpp"
 #include "lv2/module.hpp"
 #include "lv2/workerfeature.hpp"
@@ -18,7 +19,7 @@
 #include "lv2/logfeature.hpp"
 
 #ifndef EL_LV2_NUM_WORKERS
-#define EL_LV2_NUM_WORKERS 1
+#define EL_LV2_NUM_WORKERS 0 // use the number of cores
 #endif
 
 namespace element {
@@ -165,12 +166,10 @@ World::World (SymbolMap& s, const juce::FileSearchPath& lv2Path)
                           LV2ModuleUI::portUnsubscribe);
     suil_host_set_touch_func (suil, LV2ModuleUI::touch);
 
-    currentThread = 0;
-    numThreads = EL_LV2_NUM_WORKERS;
-    for (int i = 0; i < numThreads; ++i)
-    {
-        threads.add (new WorkThread ("lv2_worker_" + String (i + 1), EL_LV2_RING_BUFFER_SIZE));
-    }
+    const int numThreads = EL_LV2_NUM_WORKERS > 0 ? EL_LV2_NUM_WORKERS
+                                                  : jlimit (1, 4, SystemStats::getNumCpus() / 2);
+    workers = std::make_unique<WorkerPool> ("lv2_worker", numThreads, EL_LV2_RING_BUFFER_SIZE);
+    notifications = std::make_unique<NotificationDispatcher>();
 
     addFeature (new GenericFeature (*symbolMap.mapFeature()), false);
     addFeature (new GenericFeature (*symbolMap.unmapFeature()), false);
@@ -297,18 +296,19 @@ const LilvPlugins* World::getAllPlugins() const
     return lilv_world_get_all_plugins (world);
 }
 
-WorkThread& World::getWorkThread()
+WorkerPool& World::getWorkerPool()
 {
-    while (threads.size() < numThreads)
-    {
-        threads.add (new WorkThread ("LV2 Worker " + String (threads.size()), EL_LV2_RING_BUFFER_SIZE));
-    }
+    return *workers;
+}
 
-    const int threadIndex = currentThread;
-    if (++currentThread >= numThreads)
-        currentThread = 0;
+NotificationDispatcher& World::getNotificationDispatcher()
+{
+    return *notifications;
+}
 
-    return *threads.getUnchecked (threadIndex);
+int32 World::getNumWorkThreads() const
+{
+    return workers->getNumThreads();
 }
 
 bool World::isFeatureSupported (const String& featureURI) const
@@ -18,7 +18,8 @@
 namespace element {
 
 class LV2Module;
-class WorkThread;
+class NotificationDispatcher;
+class WorkerPool;
 
 /** Slim wrapper around LilvWorld.  Publishes commonly used LilvNodes and
     manages heavy weight features (like LV2 Worker)
@@ -105,11 +106,14 @@ public:
         to a plugin instance */
     inline void getFeatures (Array<const LV2_Feature*>& feats) const { features.getFeatures (feats); }
 
-    /** Get a worker thread */
-    WorkThread& getWorkThread();
+    /** Get the pool running plugin workers */
+    WorkerPool& getWorkerPool();
+
+    /** Get the dispatcher delivering plugin notifications to UIs */
+    NotificationDispatcher& getNotificationDispatcher();
 
     /** Returns the total number of available worker threads */
-    inline int32 getNumWorkThreads() const { return numThreads; }
+    int32 getNumWorkThreads() const;
 
     /** Returns a plugin's name by URI, or empty if not found */
     String getPluginName (const String& uri) const;
@@ -137,15 +141,19 @@ public:
 
     SymbolMap& symbols() noexcept { return symbolMap; }
 
+    /** Lilv isn't thread safe. Hold this when using the world off the
+        message thread. */
+    CriticalSection& getLock() const noexcept { return lock; }
+
 private:
     LilvWorld* world = nullptr;
+    mutable CriticalSection lock;
     SuilHost* suil = nullptr;
     SymbolMap& symbolMap;
     LV2FeatureArray features;
 
-    // a simple rotating thread pool
-    int currentThread, numThreads;
-    OwnedArray<WorkThread> threads;
+    std::unique_ptr<WorkerPool> workers;
+    std::unique_ptr<NotificationDispatcher> notifications;
 };
 
 } // namespace element
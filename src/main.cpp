@@ -6,6 +6,7 @@
 #include <element/version.hpp>
 #include <element/context.hpp>
 #include <element/devices.hpp>
+#include <element/engine.hpp>
 #include <element/plugins.hpp>
 #include <element/settings.hpp>
 #include <element/ui.hpp>
@@ -240,6 +241,15 @@ public:
         if (maybeLaunchScannerWorker (commandLine))
             return;
 
+        if (ArgumentList (getApplicationName(), commandLine).containsOption ("--render"))
+        {
+            initializeModulePath();
+            setApplicationReturnValue (renderFromCommandLine (commandLine));
+            world = nullptr;
+            quit();
+            return;
+        }
+
         if (sendCommandLineToPreexistingInstance())
         {
             quit();
@@ -422,6 +432,120 @@ private:
         return false;
     }
 
+    /** Bounce a session to a file without an audio device. Returns the exit code. */
+    int renderFromCommandLine (const String& commandLine)
+    {
+        const ArgumentList args (getApplicationName(), commandLine);
+        const auto fileFor = [&args] (const String& option) -> File {
+            const auto path = args.getValueForOption (option).unquoted();
+            return path.isEmpty() ? File() : File::getCurrentWorkingDirectory().getChildFile (path);
+        };
+
+        const auto sessionFile = fileFor ("--render");
+        AudioEngine::OfflineRender options;
+        options.output = fileFor ("--output");
+        options.midiInput = fileFor ("--midi");
+        options.stems = args.containsOption ("--stems");
+        if (args.containsOption ("--rate"))
+            options.sampleRate = args.getValueForOption ("--rate").getDoubleValue();
+        if (args.containsOption ("--block"))
+            options.blockSize = args.getValueForOption ("--block").getIntValue();
+        if (args.containsOption ("--channels"))
+            options.numChannels = args.getValueForOption ("--channels").getIntValue();
+        if (args.containsOption ("--bits"))
+            options.bitDepth = args.getValueForOption ("--bits").getIntValue();
+        if (args.containsOption ("--length"))
+            options.lengthSeconds = args.getValueForOption ("--length").getDoubleValue();
+        if (args.containsOption ("--tail"))
+            options.tailSeconds = args.getValueForOption ("--tail").getDoubleValue();
+        double loadTimeout = 60.0;
+        if (args.containsOption ("--timeout"))
+            loadTimeout = args.getValueForOption ("--timeout").getDoubleValue();
+
+        if (! sessionFile.existsAsFile() || options.output == File())
+        {
+            std::cerr << "usage: element --render=<session.els> --output=<file.wav|file.flac>\n"
+                      << "         [--midi=<file.mid>] [--length=<seconds>] [--tail=<seconds>]\n"
+                      << "         [--rate=48000] [--block=512] [--channels=2] [--bits=24] [--stems]\n"
+                      << "         [--timeout=<seconds>]\n";
+            return 1;
+        }
+
+        auto& settings (world->settings());
+        auto& plugins (world->plugins());
+        plugins.restoreUserPlugins (settings);
+        plugins.scanInternalPlugins();
+
+        auto engine (world->audio());
+        engine->applySettings (settings);
+
+        String error;
+        auto session (world->session());
+        auto data = Session::readFromFile (sessionFile);
+        if (! data.isValid())
+            if (auto xml = XmlDocument::parse (sessionFile))
+                data = ValueTree::fromXml (*xml);
+        if (data.isValid() && (int) data.getProperty (tags::version, -1) != EL_SESSION_VERSION)
+            data = Session::migrate (data, error);
+        if (error.isEmpty() && ! (data.isValid() && data.hasType (types::Session) && session->loadData (data)))
+            error = "Not a valid session file";
+
+        if (error.isNotEmpty())
+        {
+            std::cerr << "[element] " << error << ": " << sessionFile.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        // only the engine is needed, the rest of the services stay off.
+        auto* const graphs = world->services().find<EngineService>();
+        bool graphsLoaded = false;
+        SignalConnection loadedConnection = graphs->sigGraphsLoaded.connect ([&graphsLoaded]() {
+            graphsLoaded = true;
+        });
+        graphs->activate();
+
+        // nodes load asynchronously, run the message loop until they're in.
+        const auto loadStartMs = Time::getMillisecondCounterHiRes();
+        while (! graphsLoaded && Time::getMillisecondCounterHiRes() - loadStartMs < loadTimeout * 1000.0)
+            MessageManager::getInstance()->runDispatchLoopUntil (20);
+        loadedConnection.disconnect();
+
+        if (! graphsLoaded)
+        {
+            std::cerr << "[element] timed out after " << String (loadTimeout, 1)
+                      << " seconds waiting for the session's nodes to load" << std::endl;
+            graphs->deactivate();
+            session->clear();
+            return 1;
+        }
+
+        int lastPercent = -1;
+        options.progress = [&lastPercent] (double progress) {
+            const int percent = roundToInt (progress * 100.0);
+            if (percent / 10 != lastPercent / 10)
+                std::clog << "[element] rendering: " << percent << "%" << std::endl;
+            lastPercent = percent;
+            return true;
+        };
+
+        const auto startMs = Time::getMillisecondCounterHiRes();
+        const auto result = engine->renderOffline (options);
+        const auto elapsed = (Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+
+        graphs->deactivate();
+        session->clear();
+
+        if (result.failed())
+        {
+            std::cerr << "[element] render failed: " << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        std::clog << "[element] rendered " << options.output.getFullPathName()
+                  << " in " << String (elapsed, 2) << " seconds" << std::endl;
+        return 0;
+    }
+
     void launchApplication()
     {
         if (startup != nullptr)
@@ -8,6 +8,7 @@
 
 #include "engine/graphmanager.hpp"
 #include "scopedflag.hpp"
+#include "sessionarchive.hpp"
 
 namespace element {
 
@@ -347,6 +348,30 @@ ValueTree Node::parse (const File& file)
 }
 
 void Node::sanitizeProperties (ValueTree node, const bool recursive)
+{
+    sanitizeRuntimeProperties (node);
+
+    if (node.hasType (types::Node))
+    {
+        // state nobody restored is still compressed from the archive.
+        for (const auto& property : { tags::state, tags::programState })
+        {
+            if (SessionArchive::LazyState::fromVar (node.getProperty (property)) == nullptr)
+                continue;
+            MemoryBlock block;
+            if (decodeState (node.getProperty (property), block))
+                node.setProperty (property, var (block), nullptr);
+            else
+                node.removeProperty (property, nullptr);
+        }
+    }
+
+    if (recursive)
+        for (int i = 0; i < node.getNumChildren(); ++i)
+            sanitizeProperties (node.getChild (i), recursive);
+}
+
+void Node::sanitizeRuntimeProperties (ValueTree node, const bool recursive)
 {
     node.removeProperty (tags::updater, nullptr);
     node.removeProperty (tags::object, nullptr);
@@ -362,12 +387,7 @@ void Node::sanitizeProperties (ValueTree node, const bool recursive)
 
     if (recursive)
         for (int i = 0; i < node.getNumChildren(); ++i)
-            sanitizeProperties (node.getChild (i), recursive);
-}
-
-void Node::sanitizeRuntimeProperties (ValueTree node, const bool recursive)
-{
-    Node::sanitizeProperties (node, recursive);
+            sanitizeRuntimeProperties (node.getChild (i), recursive);
 }
 
 bool Node::writeToFile (const File& targetFile) const
@@ -821,56 +841,55 @@ MidiChannels Node::getMidiChannels() const
     return chans;
 }
 
-void Node::restorePluginState()
+bool Node::decodeState (const var& property, MemoryBlock& block)
+{
+    block.reset();
+    if (auto* data = property.getBinaryData())
+        block = *data;
+    else if (auto* lazy = SessionArchive::LazyState::fromVar (property))
+        lazy->decode (block);
+    else if (property.isString())
+        block.fromBase64Encoding (property.toString().trim());
+    return block.getSize() > 0;
+}
+
+void Node::restorePluginState (bool withStateData)
 {
     if (! isValid())
         return;
 
     if (ProcessorPtr obj = getObject())
     {
-        if (auto* const proc = obj->getAudioProcessor())
+        if (withStateData)
         {
-            const int wantedProgram = objectData.getProperty (tags::program, -1);
-            const bool shouldSetProgram = proc->getNumPrograms() > 0 && isPositiveAndBelow (wantedProgram, proc->getNumPrograms());
-            if (shouldSetProgram)
-                proc->setCurrentProgram (wantedProgram);
-
-            auto data = getProperty (tags::state).toString().trim();
-            if (data.isNotEmpty())
+            if (auto* const proc = obj->getAudioProcessor())
             {
+                const int wantedProgram = objectData.getProperty (tags::program, -1);
+                const bool shouldSetProgram = proc->getNumPrograms() > 0 && isPositiveAndBelow (wantedProgram, proc->getNumPrograms());
+                if (shouldSetProgram)
+                    proc->setCurrentProgram (wantedProgram);
+
                 MemoryBlock state;
-                state.fromBase64Encoding (data);
-                if (state.getSize() > 0)
+                if (decodeState (getProperty (tags::state), state))
                 {
                     proc->setStateInformation (state.getData(), (int) state.getSize());
                 }
-            }
 
-            data = getProperty (tags::programState).toString().trim();
-            if (shouldSetProgram && data.isNotEmpty())
-            {
-                MemoryBlock state;
-                state.fromBase64Encoding (data);
-                if (state.getSize() > 0)
+                if (shouldSetProgram && decodeState (getProperty (tags::programState), state))
                 {
                     proc->setCurrentProgramStateInformation (state.getData(),
                                                              (int) state.getSize());
                 }
             }
-        }
-        else
-        {
-            const int wantedProgram = objectData.getProperty (tags::program, -1);
-            const bool shouldSetProgram = obj->getNumPrograms() > 0 && isPositiveAndBelow (wantedProgram, obj->getNumPrograms());
-            if (shouldSetProgram)
-                obj->setCurrentProgram (wantedProgram);
-
-            auto data = getProperty (tags::state).toString().trim();
-            if (data.isNotEmpty())
+            else
             {
+                const int wantedProgram = objectData.getProperty (tags::program, -1);
+                const bool shouldSetProgram = obj->getNumPrograms() > 0 && isPositiveAndBelow (wantedProgram, obj->getNumPrograms());
+                if (shouldSetProgram)
+                    obj->setCurrentProgram (wantedProgram);
+
                 MemoryBlock state;
-                state.fromBase64Encoding (data);
-                if (state.getSize() > 0)
+                if (decodeState (getProperty (tags::state), state))
                     obj->setState (state.getData(), (int) state.getSize());
             }
         }
@@ -916,6 +935,7 @@ void Node::restorePluginState()
 
         obj->setMuted ((bool) getProperty (tags::mute, obj->isMuted()));
         obj->setMuteInput ((bool) getProperty ("muteInput", obj->isMutingInputs()));
+        obj->setSleepOnSilence ((bool) getProperty (tags::sleepOnSilence, obj->sleepsOnSilence()));
 
         if (hasProperty (tags::transpose))
             obj->setTransposeOffset (getProperty (tags::transpose));
@@ -935,7 +955,7 @@ void Node::restorePluginState()
         getNode (i).restorePluginState();
 }
 
-void Node::savePluginState()
+void Node::savePluginState (bool recursive)
 {
     if (! isValid())
         return;
@@ -950,7 +970,7 @@ void Node::savePluginState()
             proc->getStateInformation (state);
             if (state.getSize() > 0)
             {
-                objectData.setProperty (tags::state, state.toBase64Encoding(), nullptr);
+                objectData.setProperty (tags::state, var (state), nullptr);
             }
             else
             {
@@ -963,7 +983,7 @@ void Node::savePluginState()
             proc->getCurrentProgramStateInformation (state);
             if (state.getSize() > 0)
             {
-                objectData.setProperty (tags::programState, state.toBase64Encoding(), 0);
+                objectData.setProperty (tags::programState, var (state), 0);
             }
 
             setProperty (tags::bypass, proc->isSuspended());
@@ -999,7 +1019,7 @@ void Node::savePluginState()
         {
             obj->getState (state);
             if (state.getSize() > 0)
-                objectData.setProperty (tags::state, state.toBase64Encoding(), nullptr);
+                objectData.setProperty (tags::state, var (state), nullptr);
         }
 
         setProperty (tags::midiProgram, obj->getMidiProgram());
@@ -1007,6 +1027,7 @@ void Node::savePluginState()
         setProperty (tags::midiProgramsEnabled, obj->areMidiProgramsEnabled());
         setProperty (tags::mute, obj->isMuted());
         setProperty ("muteInput", obj->isMutingInputs());
+        setProperty (tags::sleepOnSilence, obj->sleepsOnSilence());
         String mps;
         obj->getMidiProgramsState (mps);
         setProperty (tags::midiProgramsState, mps);
@@ -1014,8 +1035,9 @@ void Node::savePluginState()
         setProperty (tags::delayCompensation, obj->getDelayCompensation());
     }
 
-    for (int i = 0; i < getNumNodes(); ++i)
-        getNode (i).savePluginState();
+    if (recursive)
+        for (int i = 0; i < getNumNodes(); ++i)
+            getNode (i).savePluginState();
 }
 
 namespace detail {
@@ -1199,6 +1221,21 @@ void Node::setMuteInput (bool shouldMuteInputs)
         obj->setMuteInput (isMutingInputs());
 }
 
+Processor::RenderStats Node::getRenderStats() const
+{
+    if (auto* obj = getObject())
+        return obj->getRenderStats();
+    return {};
+}
+
+void Node::setSleepOnSilence (bool shouldSleep)
+{
+    if (shouldSleep != sleepsOnSilence())
+        setProperty (tags::sleepOnSilence, shouldSleep);
+    if (auto* obj = getObject())
+        obj->setSleepOnSilence (sleepsOnSilence());
+}
+
 void Node::setCurrentProgram (const int index)
 {
     if (auto* obj = getObject())
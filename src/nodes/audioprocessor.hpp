@@ -28,6 +28,13 @@ public:
             p->setPlayHead (playhead);
     }
 
+    void setNonRealtime (bool isNonRealtime) noexcept override
+    {
+        Processor::setNonRealtime (isNonRealtime);
+        if (auto* p = proc.get())
+            p->setNonRealtime (isNonRealtime);
+    }
+
     void getState (MemoryBlock&) override;
     void setState (const void*, int) override;
 
@@ -9,22 +9,63 @@
 
 namespace element {
 
+//==============================================================================
+struct AudioRouterNode::Routing
+{
+    explicit Routing (const MatrixState& matrix)
+        : target (matrix),
+          gains (matrix),
+          steps (matrix.getNumRows(), matrix.getNumColumns())
+    {
+        active.malloc ((size_t) target.size());
+        updateActive();
+    }
+
+    GainMatrix target; ///< where the fade ends
+    GainMatrix gains; ///< current gains
+    GainMatrix steps; ///< change in gain per frame while fading
+    HeapBlock<int> active; ///< indexes of crosspoints with any gain
+    int numActive = 0;
+    int framesLeft = 0; ///< frames left in the fade
+
+    /** Continue from the gains of the previous routing and fade to
+        this one's targets. */
+    void fadeFrom (const Routing& previous, int numFrames) noexcept
+    {
+        gains.copyFrom (previous.gains);
+        const auto* t = target.getData();
+        const auto* g = gains.getData();
+        auto* s = steps.getData();
+        for (int i = 0; i < target.size(); ++i)
+            s[i] = (t[i] - g[i]) / (float) numFrames;
+        framesLeft = numFrames;
+        updateActive();
+    }
+
+    /** Collect the crosspoints that are audible now or will be after the
+        fade. Silent ones aren't visited while rendering. */
+    void updateActive() noexcept
+    {
+        numActive = 0;
+        const auto* t = target.getData();
+        const auto* g = gains.getData();
+        for (int i = 0; i < target.size(); ++i)
+            if (t[i] != 0.0f || g[i] != 0.0f)
+                active[numActive++] = i;
+    }
+};
+
+//==============================================================================
 AudioRouterNode::AudioRouterNode (int ins, int outs)
     : Processor (0),
       numSources (ins),
       numDestinations (outs),
-      state (ins, outs),
-      toggles (ins, outs),
-      nextToggles (ins, outs)
+      state (ins, outs)
 {
     setName ("Audio Router");
 
-    fadeIn.setFadesIn (true);
-    fadeIn.setLength (fadeLengthSeconds);
-    fadeOut.setFadesIn (false);
-    fadeOut.setLength (fadeLengthSeconds);
-
     clearPatches();
+    routing = new Routing (state);
 
     auto* program = programs.add (new Program ("Linear Stereo"));
     program->matrix.resize (ins, outs);
@@ -63,7 +104,18 @@ AudioRouterNode::AudioRouterNode (int ins, int outs)
     }
 }
 
-AudioRouterNode::~AudioRouterNode() {}
+AudioRouterNode::~AudioRouterNode()
+{
+    reclaim();
+    delete pending.exchange (nullptr);
+    delete routing;
+}
+
+void AudioRouterNode::prepareToRender (double newSampleRate, int maxBufferSize)
+{
+    ignoreUnused (maxBufferSize);
+    sampleRate = newSampleRate;
+}
 
 void AudioRouterNode::setCurrentProgram (int index)
 {
@@ -77,16 +129,26 @@ void AudioRouterNode::setCurrentProgram (int index)
 void AudioRouterNode::applyMatrix (const MatrixState& matrix)
 {
     jassert (matrix.sameSizeAs (state));
-    ToggleGrid newPatches (matrix);
-    {
-        ScopedLock sl (getLock());
-        nextToggles.swapWith (newPatches);
-        togglesChanged = true; // initiate the crossfade
-    }
-
+    publish (new Routing (matrix)); // initiate the crossfade
     sendChangeMessage();
 }
 
+void AudioRouterNode::publish (Routing* next)
+{
+    ScopedLock sl (getLock());
+    reclaim();
+    // the renderer never saw a routing that is still pending.
+    delete pending.exchange (next, std::memory_order_acq_rel);
+}
+
+void AudioRouterNode::reclaim()
+{
+    retiredFifo.read (retiredFifo.getNumReady()).forEach ([this] (int index) {
+        delete retired[index];
+        retired[index] = nullptr;
+    });
+}
+
 String AudioRouterNode::getSizeString() const
 {
     int s = 0, d = 0;
@@ -113,18 +175,15 @@ void AudioRouterNode::setSize (int newIns, int newOuts, bool async)
     }
 
     state.resize (newIns, newOuts, true);
-    ToggleGrid newPatches (state);
-    ToggleGrid newNextPatches (state);
 
     {
         ScopedLock sl (getLock());
-        nextToggles.swapWith (newNextPatches);
-        toggles.swapWith (newPatches);
         numSources = newIns;
         numDestinations = newOuts;
-        sizeChanged = true; // initiate the size change
     }
 
+    publish (new Routing (state)); // a new size switches without fading
+
     rebuildPorts = true;
     if (async)
     {
@@ -159,135 +218,67 @@ void AudioRouterNode::render (RenderContext& rc)
     tempAudio.setSize (numChannels, numFrames, false, false, true);
     tempAudio.clear (0, numFrames);
 
-    if (sizeChanged)
+    // a full fifo leaves the new routing pending until the next block.
+    if (retiredFifo.getFreeSpace() > 0)
     {
-        fadeIn.reset();
-        fadeOut.reset();
-        sizeChanged = false;
-        TRACE_AUDIO_ROUTER ("size changed");
-    }
+        if (auto* next = pending.exchange (nullptr, std::memory_order_acq_rel))
+        {
+            if (next->target.sameSizeAs (routing->target))
+            {
+                const auto fadeFrames = jmax (1, roundToInt (fadeLengthSeconds.load() * sampleRate));
+                next->fadeFrom (*routing, fadeFrames);
+                TRACE_AUDIO_ROUTER ("fade start");
+            }
 
-    if (togglesChanged)
-    {
-        fadeIn.reset();
-        fadeIn.startFading();
-        fadeOut.reset();
-        fadeOut.startFading();
-        togglesChanged = false;
-        TRACE_AUDIO_ROUTER ("fade start");
+            retiredFifo.write (1).forEach ([this] (int index) { retired[index] = routing; });
+            routing = next;
+        }
     }
 
-    if (numSources > numChannels || numDestinations > numChannels)
+    auto& r = *routing;
+    const int numOuts = r.target.getNumOutputs();
+    if (r.target.getNumInputs() > numChannels || numOuts > numChannels)
     {
         rc.audio.clear();
         rc.midi.clear();
         return;
     }
 
-    if (fadeIn.isActive() || fadeOut.isActive())
-    {
-        auto framesToProcess = numFrames;
-        int frame = 0;
-        ScopedLock sl (lock);
+    const int rampFrames = jmin (r.framesLeft, numFrames);
+    const bool fadeEnds = rampFrames == r.framesLeft;
+    auto* gains = r.gains.getData();
+    const auto* targets = r.target.getData();
+    const auto* steps = r.steps.getData();
 
-        float fadeInGain = 0.0f;
-        float fadeOutGain = 1.0f;
+    for (int a = 0; a < r.numActive; ++a)
+    {
+        const int k = r.active[a];
+        const float* src = rc.audio.getReadPointer (k / numOuts);
+        float* dst = tempAudio.getWritePointer (k % numOuts);
 
-        while (--framesToProcess >= 0)
+        int frame = 0;
+        if (rampFrames > 0 && steps[k] != 0.0f)
         {
-            fadeInGain = fadeIn.isActive() ? fadeIn.getNextEnvelopeValue() : 1.0f;
-            fadeOutGain = fadeOut.isActive() ? fadeOut.getNextEnvelopeValue() : 0.0f;
-
-            if (! fadeIn.isActive() && ! fadeOut.isActive())
-            {
-                TRACE_AUDIO_ROUTER ("last frame fade in gain  : " << fadeInGain);
-                TRACE_AUDIO_ROUTER ("last frame fade out gain : " << fadeOutGain);
-            }
-
-            for (int i = 0; i < numSources; ++i)
-            {
-                for (int j = 0; j < numDestinations; ++j)
-                {
-                    if (toggles.get (i, j) && nextToggles.get (i, j))
-                    {
-                        // no patch change and on means 1 to 1 mix
-                        tempAudio.getWritePointer (j)[frame] +=
-                            rc.audio.getReadPointer (i)[frame];
-                    }
-                    else if (! toggles.get (i, j) && ! nextToggles.get (i, j))
-                    {
-                        // no patch change and off means no fade and zero'd
-                        tempAudio.getWritePointer (j)[frame] += 0.0f;
-                    }
-                    else if (! toggles.get (i, j) && nextToggles.get (i, j))
-                    {
-                        tempAudio.getWritePointer (j)[frame] +=
-                            (rc.audio.getReadPointer (i)[frame] * fadeInGain);
-                    }
-                    else if (toggles.get (i, j) && ! nextToggles.get (i, j))
-                    {
-                        tempAudio.getWritePointer (j)[frame] +=
-                            (rc.audio.getReadPointer (i)[frame] * fadeOutGain);
-                    }
-                }
-            }
-
-            ++frame;
-
-            if (! fadeIn.isActive() && ! fadeOut.isActive())
-                break;
+            GainMatrix::addWithRamp (dst, src, rampFrames, gains[k], steps[k]);
+            gains[k] += steps[k] * (float) rampFrames;
+            frame = rampFrames;
         }
 
-        if (! fadeOut.isActive() && ! fadeIn.isActive())
-        {
-            TRACE_AUDIO_ROUTER ("fade stopped @ frame: " << (frame));
-            TRACE_AUDIO_ROUTER ("fade in level  : " << fadeInGain);
-            TRACE_AUDIO_ROUTER ("fade out level : " << fadeOutGain);
-
-            if (framesToProcess > 0)
-            {
-                TRACE_AUDIO_ROUTER ("rendering " << framesToProcess << " remainging frames");
-                for (int i = 0; i < numSources; ++i)
-                {
-                    for (int j = 0; j < numDestinations; ++j)
-                    {
-                        if (toggles.get (i, j) && nextToggles.get (i, j))
-                        {
-                            // no patch change and on means 1 to 1 mix
-                            tempAudio.addFrom (j, frame, rc.audio.getReadPointer (i, frame), framesToProcess);
-                        }
-                        else if (! toggles.get (i, j) && ! nextToggles.get (i, j))
-                        {
-                            // patch not changed and of, so clear the out channel.
-                            // nothing to do
-                        }
-                        else if (! toggles.get (i, j) && nextToggles.get (i, j))
-                        {
-                            tempAudio.addFromWithRamp (j, frame, rc.audio.getReadPointer (i, frame), framesToProcess, fadeInGain, 1.0f);
-                        }
-                        else if (toggles.get (i, j) && ! nextToggles.get (i, j))
-                        {
-                            tempAudio.addFromWithRamp (j, frame, rc.audio.getReadPointer (i, frame), framesToProcess, fadeOutGain, 0.0f);
-                        }
-                        else
-                        {
-                            // this would be an unhandled fading scenario
-                            jassertfalse;
-                        }
-                    }
-                }
-            }
+        if (fadeEnds)
+            gains[k] = targets[k];
 
-            toggles.swapWith (nextToggles);
-        }
+        GainMatrix::addWithGain (dst + frame, src + frame, numFrames - frame, gains[k]);
     }
-    else
+
+    if (r.framesLeft > 0)
     {
-        ScopedLock sl (lock);
-        for (int i = 0; i < numSources; ++i)
-            for (int j = 0; j < numDestinations; ++j)
-                if (toggles.get (i, j))
-                    tempAudio.addFrom (j, 0, rc.audio, i, 0, numFrames);
+        r.framesLeft -= rampFrames;
+        if (r.framesLeft == 0)
+        {
+            // drop crosspoints that faded out.
+            r.updateActive();
+            TRACE_AUDIO_ROUTER ("fade stopped");
+        }
     }
 
     for (int c = 0; c < numChannels; ++c)
@@ -314,17 +305,14 @@ void AudioRouterNode::setState (const void* data, int sizeInBytes)
         {
             state = matrix;
 
-            ToggleGrid newPatches (state);
-            ToggleGrid newNextPatches (state);
             {
                 ScopedLock sl (getLock());
                 numSources = matrix.getNumRows();
                 numDestinations = matrix.getNumColumns();
-                nextToggles.swapWith (newNextPatches);
-                toggles.swapWith (newPatches);
-                sizeChanged = true;
             }
 
+            publish (new Routing (state));
+
             rebuildPorts = true;
             sendChangeMessage();
             triggerPortReset();
@@ -332,28 +320,8 @@ void AudioRouterNode::setState (const void* data, int sizeInBytes)
     }
 }
 
-void AudioRouterNode::setWithoutLocking (int src, int dst, bool set)
-{
-    jassert (src >= 0 && src < numSources && dst >= 0 && dst < numDestinations);
-    toggles.set (src, dst, set);
-    state.set (src, dst, set);
-}
-
-void AudioRouterNode::set (int src, int dst, bool patched)
-{
-    jassert (src >= 0 && src < numSources && dst >= 0 && numDestinations < 4);
-    toggles.set (src, dst, patched);
-    state.set (src, dst, patched);
-}
-
 void AudioRouterNode::clearPatches()
 {
-    {
-        ScopedLock sl (getLock());
-        toggles.clear();
-        nextToggles.clear();
-    }
-
     for (int r = 0; r < state.getNumRows(); ++r)
         for (int c = 0; c < state.getNumColumns(); ++c)
             state.set (r, c, false);
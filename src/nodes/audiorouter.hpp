@@ -5,8 +5,7 @@
 
 #include <element/node.h>
 #include <element/processor.hpp>
-#include "engine/linearfade.hpp"
-#include "engine/togglegrid.hpp"
+#include "engine/gainmatrix.hpp"
 
 namespace element {
 
@@ -17,7 +16,7 @@ public:
     explicit AudioRouterNode (int ins = 4, int outs = 4);
     ~AudioRouterNode();
 
-    void prepareToRender (double sampleRate, int maxBufferSize) override { ignoreUnused (sampleRate, maxBufferSize); }
+    void prepareToRender (double sampleRate, int maxBufferSize) override;
     void releaseResources() override {}
 
     inline bool wantsContext() const noexcept override { return true; }
@@ -30,7 +29,6 @@ public:
     String getSizeString() const;
     void setMatrixState (const MatrixState&);
     MatrixState getMatrixState() const;
-    void setWithoutLocking (int src, int dst, bool set);
     CriticalSection& getLock() { return lock; }
 
     int getNumPrograms() const override { return jmax (1, programs.size()); }
@@ -45,11 +43,7 @@ public:
 
     void setFadeLength (double seconds)
     {
-        seconds = jlimit (0.001, 5.0, seconds);
-        ScopedLock sl (lock);
-        fadeLengthSeconds = seconds;
-        fadeIn.setLength (static_cast<float> (fadeLengthSeconds));
-        fadeOut.setLength (static_cast<float> (fadeLengthSeconds));
+        fadeLengthSeconds.store (jlimit (0.001, 5.0, seconds));
     }
 
     void getPluginDescription (PluginDescription& desc) const override
@@ -112,21 +106,25 @@ private:
     OwnedArray<Program> programs;
     int currentProgram = -1;
 
-    void set (int src, int dst, bool patched);
     void clearPatches();
 
     // used by the UI, but not the rendering
     MatrixState state;
 
-    double fadeLengthSeconds { 0.001 }; // 1 ms
-    LinearFade fadeIn;
-    LinearFade fadeOut;
-    ToggleGrid toggles;
-    ToggleGrid nextToggles;
-    bool togglesChanged { false },
-        sizeChanged { false };
+    std::atomic<double> fadeLengthSeconds { 0.001 }; // 1 ms
+    double sampleRate { 44100.0 };
+
+    /** Gains the renderer is fading towards, and where it is now. */
+    struct Routing;
+    Routing* routing { nullptr }; ///< owned by the renderer
+    std::atomic<Routing*> pending { nullptr }; ///< waiting to be picked up
+    static constexpr int maxRetired = 16;
+    AbstractFifo retiredFifo { maxRetired };
+    Routing* retired[maxRetired] {}; ///< replaced routings to delete off the audio thread
 
     void applyMatrix (const MatrixState&);
+    void publish (Routing* next);
+    void reclaim();
 };
 
 } // namespace element
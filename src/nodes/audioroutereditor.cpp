@@ -84,8 +84,10 @@ public:
             menu.addItem (4, "4x4", true, false);
             menu.addItem (8, "8x8", true, false);
             menu.addItem (10, "10x10", true, false);
-            menu.addItem (10, "12x12", true, false);
+            menu.addItem (12, "12x12", true, false);
             menu.addItem (16, "16x16", true, false);
+            menu.addItem (32, "32x32", true, false);
+            menu.addItem (64, "64x64", true, false);
             menu.showMenuAsync (PopupMenu::Options()
                                     .withTargetComponent (this),
                                 ModalCallbackFunction::create (sizeChosen, WeakReference<AudioRouterSizeButton> (this)));
@@ -2,6 +2,8 @@
 // Author: Jatin Chowdhury (jatin@ccrma.stanford.edu)
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <cstring>
+
 #include "nodes/compressor.hpp"
 #include "nodes/compressoreditor.hpp"
 
@@ -33,8 +35,17 @@ CompressorProcessor::CompressorProcessor (const int _numChannels)
     addLegacyParameter (releaseMs = new AudioParameterFloat ("release", "Release [ms]", releaseRange, 100.0f));
     addLegacyParameter (makeupDB = new AudioParameterFloat ("makeup", "Makeup [dB]", -18.0f, 18.0f, 0.0f));
     addLegacyParameter (sideChain = new AudioParameterFloat ("sidechain", "Side Chain", 0.0f, 1.0f, 0.0f));
+    addLegacyParameter (lookaheadMs = new AudioParameterFloat ("lookahead", "Lookahead [ms]", 0.0f, 10.0f, 0.0f));
+    addLegacyParameter (stereoLink = new AudioParameterChoice ("link", "Stereo Link", { "Average", "Maximum", "Off" }, linkAverage));
 
     makeupGain.reset (numSteps);
+    lookaheadMs->addListener (this);
+}
+
+CompressorProcessor::~CompressorProcessor()
+{
+    lookaheadMs->removeListener (this);
+    cancelPendingUpdate();
 }
 
 void CompressorProcessor::fillInPluginDescription (PluginDescription& desc) const
@@ -54,11 +65,14 @@ void CompressorProcessor::fillInPluginDescription (PluginDescription& desc) cons
 
 void CompressorProcessor::updateParams()
 {
-    detector.setAttackMs (*attackMs);
-    detector.setReleaseMs (*releaseMs);
+    for (int i = 0; i < 2; ++i)
+    {
+        detectors[i].setAttackMs (*attackMs);
+        detectors[i].setReleaseMs (*releaseMs);
 
-    sideDetector.setAttackMs (*attackMs);
-    sideDetector.setReleaseMs (*releaseMs);
+        sideDetectors[i].setAttackMs (*attackMs);
+        sideDetectors[i].setReleaseMs (*releaseMs);
+    }
 
     gainComputer.setThreshold (*threshDB);
     gainComputer.setRatio (*ratio);
@@ -67,14 +81,53 @@ void CompressorProcessor::updateParams()
     makeupGain.setTargetValue (Decibels::decibelsToGain ((float) *makeupDB));
 }
 
+void CompressorProcessor::updateLookahead()
+{
+    const auto samples = jlimit (0, maxLookahead, roundToInt (*lookaheadMs * 0.001 * getSampleRate()));
+    lookaheadTarget.store (samples);
+    if (getLatencySamples() != samples)
+        setLatencySamples (samples);
+}
+
+void CompressorProcessor::parameterValueChanged (int parameterIndex, float newValue)
+{
+    ignoreUnused (newValue);
+    // automation can come from any thread, latency changes go through the
+    // message thread.
+    if (parameterIndex == lookaheadMs->getParameterIndex())
+        triggerAsyncUpdate();
+}
+
+void CompressorProcessor::parameterGestureChanged (int parameterIndex, bool gestureIsStarting)
+{
+    ignoreUnused (parameterIndex, gestureIsStarting);
+}
+
+void CompressorProcessor::handleAsyncUpdate()
+{
+    updateLookahead();
+}
+
 void CompressorProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
 {
-    detector.reset ((float) sampleRate);
-    sideDetector.reset ((float) sampleRate);
+    for (int i = 0; i < 2; ++i)
+    {
+        detectors[i].reset ((float) sampleRate);
+        sideDetectors[i].reset ((float) sampleRate);
+    }
     gainComputer.reset();
 
+    const int blockSize = jmax (1, maximumExpectedSamplesPerBlock);
+    maxLookahead = (int) std::ceil (lookaheadMs->range.end * 0.001 * sampleRate);
+    levels.setSize (2, blockSize);
+    sideLevels.setSize (2, blockSize);
+    delayLine.setSize (2, maxLookahead + blockSize);
+    delayLine.clear();
+    lookahead = 0;
+
     setBusesLayout (getBusesLayout());
     setRateAndBufferSizeDetails (sampleRate, maximumExpectedSamplesPerBlock);
+    updateLookahead();
 }
 
 void CompressorProcessor::releaseResources() {}
@@ -84,29 +137,120 @@ void CompressorProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer&)
     auto mainBuffer = getBusBuffer (buffer, true, 0);
     auto sideBuffer = getBusBuffer (buffer, true, 1);
 
-    auto numBuffChannels = mainBuffer.getNumChannels();
-
     updateParams();
 
-    float level = 0.0f;
-    for (int n = 0; n < buffer.getNumSamples(); ++n)
+    // hosts may send more than they said they would.
+    const int chunkSize = levels.getNumSamples();
+    if (chunkSize <= 0)
+    {
+        jassertfalse; // not prepared
+        return;
+    }
+
+    for (int start = 0; start < buffer.getNumSamples(); start += chunkSize)
+        processChunk (mainBuffer, sideBuffer, start, jmin (chunkSize, buffer.getNumSamples() - start));
+}
+
+void CompressorProcessor::computeKey (AudioBuffer<float>& input, int channel, bool linked, float* dest, int start, int numSamples) const noexcept
+{
+    const int numChans = input.getNumChannels();
+    if (! linked || numChans == 1)
+    {
+        FloatVectorOperations::copy (dest, input.getReadPointer (channel, start), numSamples);
+        return;
+    }
+
+    if (stereoLink->getIndex() == linkMaximum)
     {
-        // Get Main mono input
-        float mainInput = getSummedMonoSample (mainBuffer, n, numBuffChannels);
+        FloatVectorOperations::abs (dest, input.getReadPointer (0, start), numSamples);
+        for (int ch = 1; ch < numChans; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                dest[i] = jmax (dest[i], std::abs (input.getReadPointer (ch, start)[i]));
+        return;
+    }
+
+    FloatVectorOperations::copy (dest, input.getReadPointer (0, start), numSamples);
+    for (int ch = 1; ch < numChans; ++ch)
+        FloatVectorOperations::add (dest, input.getReadPointer (ch, start), numSamples);
+    FloatVectorOperations::multiply (dest, 1.0f / (float) numChans, numSamples);
+}
 
-        // Get sidechain mono input
-        float sideInput = getSummedMonoSample (sideBuffer, n, numBuffChannels);
+void CompressorProcessor::delayMain (AudioBuffer<float>& main, int start, int numSamples) noexcept
+{
+    const int target = lookaheadTarget.load();
+    if (target != lookahead)
+    {
+        lookahead = target;
+        delayLine.clear();
+    }
 
-        // Get level estimate, and compute gain
-        level = detector.process (mainInput) * (1.0f - *sideChain)
-                + sideDetector.process (sideInput) * *sideChain;
-        float gain = gainComputer.process (level);
+    if (lookahead <= 0)
+        return;
 
-        // Apply gain
-        mainBuffer.applyGain (n, 1, gain * makeupGain.getNextValue());
+    for (int ch = 0; ch < main.getNumChannels(); ++ch)
+    {
+        auto* const work = delayLine.getWritePointer (ch);
+        auto* const data = main.getWritePointer (ch, start);
+        FloatVectorOperations::copy (work + lookahead, data, numSamples);
+        FloatVectorOperations::copy (data, work, numSamples);
+        std::memmove (work, work + numSamples, sizeof (float) * (size_t) lookahead);
     }
+}
+
+void CompressorProcessor::processChunk (AudioBuffer<float>& main, AudioBuffer<float>& side, int start, int numSamples)
+{
+    const int numChans = main.getNumChannels();
+    const bool linked = stereoLink->getIndex() != linkOff || numChans == 1;
+    const int numDetectors = linked ? 1 : numChans;
+    const float sideAmount = *sideChain;
+
+    float lastLevel = 0.0f;
+    for (int d = 0; d < numDetectors; ++d)
+    {
+        auto* const level = levels.getWritePointer (d);
+        computeKey (main, d, linked, level, start, numSamples);
+        detectors[d].process (level, numSamples);
+
+        if (sideAmount > 0.0f)
+        {
+            auto* const sideLevel = sideLevels.getWritePointer (d);
+            computeKey (side, d, linked, sideLevel, start, numSamples);
+            sideDetectors[d].process (sideLevel, numSamples);
+            FloatVectorOperations::multiply (level, 1.0f - sideAmount, numSamples);
+            FloatVectorOperations::addWithMultiply (level, sideLevel, sideAmount, numSamples);
+        }
+
+        lastLevel = jmax (lastLevel, level[numSamples - 1]);
+    }
+
+    auto* const* gains = levels.getArrayOfWritePointers();
+    gainComputer.process (gains, numDetectors, numSamples);
+
+    float minGain = 1.0f;
+    for (int d = 0; d < numDetectors; ++d)
+        minGain = jmin (minGain, FloatVectorOperations::findMinimum (gains[d], numSamples));
+
+    if (makeupGain.isSmoothing())
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto makeup = makeupGain.getNextValue();
+            for (int d = 0; d < numDetectors; ++d)
+                gains[d][i] *= makeup;
+        }
+    }
+    else
+    {
+        for (int d = 0; d < numDetectors; ++d)
+            FloatVectorOperations::multiply (gains[d], makeupGain.getCurrentValue(), numSamples);
+    }
+
+    delayMain (main, start, numSamples);
+    for (int ch = 0; ch < numChans; ++ch)
+        FloatVectorOperations::multiply (main.getWritePointer (ch, start), gains[linked ? 0 : ch], numSamples);
 
-    listeners.call (&Listener::updateInGainDB, Decibels::gainToDecibels (level));
+    inputLevelDB.store (Decibels::gainToDecibels (lastLevel), std::memory_order_relaxed);
+    gainReductionDB.store (Decibels::gainToDecibels (minGain), std::memory_order_relaxed);
 }
 
 float CompressorProcessor::calcGainDB (float db)
@@ -128,6 +272,8 @@ void CompressorProcessor::getStateInformation (juce::MemoryBlock& destData)
     state.setProperty ("release", (float) *releaseMs, 0);
     state.setProperty ("makeup", (float) *makeupDB, 0);
     state.setProperty ("sidechain", (float) *sideChain, 0);
+    state.setProperty ("lookahead", (float) *lookaheadMs, 0);
+    state.setProperty ("link", stereoLink->getIndex(), 0);
     if (auto e = state.createXml())
         AudioProcessor::copyXmlToBinary (*e, destData);
 }
@@ -146,6 +292,8 @@ void CompressorProcessor::setStateInformation (const void* data, int sizeInBytes
             *releaseMs = (float) state.getProperty ("release", (float) *releaseMs);
             *makeupDB = (float) state.getProperty ("makeup", (float) *makeupDB);
             *sideChain = (float) state.getProperty ("sidechain", (float) *sideChain);
+            *lookaheadMs = (float) state.getProperty ("lookahead", (float) *lookaheadMs);
+            *stereoLink = (int) state.getProperty ("link", stereoLink->getIndex());
         }
     }
 }
@@ -59,6 +59,19 @@ public:
         return levelEstimate;
     }
 
+    /* Process a block in place, replacing each sample with the level estimate */
+    void process (float* data, int numSamples) noexcept
+    {
+        auto level = levelEstimate;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto x = std::abs (data[i]);
+            level += (x > level ? b0_a : b0_r) * (x - level);
+            data[i] = level;
+        }
+        levelEstimate = level;
+    }
+
     void setLevelEstimate (float levelEst) { levelEstimate = levelEst; }
     float getLevelEstimate() { return levelEstimate; }
 
@@ -144,6 +157,29 @@ public:
         return calcGain (x, thresh.getNextValue(), ratio.getNextValue());
     }
 
+    /* Replace levels with gains in each channel. The smoothed threshold
+       and ratio advance once per frame, whatever the channel count. */
+    void process (float* const* channels, int numChannels, int numSamples) noexcept
+    {
+        if (! thresh.isSmoothing() && ! ratio.isSmoothing())
+        {
+            const auto curThresh = thresh.getCurrentValue();
+            const auto curRatio = ratio.getCurrentValue();
+            for (int c = 0; c < numChannels; ++c)
+                for (int i = 0; i < numSamples; ++i)
+                    channels[c][i] = calcGain (channels[c][i], curThresh, curRatio);
+            return;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto curThresh = thresh.getNextValue();
+            const auto curRatio = ratio.getNextValue();
+            for (int c = 0; c < numChannels; ++c)
+                channels[c][i] = calcGain (channels[c][i], curThresh, curRatio);
+        }
+    }
+
 private:
     // recalculate knee values for a new threshold or knee width
     void recalcKnees()
@@ -174,17 +210,37 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GainComputer)
 };
 
-/** Compressor Processing */
-class CompressorProcessor : public BaseProcessor
+/** Compressor Processing
+
+    Works a block at a time: the detector writes the level envelope into a
+    scratch buffer, the gain computer turns it into gains, and each channel
+    is multiplied by its gains in one pass. With lookahead the audio is
+    delayed so gain changes land before the peaks that caused them.
+ */
+class CompressorProcessor : public BaseProcessor,
+                            public AudioProcessorParameter::Listener,
+                            public AsyncUpdater
 {
 public:
     explicit CompressorProcessor (const int _numChannels = 2);
+    ~CompressorProcessor();
 
     const String getName() const override { return "Compressor"; }
 
     void fillInPluginDescription (PluginDescription& desc) const override;
 
+    /** How channels share gain reduction. */
+    enum StereoLink
+    {
+        linkAverage = 0, ///< detect the average of the channels (default)
+        linkMaximum, ///< detect the loudest channel
+        linkOff ///< each channel is compressed on its own
+    };
+
     void updateParams();
+
+    /** Apply the lookahead parameter and report it as latency (message thread). */
+    void updateLookahead();
     void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override;
     void releaseResources() override;
     void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override;
@@ -212,15 +268,17 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
     void numChannelsChanged() override;
 
-    class Listener
-    {
-    public:
-        virtual ~Listener() {}
-        virtual void updateInGainDB (float /*inDB*/) {}
-    };
+    /** Returns the detected input level at the end of the last block in
+        decibels. Safe to call from any thread. */
+    float getInputLevelDB() const noexcept { return inputLevelDB.load (std::memory_order_relaxed); }
 
-    void addCompressorListener (Listener* l) { listeners.add (l); }
-    void removeCompressorListener (Listener* l) { listeners.remove (l); }
+    /** Returns the most gain reduction applied in the last block in
+        decibels. Safe to call from any thread. */
+    float getGainReductionDB() const noexcept { return gainReductionDB.load (std::memory_order_relaxed); }
+
+    void parameterValueChanged (int parameterIndex, float newValue) override;
+    void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override;
+    void handleAsyncUpdate() override;
 
 protected:
     inline bool isBusesLayoutSupported (const BusesLayout& layout) const override
@@ -249,14 +307,6 @@ protected:
     }
 
 private:
-    inline float getSummedMonoSample (AudioBuffer<float>& buffer, int idx, int numChans)
-    {
-        float sum = 0.0f;
-        for (int ch = 0; ch < numChans; ++ch)
-            sum += buffer.getSample (ch, idx);
-        return sum / (float) numChans;
-    };
-
     int numChannels = 0;
     AudioParameterFloat* threshDB = nullptr;
     AudioParameterFloat* ratio = nullptr;
@@ -265,15 +315,29 @@ private:
     AudioParameterFloat* releaseMs = nullptr;
     AudioParameterFloat* makeupDB = nullptr;
     AudioParameterFloat* sideChain = nullptr;
+    AudioParameterFloat* lookaheadMs = nullptr;
+    AudioParameterChoice* stereoLink = nullptr;
 
     SmoothedValue<float, ValueSmoothingTypes::Multiplicative> makeupGain = 1.0f;
     const int numSteps = 200;
 
-    LevelDetector detector;
-    LevelDetector sideDetector;
+    LevelDetector detectors[2];
+    LevelDetector sideDetectors[2];
     GainComputer gainComputer;
 
-    ListenerList<Listener> listeners;
+    AudioBuffer<float> levels; ///< level envelope, then gains, per detector
+    AudioBuffer<float> sideLevels; ///< sidechain level envelope per detector
+    AudioBuffer<float> delayLine; ///< lookahead history followed by the block
+    int maxLookahead = 0;
+    int lookahead = 0; ///< delay in use (audio thread)
+    std::atomic<int> lookaheadTarget { 0 };
+
+    std::atomic<float> inputLevelDB { -100.0f };
+    std::atomic<float> gainReductionDB { 0.0f };
+
+    void processChunk (AudioBuffer<float>& main, AudioBuffer<float>& side, int start, int numSamples);
+    void computeKey (AudioBuffer<float>& input, int channel, bool linked, float* dest, int start, int numSamples) const noexcept;
+    void delayMain (AudioBuffer<float>& main, int start, int numSamples) noexcept;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorProcessor)
 };
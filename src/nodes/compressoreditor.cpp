@@ -13,13 +13,10 @@ CompressorNodeEditor::CompViz::CompViz (CompressorProcessor& proc) : proc (proc)
     startTimer (40);
 
     updateCurve();
-
-    proc.addCompressorListener (this);
 }
 
 CompressorNodeEditor::CompViz::~CompViz()
 {
-    proc.removeCompressorListener (this);
 }
 
 float CompressorNodeEditor::CompViz::getDBForX (float x)
@@ -69,6 +66,7 @@ void CompressorNodeEditor::CompViz::updateInGainDB (float inDB)
 
 void CompressorNodeEditor::CompViz::timerCallback()
 {
+    updateInGainDB (proc.getInputLevelDB());
     repaint();
 }
 
@@ -108,7 +106,7 @@ CompressorNodeEditor::CompressorNodeEditor (CompressorProcessor& proc) : AudioPr
                                                                          compViz (proc)
 {
     setOpaque (true);
-    setSize (610, 420);
+    setSize (790, 420);
     addAndMakeVisible (knobs);
     addAndMakeVisible (compViz);
 }
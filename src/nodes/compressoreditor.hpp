@@ -23,14 +23,13 @@ private:
     KnobsComponent knobs;
 
     class CompViz : public Component,
-                    private CompressorProcessor::Listener,
                     private Timer
     {
     public:
         CompViz (CompressorProcessor& proc);
         ~CompViz();
 
-        void updateInGainDB (float inDB) override;
+        void updateInGainDB (float inDB);
         void timerCallback() override;
 
         void updateCurve();
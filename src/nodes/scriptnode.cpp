@@ -39,10 +39,12 @@ namespace element {
 
 //=============================================================================
 ScriptNode::ScriptNode() noexcept
-    : Processor (0)
+    : Processor (0),
+      lua (&sol::default_at_panic, &LuaAllocator::alloc, &allocator)
 {
     setName ("Script");
     Lua::initializeState (lua);
+    allocator.attach (lua.lua_state());
 
     lua.set_function ("print", [this] (sol::variadic_args va) {
         auto& e = lua;
@@ -193,6 +195,7 @@ void ScriptNode::render (RenderContext& rc)
 {
     ScopedLock sl (lock);
     script->process (rc.audio, rc.midi);
+    allocator.step (lua.lua_state());
 }
 
 void ScriptNode::setState (const void* data, int size)
@@ -5,6 +5,7 @@
 
 #include "nodes/baseprocessor.hpp"
 #include <element/processor.hpp>
+#include "scripting/luaallocator.hpp"
 #include "sol/sol.hpp"
 
 namespace element {
@@ -44,6 +45,9 @@ public:
 
     void setPlayHead (juce::AudioPlayHead*) override;
 
+    /** Returns memory and garbage collection stats of the script's state. */
+    LuaAllocator::Stats getMemoryStats() const noexcept { return allocator.getStats(); }
+
     //==========================================================================
     int getNumPrograms() const override { return 2; }
     int getCurrentProgram() const override { return _program; }
@@ -56,6 +60,7 @@ protected:
 
 private:
     CriticalSection lock;
+    LuaAllocator allocator; // must outlive the state
     sol::state lua;
     CodeDocument dspCode, edCode;
     std::unique_ptr<DSPScript> script;
@@ -181,6 +181,47 @@ private:
     }
 };
 
+//==============================================================================
+class ScriptMemoryPropertyComponent : public PropertyComponent,
+                                      private Timer
+{
+public:
+    ScriptMemoryPropertyComponent (ScriptNode::Ptr n)
+        : PropertyComponent ("Memory"),
+          node (n)
+    {
+        addAndMakeVisible (text);
+        text.setFont (text.getFont().withHeight (11.f));
+        refresh();
+        startTimer (1000);
+    }
+
+    void refresh() override
+    {
+        const auto stats = node->getMemoryStats();
+        String str;
+        str << File::descriptionOfSizeInBytes ((int64) stats.bytesInUse)
+            << " (peak " << File::descriptionOfSizeInBytes ((int64) stats.peakBytesInUse) << ")";
+        if (stats.fallbacks > 0)
+            str << ", " << stats.fallbacks << " malloc";
+        str << ", GC " << roundToInt (stats.gcMaxMicros) << "us max";
+        text.setText (str, dontSendNotification);
+
+        String tip;
+        tip << "Arena: " << File::descriptionOfSizeInBytes ((int64) stats.arenaUsed)
+            << " of " << File::descriptionOfSizeInBytes ((int64) stats.arenaSize) << " used\n"
+            << "GC: " << stats.gcCycles << " cycles, " << stats.gcSteps << " steps, last "
+            << roundToInt (stats.gcLastMicros) << "us";
+        text.setTooltip (tip);
+    }
+
+private:
+    ScriptNode::Ptr node;
+    Label text;
+
+    void timerCallback() override { refresh(); }
+};
+
 //==============================================================================
 static ValueTree getUIChild (const Node& node, const String& name)
 {
@@ -349,6 +390,7 @@ void ScriptNodeEditor::updateProperties()
             continue;
         pcs.add (new LuaNodeParameterPropertyFloat (param));
     }
+    pcs.add (new ScriptMemoryPropertyComponent (lua));
     props.addProperties (pcs);
 }
 
@@ -13,10 +13,13 @@
 #include "nodes/nodetypes.hpp"
 #include "engine/ionode.hpp"
 #include "datapath.hpp"
+#include "pluginsearch.hpp"
 #include "utils.hpp"
 
 #define EL_DEAD_AUDIO_PLUGINS_FILENAME "scanner/crashed.txt"
 #define EL_PLUGIN_SCANNER_SLAVE_LIST_PATH "scanner/list.xml"
+#define EL_PLUGIN_SCANNER_CACHE_PATH "scanner/cache.xml"
+#define EL_PLUGIN_SCANNER_JOURNAL_DIR "scanner"
 #define EL_PLUGIN_SCANNER_WAITING_STATE "waiting"
 #define EL_PLUGIN_SCANNER_READY_STATE "ready"
 
@@ -80,6 +83,33 @@ static void setDeadMansPedalFile (const StringArray& newContents)
         deadMansPedalFile.replaceWithText (newContents.joinIntoString ("\n"), true, true);
 }
 
+static void addToDeadMansPedal (const StringArray& identifiers)
+{
+    auto lines = readDeadMansPedalFile();
+    lines.addArray (identifiers);
+    lines.removeDuplicates (false);
+    lines.removeEmptyStrings();
+    setDeadMansPedalFile (lines);
+}
+
+/** Move identifiers left in scanner crash journals, e.g. by a scan that
+    was running when the app died, to the dead mans pedal. */
+static void mergeScanJournals()
+{
+    const auto journals = DataPath::applicationDataDir()
+                              .getChildFile (EL_PLUGIN_SCANNER_JOURNAL_DIR)
+                              .findChildFiles (File::findFiles, false, "crashed-*.txt");
+    StringArray crashed;
+    for (const auto& journal : journals)
+        journal.readLines (crashed);
+    crashed.removeEmptyStrings();
+    if (! crashed.isEmpty())
+        addToDeadMansPedal (crashed);
+
+    for (const auto& journal : journals)
+        journal.deleteFile();
+}
+
 static void applyBlacklistingsFromDeadMansPedal (KnownPluginList& list)
 {
     // If any plugins have crashed recently when being loaded, move them to the
@@ -91,16 +121,135 @@ static void applyBlacklistingsFromDeadMansPedal (KnownPluginList& list)
 } // namespace detail
 
 //==============================================================================
+/** Remembers what was found in each plugin binary, keyed on the format, path,
+    modification time and size, so a rescan only touches binaries that changed.
+    Identifiers that aren't files (e.g. LV2 URIs) are stamped with the file
+    their provider loads them from. */
+class PluginScanCache
+{
+public:
+    PluginScanCache()
+    {
+        if (auto xml = XmlDocument::parse (file()))
+            if (xml->hasTagName ("PLUGINCACHE"))
+                root = std::move (xml);
+
+        for (auto* entry : root->getChildWithTagNameIterator ("ENTRY"))
+            index.set (key (entry->getStringAttribute ("format"), entry->getStringAttribute ("identifier")), entry);
+    }
+
+    /** Adds the cached types for an identifier to the list. Returns false if
+        the identifier needs to be scanned. */
+    bool restore (const String& format, const String& ID, const File& binary, KnownPluginList& list)
+    {
+        auto* const entry = index[key (format, ID)];
+
+        if (entry == nullptr)
+        {
+            // known from before there was a cache, trust it.
+            OwnedArray<PluginDescription> known;
+            for (const auto& type : list.getTypes())
+                if (type.pluginFormatName == format && type.fileOrIdentifier == ID)
+                    known.add (new PluginDescription (type));
+            if (known.isEmpty())
+                return false;
+            store (format, ID, binary, known);
+            return true;
+        }
+
+        int64 modified = 0, size = 0;
+        stamp (binary, modified, size);
+        if (entry->getStringAttribute ("modified").getLargeIntValue() != modified
+            || entry->getStringAttribute ("size").getLargeIntValue() != size)
+        {
+            // changed on disk, drop the old types and scan again.
+            for (const auto& type : list.getTypes())
+                if (type.pluginFormatName == format && type.fileOrIdentifier == ID)
+                    list.removeType (type);
+            return false;
+        }
+
+        for (const auto* item : entry->getChildIterator())
+        {
+            PluginDescription desc;
+            if (desc.loadFromXml (*item) && list.getTypeForIdentifierString (desc.createIdentifierString()) == nullptr)
+                list.addType (desc);
+        }
+
+        return true;
+    }
+
+    /** Records the types found for an identifier. */
+    void store (const String& format, const String& ID, const File& binary, const OwnedArray<PluginDescription>& types)
+    {
+        const auto k = key (format, ID);
+        if (auto* old = index[k])
+            root->removeChildElement (old, true);
+
+        int64 modified = 0, size = 0;
+        stamp (binary, modified, size);
+
+        auto* entry = root->createNewChildElement ("ENTRY");
+        entry->setAttribute ("format", format);
+        entry->setAttribute ("identifier", ID);
+        entry->setAttribute ("modified", String (modified));
+        entry->setAttribute ("size", String (size));
+        for (const auto* type : types)
+            entry->addChildElement (type->createXml().release());
+
+        index.set (k, entry);
+        changed = true;
+    }
+
+    void save()
+    {
+        if (! changed)
+            return;
+        file().create();
+        root->writeTo (file());
+        changed = false;
+    }
+
+private:
+    std::unique_ptr<XmlElement> root { std::make_unique<XmlElement> ("PLUGINCACHE") };
+    HashMap<String, XmlElement*> index;
+    bool changed = false;
+
+    static File file() { return DataPath::applicationDataDir().getChildFile (EL_PLUGIN_SCANNER_CACHE_PATH); }
+    static String key (const String& format, const String& ID) { return format + "|" + ID; }
+
+    static void stamp (const File& binary, int64& modified, int64& size)
+    {
+        modified = size = 0;
+        if (! binary.exists())
+            return;
+        modified = binary.getLastModificationTime().toMilliseconds();
+        size = binary.isDirectory() ? 0 : binary.getSize();
+    }
+};
+
+//==============================================================================
+/** Owns one scanner process and the identifier it is currently scanning.
+
+    The identifier in flight is written to the worker's own crash journal, so
+    a process which dies takes only that plugin with it. */
 class PluginScannerCoordinator : public juce::ChildProcessCoordinator
 {
 public:
-    explicit PluginScannerCoordinator (PluginScanner& o)
-        : owner (o)
+    PluginScannerCoordinator (PluginScanner& o, int workerIndex, WaitableEvent& resultReady)
+        : owner (o),
+          index (workerIndex),
+          ready (resultReady)
     {
         launchScanner (0, 0);
     }
 
-    ~PluginScannerCoordinator() {}
+    ~PluginScannerCoordinator()
+    {
+        // a scan still in flight here was cancelled, it didn't crash.
+        killWorkerProcess();
+        journalFile().deleteFile();
+    }
 
     enum class State
     {
@@ -115,45 +264,106 @@ public:
         std::unique_ptr<XmlElement> xml;
     };
 
-    Response getResponse()
+    static File journalFile (int workerIndex)
     {
-        std::unique_lock<std::mutex> lock { mutex };
+        return DataPath::applicationDataDir().getChildFile (EL_PLUGIN_SCANNER_JOURNAL_DIR)
+            .getChildFile ("crashed-" + String (workerIndex) + ".txt");
+    }
+
+    bool isIdle() const noexcept { return identifier.isEmpty(); }
+    const String& getIdentifier() const noexcept { return identifier; }
+
+    /** Ask the process to scan an identifier. */
+    bool scan (const String& formatName, const String& fileOrIdentifier)
+    {
+        jassert (isIdle());
+        if (lost && ! relaunch())
+            return false;
+
+        auto journal = journalFile();
+        journal.create();
+        journal.replaceWithText (fileOrIdentifier, false, false);
+
+        MemoryBlock block;
+        MemoryOutputStream stream { block, true };
+        stream.writeString (formatName);
+        stream.writeString (fileOrIdentifier);
+        stream.flush();
+
+        if (! sendMessageToWorker (block))
+        {
+            journal.deleteFile();
+            return false;
+        }
+
+        identifier = fileOrIdentifier;
+        return true;
+    }
 
-        if (! condvar.wait_for (lock, std::chrono::milliseconds { 50 }, [&] { return gotResult || connectionLost; }))
+    /** Returns a response without waiting if one has arrived. */
+    Response getResponse()
+    {
+        const std::lock_guard<std::mutex> lock { mutex };
+        if (! gotResult && ! connectionLost)
             return { State::timeout, nullptr };
 
         const auto state = connectionLost ? State::connectionLost : State::gotResult;
+        lost = lost || connectionLost;
         connectionLost = false;
         gotResult = false;
-
         return { state, std::move (pluginDescription) };
     }
 
+    /** Finish the current identifier. A scan which crashed the process goes
+        to the dead mans pedal before the journal is reused. */
+    void finish (bool crashed)
+    {
+        if (crashed)
+            detail::addToDeadMansPedal (StringArray (identifier));
+        journalFile().deleteFile();
+        identifier.clear();
+    }
+
     void handleMessageFromWorker (const MemoryBlock& mb) override
     {
-        const std::lock_guard<std::mutex> lock { mutex };
-        pluginDescription = juce::parseXML (mb.toString());
-        gotResult = true;
-        condvar.notify_one();
+        {
+            const std::lock_guard<std::mutex> lock { mutex };
+            pluginDescription = juce::parseXML (mb.toString());
+            gotResult = true;
+        }
+        ready.signal();
     }
 
     void handleConnectionLost() override
     {
-        const std::lock_guard<std::mutex> lock { mutex };
-        connectionLost = true;
-        condvar.notify_one();
+        {
+            const std::lock_guard<std::mutex> lock { mutex };
+            connectionLost = true;
+        }
+        ready.signal();
     }
 
 private:
     PluginScanner& owner;
+    const int index;
+    WaitableEvent& ready;
+    String identifier;
+    bool lost = false;
 
     std::mutex mutex;
-    std::condition_variable condvar;
-
     std::unique_ptr<XmlElement> pluginDescription;
     bool connectionLost = false;
     bool gotResult = false;
 
+    File journalFile() const { return journalFile (index); }
+
+    bool relaunch()
+    {
+        killWorkerProcess();
+        lost = false;
+        return launchScanner (0, 0);
+    }
+
     bool launchScanner (const int timeout = EL_PLUGIN_SCANNER_DEFAULT_TIMEOUT, const int flags = 0)
     {
         auto scannerExe = owner.scannerExeFile();
@@ -329,12 +539,13 @@ private:
 //==============================================================================
 PluginScanner::PluginScanner (PluginManager& manager)
     : _manager (manager),
-      list (manager.getKnownPlugins()) {}
+      list (manager.getKnownPlugins()),
+      numWorkers (jlimit (1, 8, SystemStats::getNumCpus() / 2)) {}
 
 PluginScanner::~PluginScanner()
 {
     listeners.clear();
-    superprocess.reset();
+    workers.clear();
 }
 
 void PluginScanner::cancel()
@@ -342,48 +553,12 @@ void PluginScanner::cancel()
     cancelFlag = 1;
 }
 
-bool PluginScanner::isScanning() const { return superprocess != nullptr; }
+bool PluginScanner::isScanning() const { return ! workers.isEmpty(); }
 
-bool PluginScanner::retrieveDescriptions (const String& formatName,
-                                          const String& fileOrIdentifier,
-                                          OwnedArray<PluginDescription>& result)
+void PluginScanner::setNumWorkers (int newNumWorkers)
 {
-    if (superprocess == nullptr)
-        superprocess = std::make_unique<PluginScannerCoordinator> (*this);
-
-    MemoryBlock block;
-    MemoryOutputStream stream { block, true };
-    stream.writeString (formatName);
-    stream.writeString (fileOrIdentifier);
-
-    if (! superprocess->sendMessageToWorker (block))
-        return false;
-
-    using State = PluginScannerCoordinator::State;
-
-    for (;;)
-    {
-        if (cancelFlag.get() != 0)
-            return true;
-
-        const auto response = superprocess->getResponse();
-
-        if (response.state == State::timeout)
-            continue;
-
-        if (response.xml != nullptr)
-        {
-            for (const auto* item : response.xml->getChildIterator())
-            {
-                auto desc = std::make_unique<PluginDescription>();
-
-                if (desc->loadFromXml (*item))
-                    result.add (std::move (desc));
-            }
-        }
-
-        return (response.state == State::gotResult);
-    }
+    jassert (! isScanning());
+    numWorkers = jmax (1, newNumWorkers);
 }
 
 File PluginScanner::scannerExeFile() const noexcept
@@ -397,6 +572,9 @@ void PluginScanner::scanAudioFormat (const String& formatName)
 
     StringArray identifiers;
     std::function<String (const String&)> pluginName = [] (const String& ID) -> juce::String { return ID; };
+    std::function<File (const String&)> binaryFor = [] (const String& ID) {
+        return File::isAbsolutePath (ID) ? File (ID) : File();
+    };
 
     if (auto* format = _manager.getAudioPluginFormat (formatName))
     {
@@ -415,44 +593,88 @@ void PluginScanner::scanAudioFormat (const String& formatName)
             detail::readSearchPath (*_manager.props, formatName),
             true,
             false);
+        binaryFor = [provider] (const String& ID) {
+            return File::isAbsolutePath (ID) ? File (ID) : provider->fileForType (ID);
+        };
     }
 
     listeners.call (&Listener::audioPluginScanProgress, 0.0f);
 
-    float step = 1.f;
+    // anything blacklisted or unchanged since the last scan is skipped.
+    StringArray pending;
     for (const auto& ID : identifiers)
-    {
-        if (cancelFlag.get() != 0)
-            return;
+        if (! list.getBlacklistedFiles().contains (ID) && ! cache->restore (formatName, ID, binaryFor (ID), list))
+            pending.add (ID);
 
-        listeners.call (&Listener::audioPluginScanStarted, pluginName (ID));
+    int numDone = identifiers.size() - pending.size();
+    int next = 0;
 
-        if (list.getTypeForFile (ID) || list.getBlacklistedFiles().contains (ID))
-            continue;
+    auto finished = [&] (const String& ID, const OwnedArray<PluginDescription>& descriptions) {
+        if (descriptions.size() == 0 && ! list.getBlacklistedFiles().contains (ID))
+            failedIdentifiers.add (ID);
+
+        ++numDone;
+        listeners.call (&Listener::audioPluginScanProgress,
+                        static_cast<float> (numDone) / static_cast<float> (identifiers.size()));
+    };
 
-        OwnedArray<PluginDescription> descriptions;
+    while (workers.size() < jmin (numWorkers, pending.size()))
+        workers.add (new PluginScannerCoordinator (*this, workers.size(), resultReady));
 
-        auto crashed = detail::readDeadMansPedalFile();
-        crashed.removeString (ID);
-        crashed.add (ID);
-        detail::setDeadMansPedalFile (crashed);
+    using State = PluginScannerCoordinator::State;
 
-        if (retrieveDescriptions (formatName, ID, descriptions))
+    while (numDone < identifiers.size() && cancelFlag.get() == 0)
+    {
+        for (auto* worker : workers)
         {
-            for (auto* desc : descriptions)
-                list.addType (*desc);
+            if (! worker->isIdle() || next >= pending.size())
+                continue;
 
-            // Managed to load without crashing, so remove it from the dead-man's-pedal..
-            crashed.removeString (ID);
-            detail::setDeadMansPedalFile (crashed);
+            const auto& ID = pending.getReference (next++);
+            listeners.call (&Listener::audioPluginScanStarted, pluginName (ID));
+            if (! worker->scan (formatName, ID))
+                finished (ID, {});
         }
 
-        if (descriptions.size() == 0 && ! list.getBlacklistedFiles().contains (ID))
-            failedIdentifiers.add (ID);
+        resultReady.wait (50);
 
-        listeners.call (&Listener::audioPluginScanProgress,
-                        step / static_cast<float> (identifiers.size()));
-        step += 1.f;
+        for (auto* worker : workers)
+        {
+            if (worker->isIdle())
+                continue;
+
+            const auto response = worker->getResponse();
+            if (response.state == State::timeout)
+                continue;
+
+            const auto ID = worker->getIdentifier();
+            const bool crashed = response.state == State::connectionLost;
+            worker->finish (crashed);
+
+            OwnedArray<PluginDescription> descriptions;
+            if (response.xml != nullptr)
+            {
+                for (const auto* item : response.xml->getChildIterator())
+                {
+                    auto desc = std::make_unique<PluginDescription>();
+                    if (desc->loadFromXml (*item))
+                        descriptions.add (std::move (desc));
+                }
+            }
+
+            if (crashed)
+            {
+                crashedIdentifiers.add (ID);
+            }
+            else if (! descriptions.isEmpty())
+            {
+                for (auto* desc : descriptions)
+                    list.addType (*desc);
+                cache->store (formatName, ID, binaryFor (ID), descriptions);
+            }
+
+            finished (ID, descriptions);
+        }
     }
 }
 
@@ -467,8 +689,12 @@ void PluginScanner::scanForAudioPlugins (const StringArray& formats)
     if (! scannerExeFile().existsAsFile())
         return;
 
-    detail::setDeadMansPedalFile ({});
+    // crashes from a scan that never finished stay blacklisted.
+    detail::mergeScanJournals();
     cancelFlag = 0;
+    crashedIdentifiers.clearQuick();
+    if (cache == nullptr)
+        cache = std::make_unique<PluginScanCache>();
 
     for (const auto& format : formats)
     {
@@ -477,15 +703,13 @@ void PluginScanner::scanForAudioPlugins (const StringArray& formats)
             break;
     }
 
-    superprocess.reset();
+    workers.clear();
+    cache->save();
     cancelFlag = 0;
 
-    auto crashed = detail::readDeadMansPedalFile();
-    for (const auto& c : failedIdentifiers)
-        crashed.add (c);
-    crashed.removeDuplicates (false);
-    crashed.removeEmptyStrings();
-    detail::setDeadMansPedalFile (crashed);
+    auto crashed = crashedIdentifiers;
+    crashed.addArray (failedIdentifiers);
+    detail::addToDeadMansPedal (crashed);
     detail::applyBlacklistingsFromDeadMansPedal (list);
     detail::setDeadMansPedalFile ({});
     failedIdentifiers.clearQuick(); // FIXME: this is a workaround that
@@ -629,16 +853,26 @@ private:
 };
 
 //==============================================================================
-class PluginManager::Private : public PluginScanner::Listener
+class PluginManager::Private : public PluginScanner::Listener,
+                               public ChangeListener
 {
 public:
     Private (PluginManager& o)
         : owner (o)
     {
         deadAudioPlugins = DataPath::applicationDataDir().getChildFile (EL_DEAD_AUDIO_PLUGINS_FILENAME);
+        allPlugins.addChangeListener (this);
     }
 
-    ~Private() {}
+    ~Private()
+    {
+        allPlugins.removeChangeListener (this);
+    }
+
+    void changeListenerCallback (ChangeBroadcaster*) override
+    {
+        search.update (allPlugins.getTypes());
+    }
 
     /** returns true if anything changed in the plugin list */
     bool updateBlacklistedAudioPlugins()
@@ -671,6 +905,7 @@ private:
     PluginManager& owner;
     AudioPluginFormatManager formats;
     KnownPluginList allPlugins;
+    PluginSearchIndex search;
     File deadAudioPlugins;
     UnverifiedPlugins unverified;
     NodeFactory nodes;
@@ -814,6 +1049,14 @@ void PluginManager::addToKnownPlugins (const PluginDescription& desc)
     }
 }
 
+Array<PluginDescription> PluginManager::searchPlugins (const String& query, int maxResults) const
+{
+    // list changes arrive asynchronously, catch up if they haven't yet.
+    if (priv->allPlugins.getNumTypes() != priv->search.size())
+        priv->search.update (priv->allPlugins.getTypes());
+    return priv->search.search (query, maxResults);
+}
+
 void PluginManager::searchUnverifiedPlugins()
 {
     if (! priv)
@@ -904,6 +1147,40 @@ Processor* PluginManager::createGraphNode (const PluginDescription& desc, String
     return nullptr;
 }
 
+void PluginManager::createGraphNodeAsync (const PluginDescription& desc,
+                                          std::function<void (Processor*, const String&)> callback)
+{
+    if (desc.pluginFormatName == "Internal" || getAudioPluginFormat (desc.pluginFormatName) == nullptr)
+    {
+        String errorMsg;
+        auto* node = createGraphNode (desc, errorMsg);
+        callback (node, errorMsg);
+        return;
+    }
+
+    getAudioPluginFormats().createPluginInstanceAsync (
+        desc, priv->sampleRate, priv->blockSize, [callback] (std::unique_ptr<AudioPluginInstance> plugin, const String& errorMsg) {
+            if (plugin == nullptr)
+            {
+                callback (nullptr, errorMsg);
+                return;
+            }
+
+            plugin->enableAllBuses();
+            callback (NodeFactory::wrap (plugin.release()), {});
+        });
+}
+
+bool PluginManager::canCreateGraphNodeInBackground (const PluginDescription& desc) const
+{
+    if (desc.pluginFormatName == "Internal" || getAudioPluginFormat (desc.pluginFormatName) != nullptr)
+        return false;
+    for (const auto* provider : priv->nodes.providers())
+        if (provider->format() == desc.pluginFormatName)
+            return provider->canCreateInBackground();
+    return false;
+}
+
 AudioPluginFormatManager& PluginManager::getAudioPluginFormats()
 {
     return priv->formats;
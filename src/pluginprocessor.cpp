@@ -85,6 +85,7 @@ PluginProcessor::PluginProcessor (Variant instanceType, int numBuses)
 PluginProcessor::~PluginProcessor()
 {
     asyncPrepare.reset();
+    graphsLoadedConnection.disconnect();
 
     for (auto* param : perfparams)
         param->clearNode();
@@ -208,7 +209,7 @@ void PluginProcessor::releaseResources()
     }
 }
 
-void PluginProcessor::reloadEngine()
+void PluginProcessor::reloadEngine (std::function<void()> graphsLoaded)
 {
     jassert (MessageManager::getInstance()->isThisTheMessageThread());
 
@@ -222,10 +223,18 @@ void PluginProcessor::reloadEngine()
     updateLatencySamples();
 
     session->restoreGraphState();
+
+    // the graphs load asynchronously, models and devices need their nodes.
+    graphsLoadedConnection.disconnect();
+    graphsLoadedConnection = enginectl->sigGraphsLoaded.connect ([this, graphsLoaded]() {
+        graphsLoadedConnection.disconnect();
+        enginectl->syncModels();
+        guictl->stabilizeContent();
+        devsctl->refresh();
+        if (graphsLoaded)
+            graphsLoaded();
+    });
     enginectl->sessionReloaded();
-    enginectl->syncModels();
-    guictl->stabilizeContent();
-    devsctl->refresh();
 
     suspendProcessing (wasSuspended);
 }
@@ -482,29 +491,29 @@ void PluginProcessor::handleAsyncUpdate()
 {
     PLUGIN_DBG ("[element] handle async update");
     initialize();
-    reloadEngine();
-
-    auto session = context->session();
-    const auto ppData = session->getValueTree().getChildWithName ("perfParams");
+    reloadEngine ([this]() {
+        auto session = context->session();
+        const auto ppData = session->getValueTree().getChildWithName ("perfParams");
 
-    for (int i = 0; i < ppData.getNumChildren(); ++i)
-    {
-        const auto data = ppData.getChild (i);
-        const int index = (int) data[tags::index];
-        if (! isPositiveAndBelow (index, 8))
-            continue;
-        const int parameter = (int) data[tags::parameter];
-        const String uuid = data[tags::node].toString();
-        if (uuid.isEmpty())
-            continue;
-        const Node node = session->findNodeById (Uuid (uuid));
-        auto* const param = perfparams[index];
-        if (param != nullptr && node.isValid())
-            param->bindToNode (node, parameter);
-    }
+        for (int i = 0; i < ppData.getNumChildren(); ++i)
+        {
+            const auto data = ppData.getChild (i);
+            const int index = (int) data[tags::index];
+            if (! isPositiveAndBelow (index, 8))
+                continue;
+            const int parameter = (int) data[tags::parameter];
+            const String uuid = data[tags::node].toString();
+            if (uuid.isEmpty())
+                continue;
+            const Node node = session->findNodeById (Uuid (uuid));
+            auto* const param = perfparams[index];
+            if (param != nullptr && node.isValid())
+                param->bindToNode (node, parameter);
+        }
 
-    sessionctl->sigSessionLoaded();
-    onPerfParamsChanged();
+        sessionctl->sigSessionLoaded();
+        onPerfParamsChanged();
+    });
 }
 
 bool PluginProcessor::isNodeBoundToAnyPerformanceParameter (const Node& boundNode, int boundParam) const
@@ -468,7 +468,10 @@ private:
     void initialize();
     friend class AsyncUpdater;
     void handleAsyncUpdate() override;
-    void reloadEngine();
+    SignalConnection graphsLoadedConnection;
+    /** Reload the session's graphs, graphsLoaded is called once their nodes
+        have loaded. */
+    void reloadEngine (std::function<void()> graphsLoaded = nullptr);
 
     int calculateLatencySamples() const;
     static BusesProperties createDefaultBuses (Variant variant, int numAux);
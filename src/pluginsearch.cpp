@@ -0,0 +1,318 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <algorithm>
+
+#include "pluginsearch.hpp"
+
+using namespace juce;
+
+namespace element {
+
+namespace detail {
+/** Field weights, in PluginSearchIndex::Field order. */
+static constexpr float searchWeights[] = { 4.0f, 2.0f, 1.0f, 1.0f };
+
+static uint64_t packTrigram (juce_wchar a, juce_wchar b, juce_wchar c) noexcept
+{
+    // code points fit in 21 bits.
+    return ((uint64_t) a << 42) | ((uint64_t) b << 21) | (uint64_t) c;
+}
+
+/** Add the distinct trigrams of every word in text. */
+static void addTrigrams (const String& text, std::vector<uint64_t>& out)
+{
+    juce_wchar a = 0, b = 0;
+    int run = 0;
+    for (auto p = text.getCharPointer(); ! p.isEmpty();)
+    {
+        const auto c = p.getAndAdvance();
+        if (! CharacterFunctions::isLetterOrDigit (c))
+        {
+            run = 0;
+            continue;
+        }
+
+        if (++run >= 3)
+            out.push_back (packTrigram (a, b, c));
+        a = b;
+        b = c;
+    }
+}
+
+static void sortUnique (std::vector<uint64_t>& trigrams)
+{
+    std::sort (trigrams.begin(), trigrams.end());
+    trigrams.erase (std::unique (trigrams.begin(), trigrams.end()), trigrams.end());
+}
+} // namespace detail
+
+StringArray PluginSearchIndex::tokenize (const String& text)
+{
+    StringArray tokens;
+    String current;
+    juce_wchar last = 0;
+
+    for (auto p = text.getCharPointer(); ! p.isEmpty();)
+    {
+        const auto c = p.getAndAdvance();
+        if (! CharacterFunctions::isLetterOrDigit (c))
+        {
+            tokens.add (current);
+            current.clear();
+            last = 0;
+            continue;
+        }
+
+        // split "ProQ3" into pro, q and 3.
+        if (last != 0
+            && ((CharacterFunctions::isUpperCase (c) && CharacterFunctions::isLowerCase (last))
+                || CharacterFunctions::isDigit (c) != CharacterFunctions::isDigit (last)))
+        {
+            tokens.add (current);
+            current.clear();
+        }
+
+        current << CharacterFunctions::toLowerCase (c);
+        last = c;
+    }
+
+    tokens.add (current);
+    tokens.removeEmptyStrings();
+    return tokens;
+}
+
+void PluginSearchIndex::update (const Array<PluginDescription>& types)
+{
+    const ScopedLock sl (lock);
+    std::vector<bool> seen (entries.size(), false);
+
+    for (const auto& desc : types)
+    {
+        const auto identifier = desc.createIdentifierString();
+        if (slots.contains (identifier))
+        {
+            const int slot = slots[identifier];
+            auto& entry = entries[(size_t) slot];
+            seen[(size_t) slot] = true;
+            if (sameFields (entry.desc, desc))
+            {
+                entry.desc = desc;
+                continue;
+            }
+
+            remove (slot);
+        }
+
+        add (desc, identifier);
+        if (seen.size() < entries.size())
+            seen.resize (entries.size(), false);
+        seen[(size_t) slots[identifier]] = true;
+    }
+
+    for (size_t slot = 0; slot < entries.size(); ++slot)
+        if (entries[slot].live && ! seen[slot])
+            remove ((int) slot);
+}
+
+void PluginSearchIndex::clear()
+{
+    const ScopedLock sl (lock);
+    entries.clear();
+    freeSlots.clear();
+    slots.clear();
+    postings.clear();
+    numLive = 0;
+}
+
+int PluginSearchIndex::size() const
+{
+    const ScopedLock sl (lock);
+    return numLive;
+}
+
+Array<PluginDescription> PluginSearchIndex::search (const String& query, int maxResults) const
+{
+    const auto words = tokenize (query);
+    if (words.isEmpty())
+        return {};
+
+    const ScopedLock sl (lock);
+    std::vector<float> scores (entries.size(), 0.0f);
+    std::vector<int> matched (entries.size(), 0);
+    std::vector<int> hits (entries.size(), 0);
+    std::vector<int> touched;
+    std::vector<uint64_t> trigrams;
+
+    for (const auto& word : words)
+    {
+        trigrams.clear();
+        detail::addTrigrams (word, trigrams);
+        detail::sortUnique (trigrams);
+
+        if (trigrams.empty())
+        {
+            // too short for trigrams, check word prefixes directly.
+            for (size_t slot = 0; slot < entries.size(); ++slot)
+            {
+                if (! entries[slot].live)
+                    continue;
+                const auto s = score (entries[slot], word, 0, 0);
+                if (s > 0.0f)
+                {
+                    scores[slot] += s;
+                    ++matched[slot];
+                }
+            }
+            continue;
+        }
+
+        touched.clear();
+        for (const auto trigram : trigrams)
+        {
+            const auto iter = postings.find (trigram);
+            if (iter == postings.end())
+                continue;
+            for (const auto slot : iter->second)
+                if (hits[(size_t) slot]++ == 0)
+                    touched.push_back (slot);
+        }
+
+        // allow roughly one typo in every three letters.
+        const int numTrigrams = (int) trigrams.size();
+        const int needed = numTrigrams <= 2 ? numTrigrams : (numTrigrams * 3 + 4) / 5;
+        for (const auto slot : touched)
+        {
+            const int numHits = hits[(size_t) slot];
+            hits[(size_t) slot] = 0;
+            if (numHits < needed)
+                continue;
+            const auto s = score (entries[(size_t) slot], word, numHits, numTrigrams);
+            if (s > 0.0f)
+            {
+                scores[(size_t) slot] += s;
+                ++matched[(size_t) slot];
+            }
+        }
+    }
+
+    std::vector<int> found;
+    for (size_t slot = 0; slot < entries.size(); ++slot)
+        if (matched[slot] == words.size())
+            found.push_back ((int) slot);
+
+    std::sort (found.begin(), found.end(), [&] (int a, int b) {
+        if (scores[(size_t) a] != scores[(size_t) b])
+            return scores[(size_t) a] > scores[(size_t) b];
+        return entries[(size_t) a].desc.name.compareNatural (entries[(size_t) b].desc.name) < 0;
+    });
+
+    if (maxResults > 0 && (int) found.size() > maxResults)
+        found.resize ((size_t) maxResults);
+
+    Array<PluginDescription> results;
+    results.ensureStorageAllocated ((int) found.size());
+    for (const auto slot : found)
+        results.add (entries[(size_t) slot].desc);
+    return results;
+}
+
+void PluginSearchIndex::add (const PluginDescription& desc, const String& identifier)
+{
+    int slot = (int) entries.size();
+    if (! freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        entries.emplace_back();
+    }
+
+    auto& entry = entries[(size_t) slot];
+    entry.desc = desc;
+    const String fields[numFields] = { desc.name, desc.manufacturerName, desc.category, desc.pluginFormatName };
+    for (int f = 0; f < numFields; ++f)
+    {
+        // tokenize the original case, lower case loses the camel case splits.
+        entry.tokens[f] = tokenize (fields[f]);
+        entry.text[f] = fields[f].toLowerCase();
+    }
+    entry.live = true;
+
+    index (entry, slot);
+    slots.set (identifier, slot);
+    ++numLive;
+}
+
+void PluginSearchIndex::remove (int slot)
+{
+    auto& entry = entries[(size_t) slot];
+    jassert (entry.live);
+    unindex (entry, slot);
+    slots.remove (entry.desc.createIdentifierString());
+    entry = Entry();
+    freeSlots.push_back (slot);
+    --numLive;
+}
+
+void PluginSearchIndex::index (Entry& entry, int slot)
+{
+    entry.trigrams.clear();
+    for (const auto& text : entry.text)
+        detail::addTrigrams (text, entry.trigrams);
+    detail::sortUnique (entry.trigrams);
+
+    for (const auto trigram : entry.trigrams)
+        postings[trigram].push_back (slot);
+}
+
+void PluginSearchIndex::unindex (const Entry& entry, int slot)
+{
+    for (const auto trigram : entry.trigrams)
+    {
+        const auto iter = postings.find (trigram);
+        if (iter == postings.end())
+            continue;
+        auto& list = iter->second;
+        list.erase (std::remove (list.begin(), list.end(), slot), list.end());
+        if (list.empty())
+            postings.erase (iter);
+    }
+}
+
+bool PluginSearchIndex::sameFields (const PluginDescription& a, const PluginDescription& b)
+{
+    return a.name == b.name
+           && a.manufacturerName == b.manufacturerName
+           && a.category == b.category
+           && a.pluginFormatName == b.pluginFormatName;
+}
+
+float PluginSearchIndex::score (const Entry& entry, const String& word, int hits, int numTrigrams)
+{
+    float best = 0.0f;
+    for (int f = 0; f < numFields; ++f)
+    {
+        const auto weight = detail::searchWeights[f];
+        for (const auto& token : entry.tokens[f])
+        {
+            if (token == word)
+                best = jmax (best, weight * 10.0f);
+            else if (token.startsWith (word))
+                best = jmax (best, weight * 6.0f);
+        }
+
+        if (numTrigrams > 0 && entry.text[f].contains (word))
+            best = jmax (best, weight * 3.0f);
+    }
+
+    // close enough by trigrams, probably a typo.
+    if (best <= 0.0f && numTrigrams > 0)
+        best = 2.0f * (float) hits / (float) numTrigrams;
+
+    return best;
+}
+
+} // namespace element
@@ -0,0 +1,80 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <element/juce/audio_processors.hpp>
+
+namespace element {
+
+/** A search index over plugin descriptions.
+
+    Name, manufacturer, category and format are split into lower case words
+    (camel case and digits split too) and every three letter run of a word
+    goes in a trigram index. Queries match words by prefix, fields by
+    substring, and fall back to trigram overlap so small typos still find
+    the plugin. Results are ranked with name matches first.
+
+    update() only re-indexes descriptions that were added or changed, so it
+    is cheap to call whenever the known plugin list changes.
+ */
+class PluginSearchIndex
+{
+public:
+    PluginSearchIndex() = default;
+
+    /** Sync the index with a list of descriptions. */
+    void update (const juce::Array<juce::PluginDescription>& types);
+
+    /** Remove everything from the index. */
+    void clear();
+
+    /** Returns matching descriptions, best first. When maxResults is above
+        zero, no more than that many are returned. An empty query matches
+        nothing. */
+    juce::Array<juce::PluginDescription> search (const juce::String& query, int maxResults = 0) const;
+
+    /** Returns the number of indexed descriptions. */
+    int size() const;
+
+    /** Split text into lower case search words. */
+    static juce::StringArray tokenize (const juce::String& text);
+
+private:
+    enum Field
+    {
+        nameField = 0,
+        manufacturerField,
+        categoryField,
+        formatField,
+        numFields
+    };
+
+    struct Entry
+    {
+        juce::PluginDescription desc;
+        juce::String text[numFields];
+        juce::StringArray tokens[numFields];
+        std::vector<uint64_t> trigrams;
+        bool live = false;
+    };
+
+    juce::CriticalSection lock;
+    std::vector<Entry> entries;
+    std::vector<int> freeSlots;
+    juce::HashMap<juce::String, int> slots;
+    std::unordered_map<uint64_t, std::vector<int>> postings;
+    int numLive = 0;
+
+    void add (const juce::PluginDescription& desc, const juce::String& identifier);
+    void remove (int slot);
+    void index (Entry& entry, int slot);
+    void unindex (const Entry& entry, int slot);
+    static bool sameFields (const juce::PluginDescription& a, const juce::PluginDescription& b);
+    static float score (const Entry& entry, const juce::String& word, int hits, int numTrigrams);
+};
+
+} // namespace element
@@ -6,7 +6,7 @@
 namespace element {
 
 RingBuffer::RingBuffer (int32 capacity)
-    : fifo (1), buffer (nullptr)
+    : fifo (1)
 {
     setCapacity (capacity);
 }
@@ -15,7 +15,6 @@ RingBuffer::~RingBuffer()
 {
     fifo.reset();
     fifo.setTotalSize (1);
-    buffer = nullptr;
     block.free();
 }
 
@@ -29,7 +28,6 @@ void RingBuffer::setCapacity (int32 newCapacity)
         newBlock.allocate (newCapacity, true);
         {
             block.swapWith (newBlock);
-            buffer = block.getData();
             fifo.setTotalSize (newCapacity);
         }
     }
@@ -42,7 +42,9 @@ public:
 
     inline uint32 read (void* dest, uint32 size, bool advance = true)
     {
-        buffer = block.getData();
+        // locals, so a reader and a writer on different threads don't share state.
+        Vec vec1, vec2;
+        auto* const buffer = block.getData();
         fifo.prepareToRead (size, vec1.index, vec1.size, vec2.index, vec2.size);
 
         if (vec1.size > 0)
@@ -70,7 +72,8 @@ public:
 
     inline uint32 write (const void* src, uint32 bytes)
     {
-        buffer = block.getData();
+        Vec vec1, vec2;
+        auto* const buffer = block.getData();
         fifo.prepareToWrite (bytes, vec1.index, vec1.size, vec2.index, vec2.size);
 
         if (vec1.size > 0)
@@ -89,6 +92,56 @@ public:
         return write (&src, sizeof (T));
     }
 
+    /** Write a size prefixed message. The reader sees all of it or nothing.
+        Returns false if there isn't room for it. */
+    inline bool writeMessage (const void* data, uint32 size)
+    {
+        const uint32 total = (uint32) sizeof (uint32) + size;
+        if (! canWrite (total))
+            return false;
+
+        Vec vec1, vec2;
+        auto* const buffer = block.getData();
+        fifo.prepareToWrite ((int) total, vec1.index, vec1.size, vec2.index, vec2.size);
+
+        const auto put = [&] (uint32 offset, const void* src, uint32 bytes) {
+            auto* s = static_cast<const uint8*> (src);
+            if (offset < (uint32) vec1.size)
+            {
+                const auto n = juce::jmin (bytes, (uint32) vec1.size - offset);
+                memcpy (buffer + vec1.index + offset, s, n);
+                s += n;
+                bytes -= n;
+                offset += n;
+            }
+            if (bytes > 0)
+                memcpy (buffer + vec2.index + (offset - (uint32) vec1.size), s, bytes);
+        };
+
+        put (0, &size, sizeof (size));
+        put (sizeof (size), data, size);
+        fifo.finishedWrite ((int) total);
+        return true;
+    }
+
+    /** Read a message written with writeMessage. Returns its size, or zero
+        if none is ready. Messages bigger than capacity are dropped. */
+    inline uint32 readMessage (void* dest, uint32 capacity)
+    {
+        uint32 size = 0;
+        if (getReadSpace() < sizeof (size) || peak (&size, sizeof (size)) < sizeof (size))
+            return 0;
+        if (size == 0 || size > capacity)
+        {
+            jassert (size == 0);
+            fifo.finishedRead ((int) juce::jmin ((uint32) sizeof (size) + size, getReadSpace()));
+            return 0;
+        }
+
+        fifo.finishedRead ((int) sizeof (size));
+        return read (dest, size);
+    }
+
     struct Vector
     {
         uint32 size;
@@ -102,10 +155,8 @@ private:
         int32 index;
     };
 
-    Vec vec1, vec2;
     juce::AbstractFifo fifo;
     juce::HeapBlock<uint8> block;
-    uint8* buffer;
 };
 
 } // namespace element
@@ -49,9 +49,11 @@ extern int luaopen_el_Range (lua_State*);
 extern int luaopen_el_Rectangle (lua_State*);
 extern int luaopen_el_Slider (lua_State*);
 extern int luaopen_el_MidiPipe (lua_State*);
+extern int luaopen_el_AudioEngine (lua_State*);
 extern int luaopen_el_Commands (lua_State*);
 extern int luaopen_el_Context (lua_State*);
 extern int luaopen_el_Node (lua_State*);
+extern int luaopen_el_PluginManager (lua_State*);
 extern int luaopen_el_Session (lua_State*);
 extern int luaopen_el_View (lua_State*);
 extern int luaopen_el_Graph (lua_State*);
@@ -274,6 +276,10 @@ static int searchInternalModules (lua_State* L)
         sol::stack::push (L, load_el_color);
     }
 
+    else if (mod == "el.AudioEngine")
+    {
+        sol::stack::push (L, luaopen_el_AudioEngine);
+    }
     else if (mod == "el.Commands")
     {
         sol::stack::push (L, luaopen_el_Commands);
@@ -290,6 +296,10 @@ static int searchInternalModules (lua_State* L)
     {
         sol::stack::push (L, luaopen_el_Node);
     }
+    else if (mod == "el.PluginManager")
+    {
+        sol::stack::push (L, luaopen_el_PluginManager);
+    }
     else if (mod == "el.Session")
     {
         sol::stack::push (L, luaopen_el_Session);
@@ -0,0 +1,185 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "sol/sol.hpp"
+
+#include "scripting/luaallocator.hpp"
+
+using namespace juce;
+
+namespace element {
+
+LuaAllocator::LuaAllocator (size_t size)
+    : arenaSize (size)
+{
+    arena.allocate (arenaSize, false);
+}
+
+LuaAllocator::~LuaAllocator() {}
+
+int LuaAllocator::classFor (size_t size) noexcept
+{
+    if (size > ((size_t) 1 << maxClassShift))
+        return -1;
+    int shift = minClassShift;
+    while (((size_t) 1 << shift) < size)
+        ++shift;
+    return shift - minClassShift;
+}
+
+bool LuaAllocator::inArena (const void* ptr) const noexcept
+{
+    auto p = static_cast<const char*> (ptr);
+    return p >= arena.get() && p < arena.get() + arenaSize;
+}
+
+void* LuaAllocator::allocate (size_t size) noexcept
+{
+    void* block = nullptr;
+    const int index = classFor (size);
+
+    if (index >= 0)
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        if (auto* head = freeLists[index])
+        {
+            freeLists[index] = *static_cast<void**> (head);
+            block = head;
+        }
+        else
+        {
+            const size_t classSize = (size_t) 1 << (index + minClassShift);
+            if (arenaUsed + classSize <= arenaSize)
+            {
+                block = arena.get() + arenaUsed;
+                arenaUsed += classSize;
+                arenaUsedAtomic.store (arenaUsed);
+            }
+        }
+    }
+
+    if (block == nullptr)
+    {
+        block = std::malloc (size);
+        if (block == nullptr)
+            return nullptr;
+        fallbacks.fetch_add (1);
+    }
+
+    allocatedSinceCycle.fetch_add (size);
+    const auto inUse = bytesInUse.fetch_add (size) + size;
+    if (inUse > peakBytesInUse.load())
+        peakBytesInUse.store (inUse);
+    return block;
+}
+
+void LuaAllocator::release (void* ptr, size_t size) noexcept
+{
+    bytesInUse.fetch_sub (jmin (size, bytesInUse.load()));
+
+    if (! inArena (ptr))
+    {
+        std::free (ptr);
+        return;
+    }
+
+    // Lua reports the size it asked for, so the class can only be equal to or
+    // smaller than the block's real one.
+    const int index = classFor (size);
+    jassert (index >= 0);
+    const SpinLock::ScopedLockType sl (lock);
+    *static_cast<void**> (ptr) = freeLists[index];
+    freeLists[index] = ptr;
+}
+
+void* LuaAllocator::reallocate (void* ptr, size_t osize, size_t nsize) noexcept
+{
+    if (inArena (ptr) && classFor (osize) == classFor (nsize))
+    {
+        bytesInUse.fetch_sub (jmin (osize, bytesInUse.load()));
+        bytesInUse.fetch_add (nsize);
+        return ptr;
+    }
+
+    auto* block = allocate (nsize);
+    if (block == nullptr)
+    {
+        // Lua expects shrinking to always succeed. The old block is big
+        // enough, and freeing it later with the smaller size is harmless.
+        return nsize <= osize ? ptr : nullptr;
+    }
+
+    std::memcpy (block, ptr, jmin (osize, nsize));
+    release (ptr, osize);
+    return block;
+}
+
+void* LuaAllocator::alloc (void* ud, void* ptr, size_t osize, size_t nsize) noexcept
+{
+    auto& self = *static_cast<LuaAllocator*> (ud);
+
+    if (nsize == 0)
+    {
+        if (ptr != nullptr)
+            self.release (ptr, osize);
+        return nullptr;
+    }
+
+    // osize holds the object type when ptr is null.
+    return ptr == nullptr ? self.allocate (nsize)
+                          : self.reallocate (ptr, osize, nsize);
+}
+
+void LuaAllocator::attach (lua_State* L)
+{
+    lua_gc (L, LUA_GCSTOP);
+    allocatedSinceCycle.store (0);
+    collecting = false;
+}
+
+void LuaAllocator::step (lua_State* L) noexcept
+{
+    if (! collecting && allocatedSinceCycle.load() < collectThreshold)
+        return;
+
+    collecting = true;
+    const auto budget = stepBudgetMicros.load();
+    const auto start = Time::getHighResolutionTicks();
+    double elapsed = 0.0;
+
+    do
+    {
+        gcSteps.fetch_add (1);
+        if (lua_gc (L, LUA_GCSTEP, 0) != 0)
+        {
+            collecting = false;
+            allocatedSinceCycle.store (0);
+            gcCycles.fetch_add (1);
+            break;
+        }
+
+        elapsed = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start) * 1000000.0;
+    } while (elapsed < budget);
+
+    elapsed = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start) * 1000000.0;
+    gcLastMicros.store (elapsed);
+    if (elapsed > gcMaxMicros.load())
+        gcMaxMicros.store (elapsed);
+}
+
+LuaAllocator::Stats LuaAllocator::getStats() const noexcept
+{
+    Stats stats;
+    stats.arenaSize = arenaSize;
+    stats.arenaUsed = arenaUsedAtomic.load();
+    stats.bytesInUse = bytesInUse.load();
+    stats.peakBytesInUse = peakBytesInUse.load();
+    stats.fallbacks = fallbacks.load();
+    stats.gcSteps = gcSteps.load();
+    stats.gcCycles = gcCycles.load();
+    stats.gcLastMicros = gcLastMicros.load();
+    stats.gcMaxMicros = gcMaxMicros.load();
+    return stats;
+}
+
+} // namespace element
@@ -0,0 +1,93 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/core.hpp>
+
+struct lua_State;
+
+namespace element {
+
+/** A lua_Alloc for states that run on the audio thread.
+
+    Blocks are served from size classes carved out of one preallocated arena,
+    so allocating while rendering doesn't call into the system allocator.
+    Blocks bigger than the largest class, or allocated after the arena is
+    used up, fall back to malloc and are counted in the stats.
+
+    The allocator also paces garbage collection. Once attached to a state,
+    Lua's own collector is stopped and step() runs incremental steps with a
+    time budget instead.
+*/
+class LuaAllocator final
+{
+public:
+    static constexpr size_t defaultArenaSize = 2 * 1024 * 1024;
+
+    explicit LuaAllocator (size_t arenaSize = defaultArenaSize);
+    ~LuaAllocator();
+
+    /** The lua_Alloc function. Pass the allocator as the user data. */
+    static void* alloc (void* ud, void* ptr, size_t osize, size_t nsize) noexcept;
+
+    /** Take over garbage collection of a state using this allocator. */
+    void attach (lua_State* L);
+
+    /** Run incremental GC steps until the budget runs out or the cycle ends.
+        Does nothing while little has been allocated since the last cycle.
+        Call this at the end of each block, from the thread using the state.
+     */
+    void step (lua_State* L) noexcept;
+
+    /** Set the time step() may spend collecting. */
+    void setStepBudget (double microseconds) noexcept { stepBudgetMicros.store (microseconds); }
+
+    struct Stats
+    {
+        size_t arenaSize = 0; ///< Size of the preallocated arena.
+        size_t arenaUsed = 0; ///< Bytes of the arena handed to size classes.
+        size_t bytesInUse = 0; ///< Bytes currently allocated by Lua.
+        size_t peakBytesInUse = 0; ///< Highest bytesInUse seen.
+        juce::int64 fallbacks = 0; ///< Allocations that had to use malloc.
+        juce::int64 gcSteps = 0; ///< Incremental steps run by step().
+        juce::int64 gcCycles = 0; ///< Collection cycles finished by step().
+        double gcLastMicros = 0.0; ///< Time spent in the last step() that collected.
+        double gcMaxMicros = 0.0; ///< Longest time spent in a single step().
+    };
+
+    /** Returns a snapshot of the statistics. Safe to call from any thread. */
+    Stats getStats() const noexcept;
+
+private:
+    static constexpr int minClassShift = 4; // 16 bytes
+    static constexpr int maxClassShift = 16; // 64 KB
+    static constexpr int numClasses = maxClassShift - minClassShift + 1;
+    static constexpr size_t collectThreshold = 64 * 1024;
+
+    juce::HeapBlock<char> arena;
+    const size_t arenaSize;
+    size_t arenaUsed = 0;
+    void* freeLists[numClasses] {};
+    juce::SpinLock lock;
+
+    std::atomic<size_t> bytesInUse { 0 }, peakBytesInUse { 0 }, arenaUsedAtomic { 0 };
+    std::atomic<juce::int64> fallbacks { 0 }, gcSteps { 0 }, gcCycles { 0 };
+    std::atomic<double> gcLastMicros { 0.0 }, gcMaxMicros { 0.0 };
+    std::atomic<double> stepBudgetMicros { 100.0 };
+
+    std::atomic<size_t> allocatedSinceCycle { 0 };
+    bool collecting = false;
+
+    static int classFor (size_t size) noexcept;
+    bool inArena (const void* ptr) const noexcept;
+    void* allocate (size_t size) noexcept;
+    void release (void* ptr, size_t size) noexcept;
+    void* reallocate (void* ptr, size_t osize, size_t nsize) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LuaAllocator)
+};
+
+} // namespace element
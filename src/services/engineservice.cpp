@@ -12,6 +12,7 @@
 #include <element/settings.hpp>
 
 #include "engine/graphmanager.hpp"
+#include "services/sessionservice.hpp"
 #include "nodes/mididevice.hpp"
 #include "engine/rootgraph.hpp"
 #include <element/engine.hpp>
@@ -47,6 +48,8 @@ struct RootGraphHolder
     ~RootGraphHolder()
     {
         jassert (! attached());
+        loadingNode.disconnect();
+        loadingGraph.disconnect();
         controller = nullptr;
         model.data().removeProperty (tags::object, 0);
         node = nullptr;
@@ -59,7 +62,9 @@ struct RootGraphHolder
         done already. Properties are set from the model, so make sure they are
         correct before calling this 
      */
-    bool attach (AudioEnginePtr engine)
+    bool attach (AudioEnginePtr engine,
+                 std::function<void (const Node&)> nodeLoaded = nullptr,
+                 std::function<void()> graphLoaded = nullptr)
     {
         jassert (engine);
         if (! engine)
@@ -95,6 +100,14 @@ struct RootGraphHolder
             {
                 controller = std::make_unique<RootGraphManager> (*root, plugins);
                 model.setProperty (tags::object, node.get());
+                if (nodeLoaded)
+                    loadingNode = controller->sigNodeLoaded.connect (nodeLoaded);
+                loadingGraph = controller->sigLoaded.connect ([this, graphLoaded]() {
+                    loadingNode.disconnect();
+                    loadingGraph.disconnect();
+                    if (graphLoaded)
+                        graphLoaded();
+                });
 
                 controller->setNodeModel (model);
             }
@@ -121,6 +134,8 @@ struct RootGraphHolder
 
         if (wasRemoved)
         {
+            loadingNode.disconnect();
+            loadingGraph.disconnect();
             controller = nullptr;
             node = nullptr;
         }
@@ -141,6 +156,7 @@ private:
     std::unique_ptr<RootGraphManager> controller;
     Node model;
     ProcessorPtr node;
+    SignalConnection loadingNode, loadingGraph;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RootGraphHolder);
 };
@@ -804,7 +820,7 @@ void EngineService::setRootNode (const Node& newRootNode)
 
     if (auto* const r = holder->getController())
     {
-        if (! r->isLoaded())
+        if (! r->isLoaded() && ! r->isLoading())
         {
             r->getRootGraph().setPlayConfigFor (devices);
             r->setNodeModel (newRootNode);
@@ -912,14 +928,45 @@ void EngineService::sessionReloaded()
     auto session = context().session();
     auto engine = context().audio();
 
+    // graphs load asynchronously, so this outlives the call.
+    struct Progress
+    {
+        int numNodes = 0, numLoaded = 0, numGraphs = 0;
+    };
+    auto progress = std::make_shared<Progress>();
+
     if (session->getNumGraphs() > 0)
     {
+        auto* const sessions = sibling<SessionService>();
+        for (int i = 0; i < session->getNumGraphs(); ++i)
+        {
+            session->getGraph (i).forEach ([&progress] (const ValueTree& tree) {
+                if (tree.hasType (types::Node) && tree.getParent().hasType (tags::nodes))
+                    ++progress->numNodes;
+            });
+        }
+
+        const auto nodeLoaded = [sessions, progress] (const Node&) {
+            // IO nodes added while loading aren't in the count.
+            if (sessions != nullptr && progress->numLoaded < progress->numNodes)
+                sessions->sigLoadProgress (++progress->numLoaded, progress->numNodes);
+        };
+
+        const auto graphLoaded = [this, progress]() {
+            if (--progress->numGraphs == 0)
+                sigGraphsLoaded();
+        };
+
         for (int i = 0; i < session->getNumGraphs(); ++i)
         {
             Node rootGraph (session->getGraph (i));
             if (auto* holder = graphs->add (new RootGraphHolder (rootGraph, context())))
             {
-                if (! holder->attach (engine))
+                if (holder->attach (engine, nodeLoaded, graphLoaded))
+                {
+                    ++progress->numGraphs;
+                }
+                else
                 {
                     std::clog << "[element] failed attaching root grapn: " << holder->model.getName() << std::endl;
                 }
@@ -943,6 +990,9 @@ void EngineService::sessionReloaded()
     {
         DBG ("[element] session reloaded: " << session->getName());
     }
+
+    if (progress->numGraphs == 0)
+        sigGraphsLoaded();
 }
 
 Node EngineService::addPlugin (GraphManager& c, const PluginDescription& desc)
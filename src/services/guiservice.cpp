@@ -982,7 +982,7 @@ bool GuiService::perform (const InvocationInfo& info)
             break;
         }
         case Commands::sessionSave:
-            sibling<SessionService>()->saveSession (false);
+            sibling<SessionService>()->saveSessionAsync();
             break;
         case Commands::sessionSaveAs:
             sibling<SessionService>()->saveSession (true);
@@ -14,6 +14,7 @@
 #include "services/mappingservice.hpp"
 #include "services/presetservice.hpp"
 #include "services/sessionservice.hpp"
+#include "sessionarchive.hpp"
 
 namespace element {
 
@@ -27,12 +28,199 @@ public:
     {
         owner.resetChanges (false);
         jassert (! owner.hasSessionChanged());
+
+        // recovered changes still need saving.
+        if (keepChanged)
+            owner.document->changed();
+    }
+
+    /** Set when the open session was recovered from an autosave. */
+    bool keepChanged = false;
+
+private:
+    SessionService& owner;
+};
+
+//==============================================================================
+/** Gathers plugin state in small slices on the message thread, then writes a
+    snapshot of the session on a background thread. Autosaves write to the
+    session's backup file and leave the document changed. */
+class SessionService::AsyncSaver : private Timer,
+                                   private AsyncUpdater
+{
+public:
+    explicit AsyncSaver (SessionService& sc) : owner (sc) {}
+
+    ~AsyncSaver()
+    {
+        cancel();
+        writer.removeAllJobs (false, -1);
+        cancelPendingUpdate();
+    }
+
+    bool isBusy() const noexcept { return isTimerRunning() || writing.load(); }
+
+    /** Start saving. If a write is still running, saving starts again
+        when it is done. */
+    void start (SessionPtr s, const File& f, bool isAutosave)
+    {
+        if (isTimerRunning())
+            return;
+
+        session = s;
+        file = f;
+        autosave = isAutosave;
+
+        if (writing.load())
+        {
+            restart = true;
+            return;
+        }
+
+        nodes.clearQuick();
+        for (int i = 0; i < session->getNumGraphs(); ++i)
+            collect (session->getGraph (i));
+
+        nextNode = 0;
+        startTimer (1);
+    }
+
+    /** Stop gathering and wait for a write in progress to finish. */
+    void flush()
+    {
+        cancel();
+        writer.removeAllJobs (false, -1);
+    }
+
+    void cancel()
+    {
+        stopTimer();
+        restart = false;
+        nodes.clearQuick();
     }
 
 private:
     SessionService& owner;
+    SessionPtr session;
+    File file;
+    bool autosave = false, restart = false;
+
+    Array<Node> nodes;
+    int nextNode = 0;
+    // Nodes whose state took too long. Autosaves keep their last saved
+    // state instead of stalling the message thread again.
+    StringArray slowNodes;
+
+    ThreadPool writer { 1 };
+    std::atomic<bool> writing { false };
+    CriticalSection lock;
+    Result result { Result::ok() };
+
+    static constexpr double sliceMs = 8.0;
+    static constexpr double nodeBudgetMs = 100.0;
+
+    void collect (const Node& node)
+    {
+        nodes.add (node);
+        for (int i = 0; i < node.getNumNodes(); ++i)
+            collect (node.getNode (i));
+    }
+
+    void timerCallback() override
+    {
+        const auto sliceStart = Time::getMillisecondCounterHiRes();
+        while (nextNode < nodes.size())
+        {
+            auto node = nodes.getReference (nextNode++);
+            const auto uuid = node.getUuidString();
+            if (autosave && slowNodes.contains (uuid))
+                continue;
+
+            const auto started = Time::getMillisecondCounterHiRes();
+            node.savePluginState (false);
+            const auto elapsed = Time::getMillisecondCounterHiRes() - started;
+
+            if (elapsed > nodeBudgetMs)
+            {
+                slowNodes.addIfNotAlreadyThere (uuid);
+                std::clog << "[element] " << node.getName() << " took " << roundToInt (elapsed)
+                          << "ms to save state. Autosave will skip it." << std::endl;
+            }
+            else if (! autosave)
+            {
+                slowNodes.removeString (uuid);
+            }
+
+            if (Time::getMillisecondCounterHiRes() - sliceStart >= sliceMs)
+                return;
+        }
+
+        stopTimer();
+        nodes.clearQuick();
+
+        owner.prepareForSave();
+        session->dispatchPendingMessages();
+        if (owner.document != nullptr && ! autosave)
+            owner.document->setChangedFlag (false);
+
+        ValueTree snapshot = session->getValueTree().createCopy();
+        Node::sanitizeProperties (snapshot, true);
+
+        writing.store (true);
+        writer.addJob ([this, snapshot, target = file]() {
+            auto res = SessionArchive::write (snapshot, target);
+            {
+                const ScopedLock sl (lock);
+                result = res;
+            }
+            triggerAsyncUpdate();
+        });
+    }
+
+    void handleAsyncUpdate() override
+    {
+        Result res (Result::ok());
+        {
+            const ScopedLock sl (lock);
+            res = result;
+        }
+
+        writing.store (false);
+        owner.saveFinished (file, res, autosave);
+
+        if (restart)
+        {
+            restart = false;
+            start (session, file, autosave);
+        }
+    }
 };
 
+//==============================================================================
+class SessionService::Autosave : public Timer
+{
+public:
+    explicit Autosave (SessionService& sc) : owner (sc) { startTimer (10 * 1000); }
+
+    void timerCallback() override
+    {
+        const int minutes = owner.context().settings().getAutosaveInterval();
+        if (minutes <= 0 || owner.isSaving() || ! owner.hasSessionChanged())
+            return;
+
+        const auto file = owner.getSessionFile();
+        if (! file.existsAsFile())
+            return;
+
+        if (Time::getCurrentTime() - owner.lastSaveTime >= RelativeTime::minutes (minutes))
+            owner.saver->start (owner.currentSession, getBackupFile (file), true);
+    }
+
+private:
+    SessionService& owner;
+};
+
+//==============================================================================
 SessionService::SessionService() {}
 SessionService::~SessionService() {}
 
@@ -41,11 +229,20 @@ void SessionService::activate()
     currentSession = context().session();
     document.reset (new SessionDocument (currentSession));
     changeResetter.reset (new ChangeResetter (*this));
+    saver.reset (new AsyncSaver (*this));
+    autosave.reset (new Autosave (*this));
+    lastSaveTime = Time::getCurrentTime();
     document->setFile (DataPath::defaultSessionDir());
 }
 
 void SessionService::deactivate()
 {
+    graphsLoaded.disconnect();
+    autosave.reset();
+    if (saver)
+        saver->flush();
+    saver.reset();
+
     auto& world = context();
     auto& settings (world.settings());
     auto* props = settings.getUserSettings();
@@ -54,6 +251,8 @@ void SessionService::deactivate()
     {
         if (document->getFile().existsAsFile())
             props->setValue (Settings::lastSessionKey, document->getFile().getFullPathName());
+        if (! document->hasChangedSinceSaved())
+            getBackupFile (document->getFile()).deleteFile();
         document = nullptr;
     }
 
@@ -66,9 +265,11 @@ void SessionService::deactivate()
 
 void SessionService::openDefaultSession()
 {
+    saver->flush();
     if (auto* gc = sibling<GuiService>())
         gc->closeAllPluginWindows();
 
+    changeResetter->keepChanged = false;
     loadNewSessionData();
     refreshOtherControllers();
     sibling<GuiService>()->stabilizeContent();
@@ -117,12 +318,32 @@ void SessionService::openFile (const File& file)
     }
     else if (file.hasFileExtension ("els"))
     {
+        saver->flush();
         document->saveIfNeededAndUserAgrees();
+
+        // an autosave newer than the file means the last run didn't save.
+        const auto backup = getBackupFile (file);
+        bool recover = false;
+        if (backup.existsAsFile() && backup.getLastModificationTime() > file.getLastModificationTime())
+        {
+            recover = AlertWindow::showOkCancelBox (AlertWindow::QuestionIcon,
+                                                    "Recover Session?",
+                                                    file.getFileName() + " has autosaved changes that were never saved. Would you like to recover them?",
+                                                    "Recover",
+                                                    "Discard");
+            if (! recover)
+                backup.deleteFile();
+        }
+
         Session::ScopedFrozenLock freeze (*currentSession);
-        Result result = document->loadFrom (file, true);
+        Result result = document->loadFrom (recover ? backup : file, true);
 
         if (result.wasOk())
         {
+            changeResetter->keepChanged = recover;
+            if (recover)
+                document->setFile (file);
+
             auto& gui = *sibling<GuiService>();
             gui.closeAllPluginWindows();
             refreshOtherControllers();
@@ -189,17 +410,10 @@ void SessionService::saveSession (const bool saveAs, const bool askForFile, cons
     jassert (document && currentSession);
     auto result = FileBasedDocument::userCancelledSave;
 
-    auto& gui = *sibling<GuiService>();
-
-    if (auto* cc = gui.content())
-    {
-        String state;
-        cc->getSessionState (state);
-        auto ui = currentSession->data().getOrCreateChildWithName (tags::ui, nullptr);
-        ui.setProperty ("content", state, nullptr);
-    }
-
-    sigWillSave();
+    // don't race a background save writing the same file.
+    saver->flush();
+    prepareForSave();
+    const auto previousFile = document->getFile();
 
     if (saveAs)
     {
@@ -219,6 +433,9 @@ void SessionService::saveSession (const bool saveAs, const bool askForFile, cons
         currentSession->dispatchPendingMessages();
         document->setChangedFlag (false);
         jassert (! hasSessionChanged());
+        lastSaveTime = Time::getCurrentTime();
+        getBackupFile (previousFile).deleteFile();
+        getBackupFile (document->getFile()).deleteFile();
         if (auto* us = context().settings().getUserSettings())
             us->setValue (Settings::lastSessionKey, document->getFile().getFullPathName());
 
@@ -232,6 +449,75 @@ void SessionService::saveSession (const bool saveAs, const bool askForFile, cons
     }
 }
 
+void SessionService::saveSessionAsync()
+{
+    jassert (document && currentSession);
+    const auto file = document->getFile();
+    if (! file.existsAsFile())
+    {
+        saveSession (false);
+        return;
+    }
+
+    saver->start (currentSession, file, false);
+}
+
+File SessionService::getBackupFile (const File& sessionFile)
+{
+    return sessionFile.getSiblingFile (sessionFile.getFileName() + ".autosave");
+}
+
+bool SessionService::isSaving() const
+{
+    return saver != nullptr && saver->isBusy();
+}
+
+void SessionService::prepareForSave()
+{
+    if (auto* gui = sibling<GuiService>())
+    {
+        if (auto* cc = gui->content())
+        {
+            String state;
+            cc->getSessionState (state);
+            auto ui = currentSession->data().getOrCreateChildWithName (tags::ui, nullptr);
+            ui.setProperty ("content", state, nullptr);
+        }
+    }
+
+    sigWillSave();
+}
+
+void SessionService::saveFinished (const File& file, const Result& result, bool autosave)
+{
+    if (autosave)
+    {
+        // the session itself wasn't saved, so nothing else changes.
+        if (result.wasOk())
+            lastSaveTime = Time::getCurrentTime();
+        else
+            std::clog << "[element] autosave failed: " << result.getErrorMessage() << std::endl;
+        return;
+    }
+
+    if (result.wasOk())
+    {
+        getBackupFile (file).deleteFile();
+        // changes made while writing still mark the document as changed.
+        lastSaveTime = Time::getCurrentTime();
+        if (auto* us = context().settings().getUserSettings())
+            us->setValue (Settings::lastSessionKey, file.getFullPathName());
+    }
+    else
+    {
+        std::clog << "[element] background save failed: " << result.getErrorMessage() << std::endl;
+        if (document != nullptr)
+            document->changed();
+    }
+
+    sigSaved (file, result);
+}
+
 void SessionService::newSession()
 {
     jassert (document && currentSession);
@@ -249,9 +535,14 @@ void SessionService::newSession()
     if (res == 1)
         document->save (true, true);
 
+    if (res == 2)
+        getBackupFile (document->getFile()).deleteFile();
+
     if (res == 1 || res == 2)
     {
+        saver->flush();
         sibling<GuiService>()->closeAllPluginWindows();
+        changeResetter->keepChanged = false;
         loadNewSessionData();
         refreshOtherControllers();
         sibling<GuiService>()->stabilizeContent();
@@ -267,9 +558,10 @@ void SessionService::loadNewSessionData()
 
     if (file.existsAsFile())
     {
-        ValueTree data;
-        if (auto xml = XmlDocument::parse (file))
-            data = ValueTree::fromXml (*xml);
+        ValueTree data = Session::readFromFile (file);
+        if (! data.isValid())
+            if (auto xml = XmlDocument::parse (file))
+                data = ValueTree::fromXml (*xml);
         if (data.isValid() && data.hasType (types::Session) && EL_SESSION_VERSION == (int) data.getProperty (tags::version))
             wasLoaded = currentSession->loadData (data);
     }
@@ -289,11 +581,22 @@ void SessionService::loadNewSessionData()
 
 void SessionService::refreshOtherControllers()
 {
-    sibling<EngineService>()->sessionReloaded();
-    sibling<DeviceService>()->refresh();
-    sibling<MappingService>()->learn (false);
-    sibling<PresetService>()->refresh();
-    sigSessionLoaded();
+    auto* const engine = sibling<EngineService>();
+
+    // mappings and presets need the graph nodes, which load asynchronously.
+    graphsLoaded.disconnect();
+    graphsLoaded = engine->sigGraphsLoaded.connect ([this]() {
+        graphsLoaded.disconnect();
+        sibling<DeviceService>()->refresh();
+        sibling<MappingService>()->learn (false);
+        sibling<PresetService>()->refresh();
+        sigSessionLoaded();
+
+        // loading changed the model after it was reset.
+        changeResetter->triggerAsyncUpdate();
+    });
+
+    engine->sessionReloaded();
 }
 
 } // namespace element
@@ -26,6 +26,21 @@ public:
     void saveSession (const bool saveAs = false,
                       const bool askForFile = true,
                       const bool showError = true);
+
+    /** Save the session without blocking the UI. Plugin state is gathered
+        on the message thread a few nodes at a time, then the file is written
+        on a background thread. Falls back to saveSession() when the session
+        hasn't been saved to a file yet.
+     */
+    void saveSessionAsync();
+
+    /** Returns true while a background save is in progress. */
+    bool isSaving() const;
+
+    /** Returns the file autosaves write to for a session file. Opening a
+        session offers to recover it when it is newer than the session. */
+    static File getBackupFile (const File& sessionFile);
+
     void newSession();
     bool hasSessionChanged() { return (document) ? document->hasChangedSinceSaved() : false; }
 
@@ -37,13 +52,28 @@ public:
     Signal<void()> sigSessionLoaded;
     Signal<void()> sigWillSave;
 
+    /** Emitted on the message thread as each node of a session is loaded,
+        with the number loaded so far and the total. */
+    Signal<void (int, int)> sigLoadProgress;
+
+    /** Emitted on the message thread when a background save finishes. */
+    Signal<void (const File&, const Result&)> sigSaved;
+
 private:
     SessionPtr currentSession;
     std::unique_ptr<SessionDocument> document;
     class ChangeResetter;
     std::unique_ptr<ChangeResetter> changeResetter;
+    class AsyncSaver;
+    std::unique_ptr<AsyncSaver> saver;
+    class Autosave;
+    std::unique_ptr<Autosave> autosave;
+    SignalConnection graphsLoaded;
+    Time lastSaveTime;
 
     void loadNewSessionData();
+    void prepareForSave();
+    void saveFinished (const File& file, const Result& result, bool autosave);
     void refreshOtherControllers();
 };
 
@@ -7,6 +7,7 @@
 #include <element/session.hpp>
 
 #include <element/context.hpp>
+#include "sessionarchive.hpp"
 #include "tempo.hpp"
 
 namespace element {
@@ -287,23 +288,18 @@ bool Session::writeToFile (const File& file) const
 {
     ValueTree saveData = objectData.createCopy();
     Node::sanitizeProperties (saveData, true);
-    TemporaryFile tempFile (file);
-
-    if (auto fos = tempFile.getFile().createOutputStream())
-    {
-        {
-            GZIPCompressorOutputStream gzip (*fos, 9);
-            saveData.writeToStream (gzip);
-        }
-        fos.reset();
-        return tempFile.overwriteTargetFileWithTemporary();
-    }
-
-    return false;
+    const auto result = SessionArchive::write (saveData, file);
+    if (result.failed())
+        std::clog << "[element] " << result.getErrorMessage() << ": " << file.getFullPathName() << std::endl;
+    return result.wasOk();
 }
 
 ValueTree Session::readFromFile (const File& file)
 {
+    if (SessionArchive::isArchive (file))
+        return SessionArchive::read (file);
+
+    // older gzipped value trees
     ValueTree data;
     FileInputStream fi (file);
 
@@ -0,0 +1,534 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "ElementApp.h"
+#include "sessionarchive.hpp"
+
+namespace element {
+namespace detail {
+
+// File layout, all integers little endian:
+//
+//   header   "ELAR" version:u32
+//   chunk    "CHNK" codec:u32 keyA:u64 keyB:u64 rawSize:u64 storedSize:u64 data
+//   trailer  "ELIX" reserved:u32 indexOffset:u64
+//
+// The index is itself a raw chunk that sits right before its trailer. It
+// holds the structure chunk's key followed by (keyA, keyB, offset) entries.
+// Saves append new chunks, index and trailer, so the last trailer in the
+// file always describes the current session.
+
+static constexpr int archiveVersion = 1;
+static constexpr int headerSize = 8;
+static constexpr int chunkHeaderSize = 40;
+static constexpr int trailerSize = 16;
+static constexpr int compressionLevel = 1;
+static constexpr int64 minCompactSize = 1024 * 1024;
+
+enum Codec : uint32
+{
+    codecRaw = 0,
+    codecZlib = 1
+};
+
+static const char* const archiveMagic = "ELAR";
+static const char* const chunkMagic = "CHNK";
+static const char* const trailerMagic = "ELIX";
+static const String chunkRefPrefix ("chunk:");
+
+//==============================================================================
+struct ChunkKey
+{
+    uint64 a = 0, b = 0;
+    String toString() const { return String::toHexString ((int64) a).paddedLeft ('0', 16) + String::toHexString ((int64) b).paddedLeft ('0', 16); }
+};
+
+static inline uint64 rotl (uint64 x, int r) noexcept { return (x << r) | (x >> (64 - r)); }
+
+static inline uint64 avalanche (uint64 x) noexcept
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+/** Two independent 64 bit lanes over 8 byte words. Not cryptographic, but
+    plenty to tell state blobs apart. */
+static ChunkKey hashContent (const void* data, size_t size) noexcept
+{
+    constexpr uint64 fnvPrime = 0x100000001b3ull;
+    constexpr uint64 p1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64 p2 = 0xC2B2AE3D27D4EB4Full;
+
+    uint64 a = 0xcbf29ce484222325ull ^ (uint64) size;
+    uint64 b = p1 ^ ((uint64) size * p2);
+    const auto* bytes = static_cast<const uint8*> (data);
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64 word;
+        std::memcpy (&word, bytes + i, 8);
+        word = ByteOrder::swapIfBigEndian (word);
+        a = (a ^ word) * fnvPrime;
+        b = rotl (b + word * p2, 31) * p1;
+    }
+
+    uint64 tail = 0;
+    for (int shift = 0; i < size; ++i, shift += 8)
+        tail |= (uint64) bytes[i] << shift;
+    a = (a ^ tail) * fnvPrime;
+    b = rotl (b + tail * p2, 31) * p1;
+
+    return { avalanche (a), avalanche (b ^ a) };
+}
+
+static inline uint64 readU64 (const char* p) noexcept { return ByteOrder::littleEndianInt64 (p); }
+static inline uint32 readU32 (const char* p) noexcept { return ByteOrder::littleEndianInt (p); }
+
+/** Inflate stored chunk bytes and check them against the chunk's key. */
+static bool decodeChunk (uint32 codec, const ChunkKey& key, const void* stored, uint64 storedSize, uint64 rawSize, MemoryBlock& block)
+{
+    if (codec == codecRaw)
+    {
+        if (storedSize != rawSize)
+            return false;
+        block.replaceAll (stored, (size_t) storedSize);
+    }
+    else if (codec == codecZlib)
+    {
+        MemoryInputStream mi (stored, (size_t) storedSize, false);
+        GZIPDecompressorInputStream gz (mi);
+        block.setSize ((size_t) rawSize, false);
+        if (gz.read (block.getData(), (int) rawSize) != (int) rawSize)
+            return false;
+    }
+    else
+    {
+        return false;
+    }
+
+    const auto check = hashContent (block.getData(), block.getSize());
+    return check.a == key.a && check.b == key.b;
+}
+
+//==============================================================================
+/** Maps an existing archive and decodes its chunks on request. */
+class Reader
+{
+public:
+    bool open (const File& file)
+    {
+        map = std::make_unique<MemoryMappedFile> (file, MemoryMappedFile::readOnly);
+        if (map->getData() != nullptr)
+        {
+            data = static_cast<const char*> (map->getData());
+            size = (int64) map->getSize();
+        }
+        else
+        {
+            map.reset();
+            if (! file.loadFileAsData (fallback))
+                return false;
+            data = static_cast<const char*> (fallback.getData());
+            size = (int64) fallback.getSize();
+        }
+
+        if (size < headerSize + trailerSize || std::memcmp (data, archiveMagic, 4) != 0)
+            return false;
+        if ((int) readU32 (data + 4) > archiveVersion)
+            return false;
+
+        // The last trailer is normally at the very end. If a save was cut
+        // short, fall back to the newest complete one.
+        for (int64 pos = size - trailerSize; pos >= headerSize; --pos)
+            if (std::memcmp (data + pos, trailerMagic, 4) == 0 && readIndex (pos))
+                return true;
+
+        return false;
+    }
+
+    void close()
+    {
+        map.reset();
+        fallback.reset();
+        data = nullptr;
+        size = 0;
+    }
+
+    int64 getSize() const noexcept { return size; }
+    const ChunkKey& getRootKey() const noexcept { return root; }
+
+    /** Returns the offset of a chunk, or -1 if not in the index. */
+    int64 find (const String& key) const { return offsets.contains (key) ? offsets[key] : -1; }
+
+    /** Returns the number of bytes a chunk occupies in the file. */
+    int64 getExtent (int64 offset) const noexcept
+    {
+        return chunkHeaderSize + (int64) readU64 (data + offset + 32);
+    }
+
+    /** Checks a chunk's header. Returns its stored bytes, or nullptr if the
+        header is bad. */
+    const char* locate (int64 offset, uint32& codec, ChunkKey& key, uint64& rawSize, uint64& storedSize) const
+    {
+        if (offset < headerSize || offset + chunkHeaderSize > size)
+            return nullptr;
+
+        const char* header = data + offset;
+        if (std::memcmp (header, chunkMagic, 4) != 0)
+            return nullptr;
+
+        codec = readU32 (header + 4);
+        key = { readU64 (header + 8), readU64 (header + 16) };
+        rawSize = readU64 (header + 24);
+        storedSize = readU64 (header + 32);
+
+        if (storedSize > (uint64) (size - offset - chunkHeaderSize)
+            || rawSize > (uint64) std::numeric_limits<int>::max())
+            return nullptr;
+
+        return header + chunkHeaderSize;
+    }
+
+    bool readChunk (int64 offset, MemoryBlock& block) const
+    {
+        uint32 codec;
+        ChunkKey key;
+        uint64 rawSize, storedSize;
+        const char* stored = locate (offset, codec, key, rawSize, storedSize);
+        return stored != nullptr && decodeChunk (codec, key, stored, storedSize, rawSize, block);
+    }
+
+private:
+    std::unique_ptr<MemoryMappedFile> map;
+    MemoryBlock fallback;
+    const char* data = nullptr;
+    int64 size = 0;
+    ChunkKey root;
+    HashMap<String, int64> offsets;
+
+    bool readIndex (int64 trailerPos)
+    {
+        const auto indexOffset = (int64) readU64 (data + trailerPos + 8);
+        if (indexOffset < headerSize || indexOffset + chunkHeaderSize > trailerPos
+            || indexOffset + getExtent (indexOffset) != trailerPos)
+            return false;
+
+        MemoryBlock index;
+        if (! readChunk (indexOffset, index) || index.getSize() < 20)
+            return false;
+
+        const char* p = static_cast<const char*> (index.getData());
+        const auto numEntries = (size_t) readU32 (p);
+        if (index.getSize() != 20 + numEntries * 24)
+            return false;
+
+        root = { readU64 (p + 4), readU64 (p + 12) };
+        offsets.clear();
+        for (size_t i = 0; i < numEntries; ++i)
+        {
+            const char* entry = p + 20 + i * 24;
+            const auto offset = (int64) readU64 (entry + 16);
+            if (offset < headerSize || offset >= indexOffset)
+                return false;
+            offsets.set (ChunkKey { readU64 (entry), readU64 (entry + 8) }.toString(), offset);
+        }
+
+        return true;
+    }
+};
+
+/** Replace a LazyState property with its data, or remove it if the chunk
+    is bad. */
+static void decodeLazyState (ValueTree& tree, const Identifier& property)
+{
+    if (auto* lazy = SessionArchive::LazyState::fromVar (tree.getProperty (property)))
+    {
+        MemoryBlock block;
+        if (lazy->decode (block))
+            tree.setProperty (property, var (block), nullptr);
+        else
+            tree.removeProperty (property, nullptr);
+    }
+}
+
+//==============================================================================
+struct Chunk
+{
+    ChunkKey key;
+    MemoryBlock data;
+    int64 offset = -1;
+};
+
+class Writer
+{
+public:
+    /** Replace state blobs in node trees with references to chunks. */
+    void extract (ValueTree tree)
+    {
+        if (tree.hasType (types::Node))
+        {
+            for (const auto& property : { tags::state, tags::programState })
+            {
+                decodeLazyState (tree, property);
+
+                const auto& value = tree.getProperty (property);
+                MemoryBlock block;
+                if (auto* binary = value.getBinaryData())
+                    block = *binary;
+                else if (value.isString() && ! block.fromBase64Encoding (value.toString()))
+                    continue;
+
+                if (block.getSize() < (size_t) SessionArchive::minChunkSize)
+                    continue;
+
+                const auto key = add (std::move (block));
+                tree.setProperty (property, chunkRefPrefix + key.toString(), nullptr);
+            }
+        }
+
+        for (int i = 0; i < tree.getNumChildren(); ++i)
+            extract (tree.getChild (i));
+    }
+
+    ChunkKey add (MemoryBlock&& block)
+    {
+        const auto key = hashContent (block.getData(), block.getSize());
+        const auto hex = key.toString();
+        if (! lookup.contains (hex))
+        {
+            auto* chunk = chunks.add (new Chunk());
+            chunk->key = key;
+            chunk->data = std::move (block);
+            lookup.set (hex, chunk);
+        }
+        return key;
+    }
+
+    /** Resolve chunks already stored in an existing archive. Returns the
+        number of bytes they occupy. */
+    int64 reuse (const Reader& reader)
+    {
+        int64 live = 0;
+        for (auto* chunk : chunks)
+        {
+            chunk->offset = reader.find (chunk->key.toString());
+            if (chunk->offset >= 0)
+                live += reader.getExtent (chunk->offset);
+        }
+        return live;
+    }
+
+    void forgetOffsets()
+    {
+        for (auto* chunk : chunks)
+            chunk->offset = -1;
+    }
+
+    /** Write pending chunks, the index and the trailer. */
+    bool writeTo (OutputStream& out, const ChunkKey& root)
+    {
+        for (auto* chunk : chunks)
+        {
+            if (chunk->offset >= 0)
+                continue;
+            chunk->offset = out.getPosition();
+            if (! writeChunk (out, chunk->key, chunk->data.getData(), chunk->data.getSize(), true))
+                return false;
+        }
+
+        MemoryOutputStream index;
+        index.writeInt (chunks.size());
+        index.writeInt64 ((int64) root.a);
+        index.writeInt64 ((int64) root.b);
+        for (auto* chunk : chunks)
+        {
+            index.writeInt64 ((int64) chunk->key.a);
+            index.writeInt64 ((int64) chunk->key.b);
+            index.writeInt64 (chunk->offset);
+        }
+
+        const auto indexOffset = out.getPosition();
+        const auto indexKey = hashContent (index.getData(), index.getDataSize());
+        if (! writeChunk (out, indexKey, index.getData(), index.getDataSize(), false))
+            return false;
+
+        return out.write (trailerMagic, 4)
+               && out.writeInt (0)
+               && out.writeInt64 (indexOffset);
+    }
+
+private:
+    OwnedArray<Chunk> chunks;
+    HashMap<String, Chunk*> lookup;
+
+    static bool writeChunk (OutputStream& out, const ChunkKey& key, const void* data, size_t size, bool compress)
+    {
+        MemoryOutputStream packed;
+        auto codec = codecRaw;
+        if (compress)
+        {
+            {
+                GZIPCompressorOutputStream gz (packed, compressionLevel);
+                gz.write (data, size);
+            }
+
+            if (packed.getDataSize() < size)
+                codec = codecZlib;
+        }
+
+        const void* stored = codec == codecZlib ? packed.getData() : data;
+        const auto storedSize = codec == codecZlib ? packed.getDataSize() : size;
+
+        return out.write (chunkMagic, 4)
+               && out.writeInt ((int) codec)
+               && out.writeInt64 ((int64) key.a)
+               && out.writeInt64 ((int64) key.b)
+               && out.writeInt64 ((int64) size)
+               && out.writeInt64 ((int64) storedSize)
+               && out.write (stored, storedSize);
+    }
+};
+
+static void resolveChunks (ValueTree tree, const Reader& reader)
+{
+    if (tree.hasType (types::Node))
+    {
+        for (const auto& property : { tags::state, tags::programState })
+        {
+            const auto& value = tree.getProperty (property);
+            if (! value.isString() || ! value.toString().startsWith (chunkRefPrefix))
+                continue;
+
+            uint32 codec;
+            ChunkKey key;
+            uint64 rawSize, storedSize;
+            const auto offset = reader.find (value.toString().substring (chunkRefPrefix.length()));
+            const char* stored = offset >= 0 ? reader.locate (offset, codec, key, rawSize, storedSize) : nullptr;
+            if (stored != nullptr)
+            {
+                // copied out compressed, the node inflates it when it restores.
+                tree.setProperty (property, new SessionArchive::LazyState (codec, key.a, key.b, rawSize, stored, (size_t) storedSize), nullptr);
+            }
+            else
+            {
+                std::clog << "[element] session archive: missing chunk for "
+                          << tree.getProperty (tags::name).toString() << std::endl;
+                tree.removeProperty (property, nullptr);
+            }
+        }
+    }
+
+    for (int i = 0; i < tree.getNumChildren(); ++i)
+        resolveChunks (tree.getChild (i), reader);
+}
+
+} // namespace detail
+
+//==============================================================================
+SessionArchive::LazyState::LazyState (uint32 c, uint64 a, uint64 b, uint64 raw, const void* data, size_t dataSize)
+    : codec (c), keyA (a), keyB (b), rawSize (raw), stored (data, dataSize)
+{
+}
+
+bool SessionArchive::LazyState::decode (MemoryBlock& block) const
+{
+    const detail::ChunkKey key { keyA, keyB };
+    if (detail::decodeChunk (codec, key, stored.getData(), (uint64) stored.getSize(), rawSize, block))
+        return true;
+
+    std::clog << "[element] session archive: corrupt state chunk " << key.toString() << std::endl;
+    block.reset();
+    return false;
+}
+
+//==============================================================================
+bool SessionArchive::isArchive (const File& file)
+{
+    FileInputStream in (file);
+    char magic[4] = {};
+    return in.openedOk() && in.read (magic, 4) == 4
+           && std::memcmp (magic, detail::archiveMagic, 4) == 0;
+}
+
+Result SessionArchive::write (ValueTree data, const File& file)
+{
+    if (! data.isValid())
+        return Result::fail ("Invalid session data");
+
+    detail::Writer writer;
+    writer.extract (data);
+
+    MemoryOutputStream structure;
+    data.writeToStream (structure);
+    const auto root = writer.add (structure.getMemoryBlock());
+
+    if (isArchive (file))
+    {
+        detail::Reader reader;
+        if (reader.open (file))
+        {
+            const auto live = writer.reuse (reader);
+            const auto dead = reader.getSize() - detail::headerSize - live;
+            reader.close();
+
+            if (dead < jmax (live, detail::minCompactSize))
+            {
+                FileOutputStream out (file);
+                if (out.openedOk() && writer.writeTo (out, root))
+                {
+                    out.flush();
+                    if (out.getStatus().wasOk())
+                        return Result::ok();
+                }
+
+                return Result::fail ("Error writing session file");
+            }
+
+            writer.forgetOffsets();
+        }
+    }
+
+    TemporaryFile tempFile (file);
+    {
+        FileOutputStream out (tempFile.getFile());
+        if (! out.openedOk())
+            return Result::fail ("Could not create session file");
+
+        if (! (out.write (detail::archiveMagic, 4)
+               && out.writeInt (detail::archiveVersion)
+               && writer.writeTo (out, root)))
+            return Result::fail ("Error writing session file");
+
+        out.flush();
+        if (out.getStatus().failed())
+            return out.getStatus();
+    }
+
+    return tempFile.overwriteTargetFileWithTemporary()
+               ? Result::ok()
+               : Result::fail ("Could not replace session file");
+}
+
+ValueTree SessionArchive::read (const File& file)
+{
+    detail::Reader reader;
+    if (! reader.open (file))
+        return {};
+
+    MemoryBlock structure;
+    const auto offset = reader.find (reader.getRootKey().toString());
+    if (offset < 0 || ! reader.readChunk (offset, structure))
+        return {};
+
+    auto data = ValueTree::readFromData (structure.getData(), structure.getSize());
+    if (data.isValid())
+        detail::resolveChunks (data, reader);
+    return data;
+}
+
+} // namespace element
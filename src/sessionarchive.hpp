@@ -0,0 +1,71 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/data_structures.hpp>
+
+namespace element {
+
+/** A chunked session container.
+
+    The session structure and every node's plugin state are stored as
+    separate chunks keyed by a hash of their content. State is kept raw, and
+    chunks are compressed with a fast zlib level when it helps.
+
+    Writing to a file that is already an archive only appends the chunks it
+    doesn't contain yet, followed by a new index. The file is rewritten from
+    scratch once unreferenced chunks take up more room than live ones.
+
+    Reading maps the file and copies out the chunks the index points at.
+    State chunks are left compressed as LazyState objects, and inflated when
+    the node they belong to restores, see Node::decodeState().
+*/
+class SessionArchive final
+{
+public:
+    /** Returns true if the file looks like a session archive. */
+    static bool isArchive (const juce::File& file);
+
+    /** Write sanitized session data to a file.
+
+        State properties in the tree are replaced with chunk references, so
+        pass a copy. If the file already is an archive, unchanged chunks are
+        reused.
+     */
+    static juce::Result write (juce::ValueTree data, const juce::File& file);
+
+    /** Read session data from an archive. Returns an invalid tree on failure.
+        Node state properties hold LazyState objects until decoded. */
+    static juce::ValueTree read (const juce::File& file);
+
+    /** Node state that hasn't been inflated yet. */
+    class LazyState final : public juce::ReferenceCountedObject
+    {
+    public:
+        LazyState (juce::uint32 codec, juce::uint64 keyA, juce::uint64 keyB, juce::uint64 rawSize, const void* stored, size_t storedSize);
+
+        /** Inflate and verify the state. Safe to call from any thread. */
+        bool decode (juce::MemoryBlock& block) const;
+
+        /** Returns the lazy state held by a property, if any. */
+        static const LazyState* fromVar (const juce::var& value) noexcept
+        {
+            return dynamic_cast<const LazyState*> (value.getObject());
+        }
+
+    private:
+        const juce::uint32 codec;
+        const juce::uint64 keyA, keyB, rawSize;
+        const juce::MemoryBlock stored;
+    };
+
+    /** Minimum size of a state blob to store as its own chunk. Smaller ones
+        stay inline in the structure chunk. */
+    static constexpr int minChunkSize = 256;
+
+private:
+    SessionArchive() = delete;
+};
+
+} // namespace element
@@ -41,6 +41,8 @@ const char* Settings::updateKeyTypeKey = "updateKeyType";
 const char* Settings::updateKeyKey = "updateKey";
 const char* Settings::updateKeyUserKey = "updateKeyUserKey";
 const char* Settings::transportStartStopContinue = "transportStartStopContinueKey";
+const char* Settings::renderThreadsKey = "renderThreads";
+const char* Settings::autosaveIntervalKey = "autosaveInterval";
 
 //=============================================================================
 enum OptionsMenuItemId
@@ -524,6 +526,39 @@ bool Settings::transportRespondToStartStopContinue() const
     return false;
 }
 
+//=============================================================================
+int Settings::getRenderThreads() const
+{
+    if (auto* p = getProps())
+        return jmax (0, p->getIntValue (renderThreadsKey, 0));
+    return 0;
+}
+
+void Settings::setRenderThreads (int numThreads)
+{
+    numThreads = jmax (0, numThreads);
+    if (numThreads == getRenderThreads())
+        return;
+    if (auto* p = getProps())
+        p->setValue (renderThreadsKey, numThreads);
+}
+
+int Settings::getAutosaveInterval() const
+{
+    if (auto* p = getProps())
+        return jmax (0, p->getIntValue (autosaveIntervalKey, 0));
+    return 0;
+}
+
+void Settings::setAutosaveInterval (int minutes)
+{
+    minutes = jmax (0, minutes);
+    if (minutes == getAutosaveInterval())
+        return;
+    if (auto* p = getProps())
+        p->setValue (autosaveIntervalKey, minutes);
+}
+
 //=============================================================================
 void Settings::addItemsToMenu (Context& world, PopupMenu& menu)
 {
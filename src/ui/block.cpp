@@ -162,13 +162,35 @@ void BlockComponent::AsyncEmbedInit::timerCallback()
     stopTimer();
 }
 
+void BlockComponent::StatusWatcher::timerCallback()
+{
+    const bool nowSleeping = block.obj != nullptr && block.obj->isSleeping();
+
+    String times;
+    auto* editor = block.getGraphPanel();
+    if (block.obj != nullptr && editor != nullptr && editor->isShowingRenderTimes())
+    {
+        const auto stats = block.obj->getRenderStats();
+        times << String (stats.avgMicros / 1000.0, 2) << " / "
+              << String (stats.p99Micros / 1000.0, 2) << " ms  "
+              << roundToInt (stats.budgetPercent) << "%";
+    }
+
+    if (nowSleeping == sleeping && times == renderTimes)
+        return;
+    sleeping = nowSleeping;
+    renderTimes = times;
+    block.repaint();
+}
+
 //=============================================================================
 BlockComponent::BlockComponent (const Node& graph_, const Node& node_, const bool vertical_)
     : filterID (node_.getNodeId()),
       graph (graph_),
       node (node_),
       font (11.0f),
-      embedInit (*this)
+      embedInit (*this),
+      statusWatcher (*this)
 {
     nodeObject = node.getPropertyAsValue (tags::object, true);
     obj = node.getObject();
@@ -214,6 +236,7 @@ BlockComponent::BlockComponent (const Node& graph_, const Node& node_, const boo
     setDisplayModeInternal (idm, false);
     if (idm == Embed)
         embedInit.startTimer (14);
+    statusWatcher.startTimer (250);
 
     // setup a fallback alignment.
     String portAlignStr = "middle";
@@ -766,7 +789,28 @@ Rectangle<int> BlockComponent::getCornerResizeBox() const
 
 void BlockComponent::paintOverChildren (Graphics& g)
 {
-    ignoreUnused (g);
+    auto box = getBoxRectangle();
+
+    if (statusWatcher.sleeping)
+    {
+        // dim the block while its node sleeps on silence.
+        g.setColour (Colours::black.withAlpha (0.25f));
+        g.fillRoundedRectangle (box.toFloat(), 2.4f);
+        g.setColour (Colours::white.withAlpha (0.7f));
+        g.setFont (Font (9.f, Font::italic));
+        g.drawText ("zz", box.reduced (4, 2), Justification::bottomRight, false);
+    }
+
+    if (statusWatcher.renderTimes.isNotEmpty())
+    {
+        // avg / p99 render time and share of the block budget.
+        auto r = box.removeFromBottom (12).reduced (3, 0);
+        g.setColour (Colours::black.withAlpha (0.6f));
+        g.fillRect (r);
+        g.setColour (Colours::white);
+        g.setFont (Font (9.f));
+        g.drawText (statusWatcher.renderTimes, r, Justification::centredLeft, true);
+    }
 }
 
 void BlockComponent::paint (Graphics& g)
@@ -419,6 +419,16 @@ private:
         void timerCallback() override;
     } embedInit;
 
+    // polls the sleeping state and render times of the node.
+    struct StatusWatcher : public juce::Timer
+    {
+        StatusWatcher (BlockComponent& b) : block (b) {}
+        bool sleeping = false;
+        String renderTimes;
+        BlockComponent& block;
+        void timerCallback() override;
+    } statusWatcher;
+
 #if 0
 void itemDragEnter (const SourceDetails& dragSourceDetails);
 void itemDragMove (const SourceDetails& dragSourceDetails);
@@ -254,12 +254,27 @@ public:
             }
         }
 
+        if (auto* sessions = world.services().find<SessionService>())
+        {
+            connections.add (sessions->sigLoadProgress.connect ([this] (int loaded, int total) {
+                numNodesLoaded = loaded;
+                numNodesToLoad = total;
+                updateLabels();
+            }));
+            connections.add (sessions->sigSessionLoaded.connect ([this]() {
+                numNodesLoaded = numNodesToLoad = 0;
+                updateLabels();
+            }));
+        }
+
         startTimer (2000);
         updateLabels();
     }
 
     ~StatusBar()
     {
+        for (auto& c : connections)
+            c.disconnect();
         latencySamplesChangedConnection.disconnect();
         sampleRate.removeListener (this);
         streamingStatus.removeListener (this);
@@ -342,6 +357,13 @@ public:
             if (name.isNotEmpty())
                 streamingStatusLabel.setText (text, dontSendNotification);
         }
+
+        if (numNodesLoaded < numNodesToLoad)
+        {
+            auto text = streamingStatusLabel.getText();
+            text << " - Loading: " << numNodesLoaded << "/" << numNodesToLoad << " nodes";
+            streamingStatusLabel.setText (text, dontSendNotification);
+        }
     }
 
 private:
@@ -354,6 +376,8 @@ private:
     Value sampleRate, streamingStatus, status;
 
     SignalConnection latencySamplesChangedConnection;
+    Array<SignalConnection> connections;
+    int numNodesLoaded = 0, numNodesToLoad = 0;
 
     friend class Timer;
     void timerCallback() override
@@ -182,6 +182,7 @@ public:
         int index = 30000;
         ProcessorPtr ptr = node.getObject();
         menu.addItem (index++, "Mute input ports", ptr != nullptr, ptr && ptr->isMutingInputs());
+        menu.addItem (index++, "Sleep on silence", ptr != nullptr && ! node.isGraph(), ptr && ptr->sleepsOnSilence());
         addOversamplingSubmenu (menu);
         addSubMenu (TRANS ("Options"), menu, ptr != nullptr);
 #endif
@@ -355,6 +356,9 @@ public:
                 case 0:
                     node.setMuteInput (! node.isMutingInputs());
                     break;
+                case 1:
+                    node.setSleepOnSilence (! node.sleepsOnSilence());
+                    break;
             }
         }
         else if (result >= 40000 && result < 50000)
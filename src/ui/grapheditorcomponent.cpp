@@ -458,6 +458,16 @@ void GraphEditorComponent::setVerticalLayout (const bool isVertical)
     updateComponents();
 }
 
+void GraphEditorComponent::setShowRenderTimes (bool shouldShow)
+{
+    if (showRenderTimes == shouldShow)
+        return;
+    showRenderTimes = shouldShow;
+    for (auto* child : getChildren())
+        if (auto* block = dynamic_cast<BlockComponent*> (child))
+            block->statusWatcher.timerCallback();
+}
+
 void GraphEditorComponent::paint (Graphics& g)
 {
     g.fillAll (findColour (Style::contentBackgroundColorId));
@@ -501,6 +511,7 @@ void GraphEditorComponent::mouseDown (const MouseEvent& e)
         menu.addSeparator();
         menu.addItem (5, "Change orientation...");
         menu.addItem (7, "Gather nodes...");
+        menu.addItem (8, "Show render times", true, isShowingRenderTimes());
 
         menu.addSeparator();
         menu.addSectionHeader ("Plugins");
@@ -554,6 +565,11 @@ void GraphEditorComponent::mouseDown (const MouseEvent& e)
                     return;
                     break;
 
+                case 8:
+                    setShowRenderTimes (! isShowingRenderTimes());
+                    return;
+                    break;
+
                 case 7: {
                     int width = getWidth();
                     int height = getHeight();
@@ -57,6 +57,13 @@ public:
     /** Changes the layout to vertical or not */
     void setVerticalLayout (const bool isVertical);
 
+    //=========================================================================
+    /** Returns true if blocks show their render times */
+    bool isShowingRenderTimes() const noexcept { return showRenderTimes; }
+
+    /** Show or hide render times on blocks */
+    void setShowRenderTimes (bool shouldShow);
+
     //=========================================================================
     Rectangle<int> getRequiredSpace() const;
 
@@ -106,6 +113,7 @@ private:
     std::unique_ptr<BlockFactory> factory;
 
     bool verticalLayout = true;
+    bool showRenderTimes = false;
 
     LassoComponent<uint32> lasso;
     friend class SelectedNodes;
@@ -432,6 +432,38 @@ private:
     }
 };
 
+/** Shows how many nodes sleep on silence and the time it saved. */
+class SleepSavingsPropertyComponent : public PropertyComponent,
+                                      private Timer
+{
+public:
+    SleepSavingsPropertyComponent (const Node& node)
+        : PropertyComponent ("Sleeping"),
+          _proc (dynamic_cast<GraphNode*> (node.getObject()))
+    {
+        addAndMakeVisible (text);
+        text.setFont (text.getFont().withHeight (11.f));
+        refresh();
+        startTimer (1000);
+    }
+
+    void refresh() override
+    {
+        if (_proc == nullptr)
+            return;
+        String str;
+        str << _proc->getNumSleepingNodes() << " nodes, "
+            << String (_proc->getSleepSavedSeconds(), 1) << " s CPU saved";
+        text.setText (str, dontSendNotification);
+    }
+
+private:
+    ReferenceCountedObjectPtr<GraphNode> _proc;
+    Label text;
+
+    void timerCallback() override { refresh(); }
+};
+
 class GraphPropertyPanel : public PropertyPanel
 {
 public:
@@ -493,6 +525,7 @@ private:
         props.add (new GraphChannelCountPropertyComponent (g, PortType::Audio, false));
         props.add (new GraphChannelCountPropertyComponent (g, PortType::Midi, true));
         props.add (new GraphChannelCountPropertyComponent (g, PortType::Midi, false));
+        props.add (new SleepSavingsPropertyComponent (g));
         // props.add (new BooleanPropertyComponent (g.getPropertyAsValue (tags::persistent),
         //                                          TRANS("Persistent"),
         //                                          TRANS("Don't unload when deactivated")));
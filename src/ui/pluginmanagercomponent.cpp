@@ -295,7 +295,7 @@ public:
 
     int getNumRows() override
     {
-        return list.getNumTypes() + list.getBlacklistedFiles().size();
+        return owner.rows.size() + (owner.isFiltering() ? 0 : list.getBlacklistedFiles().size());
     }
 
     void paintRowBackground (Graphics& g, int rowNumber, int width, int height, bool rowIsSelected) override
@@ -323,19 +323,19 @@ public:
     void paintCell (Graphics& g, int row, int columnId, int width, int height, bool rowIsSelected) override
     {
         String text;
-        bool isBlacklisted = row >= list.getNumTypes();
+        const auto& rows = owner.rows;
+        bool isBlacklisted = row >= rows.size();
 
         if (isBlacklisted)
         {
             if (columnId == nameCol)
-                text = list.getBlacklistedFiles()[row - list.getNumTypes()];
+                text = list.getBlacklistedFiles()[row - rows.size()];
             else if (columnId == descCol)
                 text = TRANS ("Deactivated after failing to initialise correctly");
         }
-        else if (isPositiveAndBelow (row, list.getNumTypes()))
+        else if (isPositiveAndBelow (row, rows.size()))
         {
-            const auto types = list.getTypes();
-            const auto& desc = types.getReference (row);
+            const auto& desc = rows.getReference (row);
             switch (columnId)
             {
                 case nameCol:
@@ -492,6 +492,10 @@ PluginListComponent::PluginListComponent (PluginManager& p, PropertiesFile* prop
     scanButton.setButtonText ("Scan");
     scanButton.addListener (this);
 
+    addAndMakeVisible (searchBox);
+    searchBox.setTextToShowWhenEmpty (TRANS ("Search..."), Colors::textColor.darker());
+    searchBox.addListener (this);
+
     setSize (400, 600);
     list.addChangeListener (this);
 
@@ -535,11 +539,13 @@ void PluginListComponent::resized()
     scanButton.changeWidthToFitText (r2.getHeight());
     scanButton.setBounds (r2.removeFromLeft (scanButton.getWidth()));
     r2.removeFromLeft (4);
-    optionsButton.setBounds (r2);
     optionsButton.changeWidthToFitText (r2.getHeight());
+    optionsButton.setBounds (r2.removeFromLeft (optionsButton.getWidth()));
     r2.removeFromRight (2);
     closeButton.changeWidthToFitText (r2.getHeight());
     closeButton.setBounds (r2.removeFromRight (closeButton.getWidth()));
+    r2.removeFromRight (4);
+    searchBox.setBounds (r2.removeFromRight (jmin (240, jmax (0, r2.getWidth() - 4))));
     r.removeFromTop (3);
     r.removeFromBottom (3);
     table.setBounds (r);
@@ -558,10 +564,28 @@ void PluginListComponent::changeListenerCallback (ChangeBroadcaster* cb)
 
 void PluginListComponent::updateList()
 {
+    const auto query = searchBox.getText().trim();
+    rows = query.isEmpty() ? list.getTypes() : plugins.searchPlugins (query);
     table.updateContent();
     table.repaint();
 }
 
+bool PluginListComponent::isFiltering() const
+{
+    return searchBox.getText().trim().isNotEmpty();
+}
+
+void PluginListComponent::textEditorTextChanged (TextEditor&)
+{
+    startTimer (100);
+}
+
+void PluginListComponent::timerCallback()
+{
+    stopTimer();
+    updateList();
+}
+
 void PluginListComponent::removeSelectedPlugins()
 {
     const SparseSet<int> selected (table.getSelectedRows());
@@ -584,10 +608,9 @@ void PluginListComponent::setTableModel (TableListBoxModel* model)
 
 bool PluginListComponent::canShowSelectedFolder() const
 {
-    const auto types = list.getTypes();
-    if (isPositiveAndBelow (table.getSelectedRow(), types.size()))
+    if (isPositiveAndBelow (table.getSelectedRow(), rows.size()))
         return File::createFileWithoutCheckingPath (
-                   types.getReference (table.getSelectedRow()).fileOrIdentifier)
+                   rows.getReference (table.getSelectedRow()).fileOrIdentifier)
             .exists();
 
     return false;
@@ -598,8 +621,7 @@ void PluginListComponent::showSelectedFolder()
     if (! canShowSelectedFolder())
         return;
 
-    const auto types = list.getTypes();
-    const auto type = types[(table.getSelectedRow())];
+    const auto type = rows[(table.getSelectedRow())];
     File (type.fileOrIdentifier).getParentDirectory().startAsProcess();
 }
 
@@ -613,14 +635,13 @@ void PluginListComponent::removeMissingPlugins()
 
 void PluginListComponent::removePluginItem (int index)
 {
-    const auto types = list.getTypes();
-    if (! isPositiveAndBelow (index, types.size()))
+    if (! isPositiveAndBelow (index, rows.size()))
     {
-        list.removeFromBlacklist (list.getBlacklistedFiles()[index - types.size()]);
+        list.removeFromBlacklist (list.getBlacklistedFiles()[index - rows.size()]);
         return;
     }
 
-    const auto& type = types.getReference (index);
+    const auto& type = rows.getReference (index);
     if (type.pluginFormatName == "Element")
         return;
 
@@ -22,7 +22,9 @@ class Settings;
 class PluginListComponent : public Component,
                             public FileDragAndDropTarget,
                             private ChangeListener,
-                            private Button::Listener
+                            private Button::Listener,
+                            private TextEditor::Listener,
+                            private Timer
 {
 public:
     //==============================================================================
@@ -90,6 +92,8 @@ private:
     File deadMansPedalFile;
     TableListBox table;
     TextButton optionsButton, closeButton, scanButton;
+    TextEditor searchBox;
+    Array<PluginDescription> rows; // what the table shows, filtered when searching
     PropertiesFile* propertiesToUse;
     String dialogTitle, dialogText;
     bool allowAsync;
@@ -109,6 +113,7 @@ private:
     static void optionsMenuStaticCallback (int, PluginListComponent*);
     void optionsMenuCallback (int);
     void updateList();
+    bool isFiltering() const;
     void showSelectedFolder();
     bool canShowSelectedFolder() const;
     void removeMissingPlugins();
@@ -119,6 +124,8 @@ private:
     void filesDropped (const StringArray&, int, int) override;
     void buttonClicked (Button*) override;
     void changeListenerCallback (ChangeBroadcaster*) override;
+    void textEditorTextChanged (TextEditor&) override;
+    void timerCallback() override;
 
     void scanWithBackgroundScanner();
 
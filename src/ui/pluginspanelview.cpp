@@ -72,12 +72,10 @@ public:
     {
         if (isNowOpen)
         {
-            const auto text = panel.getSearchText();
             for (auto* folder : tree.subFolders)
                 addSubItem (new PluginFolderTreeViewItem (panel, *folder));
             for (const auto& plugin : tree.plugins)
-                if (text.isEmpty() || plugin.name.containsIgnoreCase (text))
-                    addSubItem (new PluginTreeViewItem (plugin));
+                addSubItem (new PluginTreeViewItem (plugin));
         }
         else
         {
@@ -93,8 +91,14 @@ public:
         : owner (o),
           plugins (p)
     {
-        data = KnownPluginList::createTree (p.getKnownPlugins().getTypes(),
-                                            KnownPluginList::sortByCategory);
+        // searching shows a flat ranked list, the category tree is only
+        // built when there is nothing to search for.
+        const auto text = o.getSearchText().trim();
+        if (text.isNotEmpty())
+            results = p.searchPlugins (text);
+        else
+            data = KnownPluginList::createTree (p.getKnownPlugins().getTypes(),
+                                                KnownPluginList::sortByCategory);
     }
 
     bool mightContainSubItems() override { return true; }
@@ -103,6 +107,13 @@ public:
     {
         if (isNowOpen)
         {
+            if (data == nullptr)
+            {
+                for (const auto& plugin : results)
+                    addSubItem (new PluginTreeViewItem (plugin));
+                return;
+            }
+
             for (auto* folder : data->subFolders)
                 addSubItem (new PluginFolderTreeViewItem (owner, *folder));
         }
@@ -116,6 +127,7 @@ public:
     PluginManager& plugins;
 
     std::unique_ptr<KnownPluginList::PluginTree> data;
+    Array<PluginDescription> results;
 };
 
 PluginsPanelView::PluginsPanelView (PluginManager& p)
@@ -152,13 +164,15 @@ void PluginsPanelView::paint (Graphics& g) {}
 
 void PluginsPanelView::textEditorTextChanged (TextEditor&)
 {
-    startTimer (200);
+    startTimer (100);
 }
 
 void PluginsPanelView::updateTreeView()
 {
     tree.deleteRootItem();
     tree.setRootItem (new PluginsPanelTreeRootItem (*this, plugins));
+    if (getSearchText().trim().isNotEmpty())
+        return;
     auto* root = tree.getRootItem();
     for (int i = 0; i < root->getNumSubItems(); ++i)
         root->getSubItem (i)->setOpenness (TreeViewItem::Openness::opennessOpen);
@@ -17,6 +17,7 @@
 #include "services/oscservice.hpp"
 #include "engine/midiengine.hpp"
 #include "engine/midipanic.hpp"
+#include "engine/renderpool.hpp"
 
 namespace element {
 
@@ -466,6 +467,34 @@ public:
         clockSource.setValue (source);
         clockSource.addListener (this);
 
+        addAndMakeVisible (renderThreadsLabel);
+        renderThreadsLabel.setText ("Render threads", dontSendNotification);
+        renderThreadsLabel.setFont (Font (12.0, Font::bold));
+        addAndMakeVisible (renderThreads);
+        renderThreads.setTooltip ("Extra threads used to render independent nodes in parallel. 0 = off");
+        renderThreads.setRange (0.0, (double) RenderPool::getMaxWorkers(), 1.0);
+        renderThreads.setValue ((double) settings.getRenderThreads(), dontSendNotification);
+        renderThreads.setSliderStyle (Slider::IncDecButtons);
+        renderThreads.setTextBoxStyle (Slider::TextBoxLeft, false, 82, 22);
+        renderThreads.onValueChange = [this]() {
+            settings.setRenderThreads (roundToInt (renderThreads.getValue()));
+            if (engine != nullptr)
+                engine->applySettings (settings);
+        };
+
+        addAndMakeVisible (autosaveLabel);
+        autosaveLabel.setText ("Autosave minutes", dontSendNotification);
+        autosaveLabel.setFont (Font (12.0, Font::bold));
+        addAndMakeVisible (autosave);
+        autosave.setTooltip ("Save a changed session in the background every so many minutes. 0 = off");
+        autosave.setRange (0.0, 60.0, 1.0);
+        autosave.setValue ((double) settings.getAutosaveInterval(), dontSendNotification);
+        autosave.setSliderStyle (Slider::IncDecButtons);
+        autosave.setTextBoxStyle (Slider::TextBoxLeft, false, 82, 22);
+        autosave.onValueChange = [this]() {
+            settings.setAutosaveInterval (roundToInt (autosave.getValue()));
+        };
+
         addAndMakeVisible (mainContentLabel);
         mainContentLabel.setText ("UI Type", dontSendNotification);
         mainContentLabel.setFont (Font (12.0, Font::bold));
@@ -543,6 +572,8 @@ public:
 
         layoutSetting (r, systrayLabel, systray);
         layoutSetting (r, desktopScaleLabel, desktopScale, getWidth() / 4);
+        layoutSetting (r, renderThreadsLabel, renderThreads, getWidth() / 4);
+        layoutSetting (r, autosaveLabel, autosave, getWidth() / 4);
         layoutSetting (r, legacyCtlLabel, legacyCtl);
 
 #if ! ELEMENT_SE
@@ -674,6 +705,12 @@ private:
     Label desktopScaleLabel;
     Slider desktopScale;
 
+    Label renderThreadsLabel;
+    Slider renderThreads;
+
+    Label autosaveLabel;
+    Slider autosave;
+
     Label mainContentLabel;
     ComboBox mainContentBox;
 
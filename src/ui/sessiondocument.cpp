@@ -3,6 +3,7 @@
 
 #include <element/session.hpp>
 #include "ui/sessiondocument.hpp"
+#include "sessionarchive.hpp"
 
 namespace element {
 
@@ -31,10 +32,15 @@ Result SessionDocument::loadDocument (const File& file)
         return Result::fail ("No session data target");
 
     String error;
-    if (auto e = XmlDocument::parse (file))
+    ValueTree newData;
+    if (SessionArchive::isArchive (file))
+        newData = Session::readFromFile (file);
+    else if (auto e = XmlDocument::parse (file))
+        newData = ValueTree::fromXml (*e);
+
+    if (newData.isValid())
     {
-        ValueTree newData (ValueTree::fromXml (*e));
-        if (newData.isValid() && (int) newData.getProperty (tags::version, -1) != EL_SESSION_VERSION)
+        if ((int) newData.getProperty (tags::version, -1) != EL_SESSION_VERSION)
         {
             std::clog << "[element] migrate session...\n";
             newData = Session::migrate (newData, error);
@@ -74,15 +80,8 @@ Result SessionDocument::saveDocument (const File& file)
         return Result::fail ("Nil session");
 
     session->saveGraphState();
-    if (auto e = session->createXml())
-    {
-        Result res (e->writeTo (file)
-                        ? Result::ok()
-                        : Result::fail ("Error writing session file"));
-        return res;
-    }
-
-    return Result::fail ("Could not create session data");
+    return session->writeToFile (file) ? Result::ok()
+                                       : Result::fail ("Error writing session file");
 }
 
 File SessionDocument::getLastDocumentOpened() { return lastSession; }
@@ -0,0 +1,135 @@
+#include <boost/test/unit_test.hpp>
+
+#include "nodes/compressor.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+void setParameter (AudioProcessor& proc, const String& paramID, float value)
+{
+    for (auto* param : proc.getParameters())
+        if (auto* ranged = dynamic_cast<RangedAudioParameter*> (param))
+            if (ranged->paramID == paramID)
+                ranged->setValueNotifyingHost (ranged->convertTo0to1 (value));
+}
+
+void prepare (CompressorProcessor& comp, int blockSize = 512)
+{
+    // settle the smoothed parameters before rendering.
+    comp.updateParams();
+    comp.prepareToPlay (48000.0, blockSize);
+}
+
+/** Renders blocks of constant input, main channels only. */
+void renderConstant (CompressorProcessor& comp, AudioBuffer<float>& buffer, float left, float right, int numBlocks)
+{
+    MidiBuffer midi;
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        buffer.clear();
+        FloatVectorOperations::fill (buffer.getWritePointer (0), left, buffer.getNumSamples());
+        FloatVectorOperations::fill (buffer.getWritePointer (1), right, buffer.getNumSamples());
+        comp.processBlock (buffer, midi);
+    }
+}
+
+float lastSample (const AudioBuffer<float>& buffer, int channel)
+{
+    return buffer.getSample (channel, buffer.getNumSamples() - 1);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (CompressorTests)
+
+BOOST_AUTO_TEST_CASE (QuietSignalPassesThrough)
+{
+    CompressorProcessor comp;
+    setParameter (comp, "thresh", -20.0f);
+    setParameter (comp, "ratio", 4.0f);
+    prepare (comp);
+
+    AudioBuffer<float> buffer (4, 512);
+    renderConstant (comp, buffer, 0.01f, 0.01f, 4);
+    BOOST_REQUIRE_CLOSE (lastSample (buffer, 0), 0.01f, 0.01f);
+    BOOST_REQUIRE_CLOSE (lastSample (buffer, 1), 0.01f, 0.01f);
+    BOOST_REQUIRE_EQUAL (comp.getGainReductionDB(), 0.0f);
+}
+
+BOOST_AUTO_TEST_CASE (LoudSignalIsReduced)
+{
+    CompressorProcessor comp;
+    setParameter (comp, "thresh", -20.0f);
+    setParameter (comp, "ratio", 4.0f);
+    prepare (comp);
+
+    AudioBuffer<float> buffer (4, 512);
+    renderConstant (comp, buffer, 1.0f, 1.0f, 20);
+
+    // 20 dB over the threshold at 4:1 leaves 5 dB over it.
+    const auto expected = Decibels::decibelsToGain (-15.0f);
+    BOOST_REQUIRE_CLOSE (lastSample (buffer, 0), expected, 2.0f);
+    BOOST_REQUIRE_CLOSE (lastSample (buffer, 1), expected, 2.0f);
+    BOOST_REQUIRE (comp.getGainReductionDB() < -14.0f);
+    BOOST_REQUIRE (comp.getInputLevelDB() > -0.5f);
+}
+
+BOOST_AUTO_TEST_CASE (StereoLink)
+{
+    AudioBuffer<float> buffer (4, 512);
+
+    CompressorProcessor linked;
+    setParameter (linked, "thresh", -20.0f);
+    setParameter (linked, "ratio", 4.0f);
+    prepare (linked);
+    renderConstant (linked, buffer, 1.0f, 0.01f, 20);
+    BOOST_REQUIRE (lastSample (buffer, 1) < 0.005f);
+
+    CompressorProcessor unlinked;
+    setParameter (unlinked, "thresh", -20.0f);
+    setParameter (unlinked, "ratio", 4.0f);
+    setParameter (unlinked, "link", (float) CompressorProcessor::linkOff);
+    prepare (unlinked);
+    renderConstant (unlinked, buffer, 1.0f, 0.01f, 20);
+    BOOST_REQUIRE (lastSample (buffer, 0) < 0.2f);
+    BOOST_REQUIRE_CLOSE (lastSample (buffer, 1), 0.01f, 0.01f);
+}
+
+BOOST_AUTO_TEST_CASE (LookaheadDelays)
+{
+    CompressorProcessor comp;
+    setParameter (comp, "lookahead", 1.0f);
+    prepare (comp, 32);
+    BOOST_REQUIRE_EQUAL (comp.getLatencySamples(), 48);
+
+    // the impulse comes out a little more than one block later.
+    AudioBuffer<float> buffer (4, 32);
+    MidiBuffer midi;
+    int found = -1;
+    for (int b = 0; b < 4; ++b)
+    {
+        buffer.clear();
+        if (b == 0)
+            buffer.setSample (0, 0, 0.5f);
+        comp.processBlock (buffer, midi);
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            if (buffer.getSample (0, i) != 0.0f)
+                found = b * buffer.getNumSamples() + i;
+    }
+
+    BOOST_REQUIRE_EQUAL (found, 48);
+}
+
+BOOST_AUTO_TEST_CASE (LookaheadFollowsParameter)
+{
+    CompressorProcessor comp;
+    prepare (comp, 32);
+    BOOST_REQUIRE_EQUAL (comp.getLatencySamples(), 0);
+
+    // automation changes apply without touching the editor or state.
+    setParameter (comp, "lookahead", 2.0f);
+    comp.handleUpdateNowIfNeeded();
+    BOOST_REQUIRE_EQUAL (comp.getLatencySamples(), 96);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,14 +1,64 @@
 #include <boost/test/unit_test.hpp>
 
+#include <element/atombuffer.hpp>
+#include <element/audioengine.hpp>
 #include <element/context.hpp>
 
 #include "fixture/PreparedGraph.h"
 #include "fixture/TestNode.h"
+#include "engine/graphbuilder.hpp"
 #include "engine/graphnode.hpp"
+#include "engine/ionode.hpp"
+#include "engine/renderpool.hpp"
 #include "utils.hpp"
 
 using namespace element;
 
+namespace {
+/** Stereo output which is the same every block. */
+class SourceNode : public TestNode {
+public:
+    SourceNode() : TestNode (0, 2, 0, 0) {}
+
+    void render (RenderContext& rc) override
+    {
+        for (int c = 0; c < rc.audio.getNumChannels(); ++c)
+            for (int i = 0; i < rc.audio.getNumSamples(); ++i)
+                rc.audio.setSample (c, i, (float) std::sin (0.01 * (i + 1) * (c + 1)));
+    }
+};
+
+class GainNode : public TestNode {
+public:
+    explicit GainNode (float g) : TestNode (2, 2, 0, 0), gain (g) {}
+
+    void render (RenderContext& rc) override { rc.audio.applyGain (gain); }
+
+private:
+    const float gain;
+};
+
+AudioBuffer<float> renderBlocks (GraphNode& graph, int numBlocks, int blockSize)
+{
+    AudioBuffer<float> result (2, numBlocks * blockSize);
+    AudioSampleBuffer audio (2, blockSize), cv;
+    MidiBuffer midi;
+    AtomBuffer atoms;
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        audio.clear();
+        midi.clear();
+        RenderContext rc (audio, cv, midi, atoms, blockSize);
+        graph.render (rc);
+        for (int c = 0; c < 2; ++c)
+            result.copyFrom (c, block * blockSize, audio, c, 0, blockSize);
+    }
+
+    return result;
+}
+} // namespace
+
 BOOST_AUTO_TEST_SUITE (GraphNodeTests)
 
 BOOST_AUTO_TEST_CASE (IO)
@@ -77,4 +127,104 @@ BOOST_AUTO_TEST_CASE (AddRemove)
     BOOST_REQUIRE (graph.removeNode (node->nodeId));
 }
 
+BOOST_AUTO_TEST_CASE (OrderedNodes)
+{
+    GraphNode graph (*element::test::context());
+    auto* last = new TestNode();
+    auto* middle = new TestNode();
+    auto* first = new TestNode();
+    auto* other = new TestNode();
+    graph.addNode (last);
+    graph.addNode (middle);
+    graph.addNode (first);
+    graph.addNode (other);
+
+    BOOST_REQUIRE (graph.connectChannels (PortType::Audio, first->nodeId, 0, middle->nodeId, 0));
+    BOOST_REQUIRE (graph.connectChannels (PortType::Audio, middle->nodeId, 0, last->nodeId, 0));
+    BOOST_REQUIRE (graph.connectChannels (PortType::Audio, first->nodeId, 1, last->nodeId, 1));
+
+    ReferenceCountedArray<Processor> ordered;
+    graph.getOrderedNodes (ordered);
+    BOOST_REQUIRE_EQUAL (ordered.size(), 4);
+    BOOST_REQUIRE (ordered.indexOf (first) < ordered.indexOf (middle));
+    BOOST_REQUIRE (ordered.indexOf (middle) < ordered.indexOf (last));
+    BOOST_REQUIRE (ordered.contains (other));
+
+    // feedback loops still include every node.
+    BOOST_REQUIRE (graph.connectChannels (PortType::Audio, last->nodeId, 0, first->nodeId, 0));
+    ordered.clear();
+    graph.getOrderedNodes (ordered);
+    BOOST_REQUIRE_EQUAL (ordered.size(), 4);
+
+    graph.clear();
+}
+
+BOOST_AUTO_TEST_CASE (ParallelMatchesSerial)
+{
+    Context context (RunMode::Standalone);
+    GraphNode graph (context);
+
+    // one source feeding two chains, mixed at the output.
+    auto* source = new SourceNode();
+    Processor* chains[2][2] = { { new GainNode (0.5f), new GainNode (-0.25f) },
+                                { new GainNode (-0.75f), new GainNode (1.5f) } };
+    graph.addNode (source);
+    const auto output = graph.addNode (new IONode (IONode::audioOutputNode))->nodeId;
+    for (auto& chain : chains)
+    {
+        graph.addNode (chain[0]);
+        graph.addNode (chain[1]);
+        for (int c = 0; c < 2; ++c)
+        {
+            BOOST_REQUIRE (graph.connectChannels (PortType::Audio, source->nodeId, c, chain[0]->nodeId, c));
+            BOOST_REQUIRE (graph.connectChannels (PortType::Audio, chain[0]->nodeId, c, chain[1]->nodeId, c));
+            BOOST_REQUIRE (graph.connectChannels (PortType::Audio, chain[1]->nodeId, c, output, c));
+        }
+    }
+
+    {
+        // the chains only share a read-only source, so neither waits on the
+        // other: source, two gains and the output is the longest path.
+        ReferenceCountedArray<Processor> ordered;
+        graph.getOrderedNodes (ordered);
+        Array<void*> nodes, ops;
+        for (auto* node : ordered)
+            nodes.add (node);
+
+        GraphBuilder builder (graph, nodes, ops);
+        const auto& tasks = builder.getTasks();
+        Array<int> depths;
+        depths.insertMultiple (0, 1, tasks.size());
+        int longest = 0;
+        for (int i = 0; i < tasks.size(); ++i)
+        {
+            longest = jmax (longest, depths[i]);
+            for (const auto next : tasks.getReference (i).successors)
+                depths.set (next, jmax (depths[next], depths[i] + 1));
+        }
+
+        BOOST_REQUIRE (builder.hasConcurrentTasks());
+        BOOST_REQUIRE_EQUAL (longest, 4);
+        for (auto* op : ops)
+            delete static_cast<GraphOp*> (op);
+    }
+
+    auto& pool = context.audio()->getRenderPool();
+    graph.prepareToRender (44100.0, 256);
+
+    pool.setNumWorkers (0);
+    const auto serial = renderBlocks (graph, 8, 256);
+    pool.setNumWorkers (3);
+    const auto parallel = renderBlocks (graph, 8, 256);
+    pool.setNumWorkers (0);
+
+    graph.releaseResources();
+    graph.clear();
+
+    BOOST_REQUIRE (serial.getMagnitude (0, 0, serial.getNumSamples()) > 0.1f);
+    for (int c = 0; c < 2; ++c)
+        for (int i = 0; i < serial.getNumSamples(); ++i)
+            BOOST_REQUIRE_EQUAL (serial.getSample (c, i), parallel.getSample (c, i));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,504 @@
+// Graph render benchmarks.
+//
+// Builds synthetic graphs out of internal nodes and measures how long it
+// takes to build their rendering sequences, how long a block takes to
+// render at several block sizes, and how many allocations happen while
+// rendering. Results are written as JSON so runs can be compared.
+//
+//   bench_element [--blocks=2000] [--block-sizes=64,256,1024] [--threads=0|max|N]
+//                 [--output=results.json]
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <vector>
+
+#include <element/context.hpp>
+#include <element/juce.hpp>
+#include <element/nodefactory.hpp>
+#include <element/version.hpp>
+
+#include "engine/graphnode.hpp"
+#include "engine/ionode.hpp"
+#include "engine/renderpool.hpp"
+#include "fixture/BenchNode.h"
+#include "fixture/PreparedGraph.h"
+#include "nodes/nodetypes.hpp"
+
+using namespace juce;
+using namespace element;
+
+//==============================================================================
+// Every operator new while rendering counts as an allocation. With glibc,
+// malloc, calloc and realloc are replaced too, so C allocations inside
+// plugins and libraries are seen as well.
+static std::atomic<bool> countAllocations { false };
+static std::atomic<int64> numAllocations { 0 };
+
+#if JUCE_MSVC
+#define EL_BENCH_EXPORT
+#else
+#define EL_BENCH_EXPORT __attribute__ ((visibility ("default")))
+#endif
+
+static inline void countAllocation() noexcept
+{
+    if (countAllocations.load (std::memory_order_relaxed))
+        numAllocations.fetch_add (1, std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+#define EL_BENCH_COUNTS_MALLOC 1
+extern "C" {
+void* __libc_malloc (std::size_t);
+void* __libc_calloc (std::size_t, std::size_t);
+void* __libc_realloc (void*, std::size_t);
+
+EL_BENCH_EXPORT void* malloc (std::size_t size)
+{
+    countAllocation();
+    return __libc_malloc (size);
+}
+
+EL_BENCH_EXPORT void* calloc (std::size_t count, std::size_t size)
+{
+    countAllocation();
+    return __libc_calloc (count, size);
+}
+
+EL_BENCH_EXPORT void* realloc (void* ptr, std::size_t size)
+{
+    countAllocation();
+    return __libc_realloc (ptr, size);
+}
+}
+
+// operator new counts for itself.
+static void* rawAllocate (std::size_t size) { return __libc_malloc (size); }
+#else
+#define EL_BENCH_COUNTS_MALLOC 0
+static void* rawAllocate (std::size_t size) { return std::malloc (size); }
+#endif
+
+static void* allocate (std::size_t size)
+{
+    countAllocation();
+    if (auto* ptr = rawAllocate (size > 0 ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+static void* allocateAligned (std::size_t size, std::align_val_t align)
+{
+    countAllocation();
+    const auto alignment = jmax (sizeof (void*), static_cast<std::size_t> (align));
+#if JUCE_WINDOWS
+    if (auto* ptr = _aligned_malloc (size > 0 ? size : 1, alignment))
+        return ptr;
+#else
+    void* ptr = nullptr;
+    if (posix_memalign (&ptr, alignment, size > 0 ? size : 1) == 0)
+        return ptr;
+#endif
+    throw std::bad_alloc();
+}
+
+static void freeAligned (void* ptr) noexcept
+{
+#if JUCE_WINDOWS
+    _aligned_free (ptr);
+#else
+    std::free (ptr);
+#endif
+}
+
+EL_BENCH_EXPORT void* operator new (std::size_t size) { return allocate (size); }
+EL_BENCH_EXPORT void* operator new[] (std::size_t size) { return allocate (size); }
+EL_BENCH_EXPORT void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocate (size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+EL_BENCH_EXPORT void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocate (size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+EL_BENCH_EXPORT void operator delete (void* ptr) noexcept { std::free (ptr); }
+EL_BENCH_EXPORT void operator delete[] (void* ptr) noexcept { std::free (ptr); }
+EL_BENCH_EXPORT void operator delete (void* ptr, std::size_t) noexcept { std::free (ptr); }
+EL_BENCH_EXPORT void operator delete[] (void* ptr, std::size_t) noexcept { std::free (ptr); }
+EL_BENCH_EXPORT void operator delete (void* ptr, const std::nothrow_t&) noexcept { std::free (ptr); }
+EL_BENCH_EXPORT void operator delete[] (void* ptr, const std::nothrow_t&) noexcept { std::free (ptr); }
+
+EL_BENCH_EXPORT void* operator new (std::size_t size, std::align_val_t align) { return allocateAligned (size, align); }
+EL_BENCH_EXPORT void* operator new[] (std::size_t size, std::align_val_t align) { return allocateAligned (size, align); }
+EL_BENCH_EXPORT void* operator new (std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocateAligned (size, align);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+EL_BENCH_EXPORT void* operator new[] (std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocateAligned (size, align);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+EL_BENCH_EXPORT void operator delete (void* ptr, std::align_val_t) noexcept { freeAligned (ptr); }
+EL_BENCH_EXPORT void operator delete[] (void* ptr, std::align_val_t) noexcept { freeAligned (ptr); }
+EL_BENCH_EXPORT void operator delete (void* ptr, std::size_t, std::align_val_t) noexcept { freeAligned (ptr); }
+EL_BENCH_EXPORT void operator delete[] (void* ptr, std::size_t, std::align_val_t) noexcept { freeAligned (ptr); }
+EL_BENCH_EXPORT void operator delete (void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned (ptr); }
+EL_BENCH_EXPORT void operator delete[] (void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned (ptr); }
+
+//==============================================================================
+namespace element {
+namespace test {
+static std::unique_ptr<Context> _context;
+Context* context()
+{
+    if (_context == nullptr)
+        _context = std::make_unique<Context> (RunMode::Standalone);
+    return _context.get();
+}
+
+void resetContext() { _context.reset(); }
+} // namespace test
+} // namespace element
+
+//==============================================================================
+namespace {
+
+struct IO {
+    uint32 audioIn = 0, audioOut = 0, midiIn = 0, midiOut = 0;
+};
+
+IO addIONodes (GraphNode& graph)
+{
+    IO io;
+    io.audioIn = graph.addNode (new IONode (IONode::audioInputNode))->nodeId;
+    io.audioOut = graph.addNode (new IONode (IONode::audioOutputNode))->nodeId;
+    io.midiIn = graph.addNode (new IONode (IONode::midiInputNode))->nodeId;
+    io.midiOut = graph.addNode (new IONode (IONode::midiOutputNode))->nodeId;
+    return io;
+}
+
+void connect (GraphNode& graph, PortType type, uint32 src, uint32 dst, int numChannels = 1)
+{
+    for (int c = 0; c < numChannels; ++c)
+        graph.connectChannels (type, src, c, dst, c);
+}
+
+uint32 addBenchNode (GraphNode& graph)
+{
+    return graph.addNode (new BenchNode (2, 2, 1, 1))->nodeId;
+}
+
+/** A chain of nodes in series, audio and MIDI. */
+void buildChain (GraphNode& graph, int length)
+{
+    const auto io = addIONodes (graph);
+    auto audio = io.audioIn, midi = io.midiIn;
+    for (int i = 0; i < length; ++i)
+    {
+        const auto node = addBenchNode (graph);
+        connect (graph, PortType::Audio, audio, node, 2);
+        connect (graph, PortType::Midi, midi, node);
+        audio = midi = node;
+    }
+    connect (graph, PortType::Audio, audio, io.audioOut, 2);
+    connect (graph, PortType::Midi, midi, io.midiOut);
+}
+
+/** One node feeding many in parallel, all mixed into one. */
+void buildFan (GraphNode& graph, int width)
+{
+    const auto io = addIONodes (graph);
+    const auto split = addBenchNode (graph);
+    const auto mix = addBenchNode (graph);
+    connect (graph, PortType::Audio, io.audioIn, split, 2);
+    connect (graph, PortType::Midi, io.midiIn, split);
+
+    for (int i = 0; i < width; ++i)
+    {
+        const auto node = addBenchNode (graph);
+        connect (graph, PortType::Audio, split, node, 2);
+        connect (graph, PortType::Midi, split, node);
+        connect (graph, PortType::Audio, node, mix, 2);
+        connect (graph, PortType::Midi, node, mix);
+    }
+
+    connect (graph, PortType::Audio, mix, io.audioOut, 2);
+    connect (graph, PortType::Midi, mix, io.midiOut);
+}
+
+/** A subgraph holding a short chain and, below the given depth, another subgraph. */
+GraphNode* createSubgraph (int depth)
+{
+    auto* sub = new GraphNode (*element::test::context());
+    const auto io = addIONodes (*sub);
+    auto audio = io.audioIn, midi = io.midiIn;
+    for (int i = 0; i < 8; ++i)
+    {
+        uint32 node = 0;
+        if (i == 4 && depth > 0)
+            node = sub->addNode (createSubgraph (depth - 1))->nodeId;
+        else
+            node = addBenchNode (*sub);
+        connect (*sub, PortType::Audio, audio, node, 2);
+        connect (*sub, PortType::Midi, midi, node);
+        audio = midi = node;
+    }
+    connect (*sub, PortType::Audio, audio, io.audioOut, 2);
+    connect (*sub, PortType::Midi, midi, io.midiOut);
+    return sub;
+}
+
+/** Parallel subgraphs, each nested a few levels deep. */
+void buildNested (GraphNode& graph, int numSubgraphs, int depth)
+{
+    const auto io = addIONodes (graph);
+    for (int i = 0; i < numSubgraphs; ++i)
+    {
+        const auto node = graph.addNode (createSubgraph (depth))->nodeId;
+        connect (graph, PortType::Audio, io.audioIn, node, 2);
+        connect (graph, PortType::Midi, io.midiIn, node);
+        connect (graph, PortType::Audio, node, io.audioOut, 2);
+        connect (graph, PortType::Midi, node, io.midiOut);
+    }
+}
+
+/** A chain passing audio, MIDI, CV and atom ports, with the internal routers in the middle. */
+void buildMixed (GraphNode& graph, int length)
+{
+    const auto io = addIONodes (graph);
+    NodeFactory factory;
+    auto audio = io.audioIn, midi = io.midiIn;
+    uint32 cv = 0, atom = 0;
+
+    for (int i = 0; i < length; ++i)
+    {
+        uint32 node = 0;
+        if (i == length / 2)
+        {
+            if (auto* router = factory.instantiate (EL_NODE_ID_AUDIO_ROUTER))
+            {
+                node = graph.addNode (router)->nodeId;
+                connect (graph, PortType::Audio, audio, node, 2);
+                audio = node;
+            }
+            if (auto* router = factory.instantiate (EL_NODE_ID_MIDI_ROUTER))
+            {
+                node = graph.addNode (router)->nodeId;
+                connect (graph, PortType::Midi, midi, node);
+                midi = node;
+            }
+            continue;
+        }
+
+        node = graph.addNode (new BenchNode (2, 2, 1, 1, 2, 2, 1, 1))->nodeId;
+        connect (graph, PortType::Audio, audio, node, 2);
+        connect (graph, PortType::Midi, midi, node);
+        if (cv != 0)
+            connect (graph, PortType::CV, cv, node, 2);
+        if (atom != 0)
+            connect (graph, PortType::Atom, atom, node);
+        audio = midi = cv = atom = node;
+    }
+
+    connect (graph, PortType::Audio, audio, io.audioOut, 2);
+    connect (graph, PortType::Midi, midi, io.midiOut);
+}
+
+struct Case {
+    String name;
+    std::function<void (GraphNode&)> build;
+};
+
+double ticksToMicros (int64 ticks)
+{
+    return Time::highResolutionTicksToSeconds (ticks) * 1000000.0;
+}
+
+var runCase (const Case& benchCase, double sampleRate, int blockSize, int numThreads, int numBlocks)
+{
+    const int numBuilds = 20;
+    const int numWarmup = 64;
+
+    PreparedGraph fixture (sampleRate, blockSize);
+    auto& graph = fixture.graph;
+    benchCase.build (graph);
+
+    // building the rendering sequence.
+    double buildMin = std::numeric_limits<double>::max(), buildTotal = 0.0;
+    for (int i = 0; i < numBuilds; ++i)
+    {
+        const auto start = Time::getHighResolutionTicks();
+        graph.rebuild();
+        const auto micros = ticksToMicros (Time::getHighResolutionTicks() - start);
+        buildMin = jmin (buildMin, micros);
+        buildTotal += micros;
+    }
+
+    // rendering.
+    AudioSampleBuffer audio (2, blockSize), cv (1, blockSize);
+    MidiBuffer midi;
+    midi.ensureSize (2048);
+    AtomBuffer atom;
+    std::vector<double> times;
+    times.reserve ((size_t) numBlocks);
+    numAllocations.store (0);
+
+    for (int i = 0; i < numWarmup + numBlocks; ++i)
+    {
+        for (int c = 0; c < audio.getNumChannels(); ++c)
+            FloatVectorOperations::fill (audio.getWritePointer (c), 0.25f, blockSize);
+        cv.clear();
+        midi.clear();
+        if (i % 8 == 0)
+            midi.addEvent (MidiMessage::noteOn (1, 60, (uint8) 100), 0);
+        else if (i % 8 == 4)
+            midi.addEvent (MidiMessage::noteOff (1, 60), blockSize / 2);
+
+        RenderContext rc (audio, cv, midi, atom, blockSize);
+        const bool measured = i >= numWarmup;
+        countAllocations.store (measured);
+        const auto start = Time::getHighResolutionTicks();
+        graph.render (rc);
+        const auto ticks = Time::getHighResolutionTicks() - start;
+        countAllocations.store (false);
+        if (measured)
+            times.push_back (ticksToMicros (ticks));
+    }
+
+    std::sort (times.begin(), times.end());
+    double total = 0.0;
+    for (auto t : times)
+        total += t;
+    const double avg = total / (double) times.size();
+    const double budget = (double) blockSize / sampleRate * 1000000.0;
+
+    auto* result = new DynamicObject();
+    result->setProperty ("graph", benchCase.name);
+    result->setProperty ("nodes", graph.getNumNodes());
+    result->setProperty ("connections", graph.getNumConnections());
+    result->setProperty ("blockSize", blockSize);
+    result->setProperty ("threads", numThreads);
+    result->setProperty ("blocks", numBlocks);
+    result->setProperty ("buildMinMicros", buildMin);
+    result->setProperty ("buildAvgMicros", buildTotal / numBuilds);
+    result->setProperty ("renderMinMicros", times.front());
+    result->setProperty ("renderAvgMicros", avg);
+    result->setProperty ("renderP99Micros", times[jmin (times.size() - 1, (size_t) ((double) times.size() * 0.99))]);
+    result->setProperty ("renderMaxMicros", times.back());
+    result->setProperty ("budgetPercent", avg / budget * 100.0);
+    result->setProperty ("allocationsPerBlock", (double) numAllocations.load() / (double) numBlocks);
+    result->setProperty ("countsMalloc", EL_BENCH_COUNTS_MALLOC != 0);
+    return var (result);
+}
+
+Array<int> parseBlockSizes (const String& text)
+{
+    Array<int> sizes;
+    for (const auto& token : StringArray::fromTokens (text, ",", {}))
+        if (token.getIntValue() > 0)
+            sizes.add (token.getIntValue());
+    return sizes;
+}
+
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInit;
+    const ArgumentList args (argc, argv);
+
+    const double sampleRate = 48000.0;
+    const int numBlocks = args.containsOption ("--blocks") ? jmax (1, args.getValueForOption ("--blocks").getIntValue()) : 2000;
+    auto blockSizes = parseBlockSizes (args.getValueForOption ("--block-sizes"));
+    if (blockSizes.isEmpty())
+        blockSizes = Array<int> { 64, 256, 1024 };
+
+    Array<int> threadCounts { 0 };
+    const auto threadsOption = args.getValueForOption ("--threads");
+    const int maxThreads = threadsOption == "max" ? RenderPool::getMaxWorkers()
+                                                  : jmin (threadsOption.getIntValue(), RenderPool::getMaxWorkers());
+    if (maxThreads > 0)
+        threadCounts.add (maxThreads);
+
+    const std::vector<Case> cases {
+        { "chain", [] (GraphNode& g) { buildChain (g, 64); } },
+        { "fan", [] (GraphNode& g) { buildFan (g, 32); } },
+        { "nested", [] (GraphNode& g) { buildNested (g, 4, 3); } },
+        { "mixed", [] (GraphNode& g) { buildMixed (g, 16); } }
+    };
+
+    Array<var> results;
+    auto& pool = element::test::context()->audio()->getRenderPool();
+    for (const auto numThreads : threadCounts)
+    {
+        pool.setNumWorkers (numThreads);
+        for (const auto& benchCase : cases)
+        {
+            for (const auto blockSize : blockSizes)
+            {
+                auto result = runCase (benchCase, sampleRate, blockSize, numThreads, numBlocks);
+                std::clog << benchCase.name << " " << blockSize << " threads=" << numThreads
+                          << ": " << String ((double) result["renderAvgMicros"], 2) << " us avg, "
+                          << String ((double) result["allocationsPerBlock"], 2) << " allocs/block" << std::endl;
+                results.add (result);
+            }
+        }
+    }
+    pool.setNumWorkers (0);
+
+    auto* root = new DynamicObject();
+    root->setProperty ("version", String (EL_VERSION_STRING));
+    root->setProperty ("sampleRate", sampleRate);
+    root->setProperty ("results", results);
+    const auto json = JSON::toString (var (root));
+
+    const auto output = args.getValueForOption ("--output");
+    if (output.isNotEmpty())
+    {
+        const auto file = File::getCurrentWorkingDirectory().getChildFile (output);
+        if (! file.replaceWithText (json))
+        {
+            std::cerr << "could not write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+
+    element::test::resetContext();
+    return 0;
+}
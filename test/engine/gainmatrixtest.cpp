@@ -0,0 +1,128 @@
+
+#include <boost/test/unit_test.hpp>
+
+#include <element/processor.hpp>
+
+#include "engine/gainmatrix.hpp"
+#include "nodes/audiorouter.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+/** Renders one block of constant input through a router. */
+struct RouterBlock {
+    explicit RouterBlock (int numChannels, int numFrames)
+    {
+        audio.setSize (numChannels, numFrames, false, true, false);
+    }
+
+    void render (AudioRouterNode& router)
+    {
+        for (int c = 0; c < audio.getNumChannels(); ++c)
+            FloatVectorOperations::fill (audio.getWritePointer (c), (float) (c + 1), audio.getNumSamples());
+        midi.clear();
+        RenderContext rc (audio, cv, midi, atoms, audio.getNumSamples());
+        router.render (rc);
+    }
+
+    float first (int channel) const { return audio.getSample (channel, 0); }
+    float last (int channel) const { return audio.getSample (channel, audio.getNumSamples() - 1); }
+
+    AudioSampleBuffer audio, cv;
+    MidiBuffer midi;
+    AtomBuffer atoms;
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (GainMatrixTest)
+
+BOOST_AUTO_TEST_CASE (Basics)
+{
+    GainMatrix gains (3, 5);
+    BOOST_REQUIRE_EQUAL (gains.size(), 15);
+    BOOST_REQUIRE_EQUAL (gains.index (2, 4), 14);
+    BOOST_REQUIRE_EQUAL (gains.get (1, 1), 0.0f);
+
+    gains.set (1, 2, 0.5f);
+    BOOST_REQUIRE_EQUAL (gains.get (1, 2), 0.5f);
+    BOOST_REQUIRE_EQUAL (gains.getData()[gains.index (1, 2)], 0.5f);
+
+    GainMatrix copy (3, 5);
+    BOOST_REQUIRE (copy.sameSizeAs (gains));
+    copy.copyFrom (gains);
+    BOOST_REQUIRE_EQUAL (copy.get (1, 2), 0.5f);
+    copy.clear();
+    BOOST_REQUIRE_EQUAL (copy.get (1, 2), 0.0f);
+
+    MatrixState matrix (6, 6);
+    matrix.set (3, 4, true);
+    GainMatrix fromState (matrix);
+    BOOST_REQUIRE_EQUAL (fromState.getNumInputs(), 6);
+    BOOST_REQUIRE_EQUAL (fromState.get (3, 4), 1.0f);
+    BOOST_REQUIRE_EQUAL (fromState.get (4, 3), 0.0f);
+}
+
+BOOST_AUTO_TEST_CASE (Kernels)
+{
+    float src[8], dst[8];
+    FloatVectorOperations::fill (src, 2.0f, 8);
+    FloatVectorOperations::clear (dst, 8);
+
+    GainMatrix::addWithRamp (dst, src, 8, 0.0f, 0.125f);
+    BOOST_REQUIRE_CLOSE (dst[0], 0.25f, 0.001f);
+    BOOST_REQUIRE_CLOSE (dst[7], 2.0f, 0.001f);
+
+    GainMatrix::addWithGain (dst, src, 8, 1.0f);
+    BOOST_REQUIRE_CLOSE (dst[7], 4.0f, 0.001f);
+    GainMatrix::addWithGain (dst, src, 8, 0.0f);
+    BOOST_REQUIRE_CLOSE (dst[7], 4.0f, 0.001f);
+}
+
+BOOST_AUTO_TEST_CASE (RouterCrossfades)
+{
+    AudioRouterNode router (2, 2);
+    router.prepareToRender (1000.0, 64);
+    router.setFadeLength (0.016); // 16 frames
+
+    // starts silent and fades into the default 1 to 1 routing.
+    RouterBlock block (2, 64);
+    block.render (router);
+    BOOST_REQUIRE (block.first (0) > 0.0f && block.first (0) < 1.0f);
+    BOOST_REQUIRE_EQUAL (block.last (0), 1.0f);
+    BOOST_REQUIRE_EQUAL (block.last (1), 2.0f);
+
+    MatrixState swapped (2, 2);
+    swapped.set (0, 1, true);
+    swapped.set (1, 0, true);
+    router.setMatrixState (swapped);
+
+    block.render (router);
+    BOOST_REQUIRE (block.first (0) > 1.0f && block.first (0) < 2.0f);
+    BOOST_REQUIRE_EQUAL (block.last (0), 2.0f);
+    BOOST_REQUIRE_EQUAL (block.last (1), 1.0f);
+
+    block.render (router);
+    BOOST_REQUIRE_EQUAL (block.first (0), 2.0f);
+    BOOST_REQUIRE_EQUAL (block.first (1), 1.0f);
+}
+
+BOOST_AUTO_TEST_CASE (RouterResizes)
+{
+    AudioRouterNode router (2, 2);
+    router.setSize (64, 64, false);
+    BOOST_REQUIRE (router.getSizeString() == "64x64");
+
+    MatrixState matrix (64, 64);
+    matrix.set (63, 0, true);
+    router.setMatrixState (matrix);
+
+    RouterBlock block (64, 32);
+    block.render (router);
+    block.render (router);
+    BOOST_REQUIRE_EQUAL (block.last (0), 64.0f);
+    for (int c = 1; c < 64; ++c)
+        BOOST_REQUIRE_EQUAL (block.last (c), 0.0f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
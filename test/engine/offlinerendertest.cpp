@@ -0,0 +1,303 @@
+
+#include <boost/test/unit_test.hpp>
+
+#include <element/audioengine.hpp>
+#include <element/context.hpp>
+#include <element/engine.hpp>
+#include <element/juce/audio_formats.hpp>
+#include <element/nodefactory.hpp>
+#include <element/plugins.hpp>
+#include <element/portcount.hpp>
+#include <element/session.hpp>
+
+#include "engine/ionode.hpp"
+#include "engine/rootgraph.hpp"
+#include "testutil.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+int64 readLength (const File& file, int& numChannels)
+{
+    WavAudioFormat wav;
+    std::unique_ptr<AudioFormatReader> reader (wav.createReaderFor (new FileInputStream (file), true));
+    if (reader == nullptr)
+        return -1;
+    numChannels = (int) reader->numChannels;
+    return reader->lengthInSamples;
+}
+
+bool readSamples (const File& file, AudioBuffer<float>& buffer)
+{
+    WavAudioFormat wav;
+    std::unique_ptr<AudioFormatReader> reader (wav.createReaderFor (new FileInputStream (file), true));
+    if (reader == nullptr)
+        return false;
+    buffer.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);
+    return reader->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
+}
+
+/** A sine following the transport, so every render from zero is the same. */
+class ToneNode : public Processor {
+public:
+    ToneNode() : Processor (0)
+    {
+        setName ("Tone");
+        ToneNode::refreshPorts();
+    }
+
+    bool sawRealtime = false, sawNonRealtime = false;
+
+    void prepareToRender (double newSampleRate, int newBlockSize) override
+    {
+        setRenderDetails (newSampleRate, newBlockSize);
+    }
+
+    void releaseResources() override {}
+
+    void render (RenderContext& rc) override
+    {
+        (isNonRealtime() ? sawNonRealtime : sawRealtime) = true;
+
+        int64 frame = 0;
+        if (auto* playhead = getPlayHead())
+            if (auto pos = playhead->getPosition())
+                frame = pos->getTimeInSamples().orFallback (0);
+
+        for (int i = 0; i < rc.audio.getNumSamples(); ++i)
+        {
+            const auto value = 0.5f * (float) std::sin (MathConstants<double>::twoPi * 441.0 * (double) (frame + i) / getSampleRate());
+            for (int c = 0; c < rc.audio.getNumChannels(); ++c)
+                rc.audio.setSample (c, i, value);
+        }
+    }
+
+    void renderBypassed (RenderContext&) override {}
+
+    int getNumPrograms() const override { return 1; }
+    int getCurrentProgram() const override { return 0; }
+    const String getProgramName (int) const override { return "program"; }
+    void setCurrentProgram (int) override {}
+
+    void getState (MemoryBlock&) override {}
+    void setState (const void*, int) override {}
+
+    void refreshPorts() override { setPorts (PortCount().with (PortType::Audio, 0, 2).toPortList()); }
+
+protected:
+    void initialize() override {}
+};
+
+/** Makes the tone loadable from a session. */
+class ToneProvider : public NodeProvider {
+public:
+    String format() const override { return EL_NODE_FORMAT_NAME; }
+    Processor* create (const String& ID) override { return ID == "test.tone" ? new ToneNode() : nullptr; }
+    StringArray findTypes (const FileSearchPath&, bool, bool) override { return { "test.tone" }; }
+};
+
+/** A session with the tone wired to the audio output. */
+ValueTree makeToneSession()
+{
+    auto graph = Node::createDefaultGraph ("Tone");
+    ValueTree tone (types::Node);
+    tone.setProperty (tags::id, (int64) 5, nullptr)
+        .setProperty (tags::type, "plugin", nullptr)
+        .setProperty (tags::format, EL_NODE_FORMAT_NAME, nullptr)
+        .setProperty (tags::identifier, "test.tone", nullptr)
+        .setProperty (tags::name, "Tone", nullptr);
+    graph.getNodesValueTree().addChild (tone, -1, nullptr);
+
+    // the default graph's audio output is node 2.
+    auto arcs = graph.getArcsValueTree();
+    arcs.addChild (Node::makeArc (Arc (5, 0, 2, 0)), -1, nullptr);
+    arcs.addChild (Node::makeArc (Arc (5, 1, 2, 1)), -1, nullptr);
+
+    ValueTree data (types::Session);
+    auto graphs = data.getOrCreateChildWithName (tags::graphs, nullptr);
+    graphs.addChild (graph.data(), -1, nullptr);
+    graphs.setProperty (tags::active, 0, nullptr);
+    return data;
+}
+
+void writeMidiFile (const File& file, double endSeconds)
+{
+    MidiMessageSequence track;
+    // 120 bpm by default, so two quarter notes per second.
+    const double ticksPerSecond = 960.0 * 2.0;
+    track.addEvent (MidiMessage::noteOn (1, 60, (uint8) 100), 0.0);
+    track.addEvent (MidiMessage::noteOff (1, 60), endSeconds * ticksPerSecond);
+    track.updateMatchedPairs();
+
+    MidiFile midi;
+    midi.setTicksPerQuarterNote (960);
+    midi.addTrack (track);
+    FileOutputStream out (file);
+    out.setPosition (0);
+    out.truncate();
+    midi.writeTo (out);
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (OfflineRenderTest)
+
+BOOST_AUTO_TEST_CASE (NeedsLengthOrMidi)
+{
+    Context context (RunMode::Standalone);
+    TemporaryFile output (".wav");
+    AudioEngine::OfflineRender options;
+    options.output = output.getFile();
+    BOOST_REQUIRE (context.audio()->renderOffline (options).failed());
+}
+
+BOOST_AUTO_TEST_CASE (RendersLengthAndTail)
+{
+    Context context (RunMode::Standalone);
+    TemporaryFile output (".wav");
+    AudioEngine::OfflineRender options;
+    options.output = output.getFile();
+    options.sampleRate = 44100.0;
+    options.blockSize = 512;
+    options.lengthSeconds = 0.5;
+    options.tailSeconds = 0.25;
+
+    int blocks = 0;
+    options.progress = [&blocks] (double) { ++blocks; return true; };
+
+    BOOST_REQUIRE (context.audio()->renderOffline (options).wasOk());
+    int numChannels = 0;
+    BOOST_REQUIRE_EQUAL (readLength (output.getFile(), numChannels), (int64) 33075);
+    BOOST_REQUIRE_EQUAL (numChannels, 2);
+    BOOST_REQUIRE_EQUAL (blocks, 65);
+}
+
+BOOST_AUTO_TEST_CASE (LengthFromMidiFile)
+{
+    Context context (RunMode::Standalone);
+    TemporaryFile midi (".mid"), output (".wav");
+    writeMidiFile (midi.getFile(), 1.0);
+
+    AudioEngine::OfflineRender options;
+    options.output = output.getFile();
+    options.midiInput = midi.getFile();
+    options.sampleRate = 48000.0;
+    options.numChannels = 1;
+    options.tailSeconds = 0.0;
+
+    BOOST_REQUIRE (context.audio()->renderOffline (options).wasOk());
+    int numChannels = 0;
+    BOOST_REQUIRE_EQUAL (readLength (output.getFile(), numChannels), (int64) 48000);
+    BOOST_REQUIRE_EQUAL (numChannels, 1);
+}
+
+BOOST_AUTO_TEST_CASE (RendersTheSameTwice)
+{
+    Context context (RunMode::Standalone);
+    ReferenceCountedObjectPtr<RootGraph> root (new RootGraph (context));
+    auto* tone = new ToneNode();
+    root->addNode (tone);
+    const auto output = root->addNode (new IONode (IONode::audioOutputNode))->nodeId;
+    root->connectChannels (PortType::Audio, tone->nodeId, 0, output, 0);
+    root->connectChannels (PortType::Audio, tone->nodeId, 1, output, 1);
+    context.audio()->addGraph (root.get());
+
+    TemporaryFile first (".wav"), second (".wav");
+    AudioEngine::OfflineRender options;
+    options.sampleRate = 44100.0;
+    options.blockSize = 300;
+    options.lengthSeconds = 0.25;
+    options.tailSeconds = 0.0;
+
+    options.output = first.getFile();
+    BOOST_REQUIRE (context.audio()->renderOffline (options).wasOk());
+    options.output = second.getFile();
+    BOOST_REQUIRE (context.audio()->renderOffline (options).wasOk());
+    context.audio()->removeGraph (root.get());
+
+    // the graph rendered without a deadline, and is realtime again after.
+    BOOST_REQUIRE (tone->sawNonRealtime);
+    BOOST_REQUIRE (! tone->sawRealtime);
+    BOOST_REQUIRE (! root->isNonRealtime());
+    BOOST_REQUIRE (! tone->isNonRealtime());
+
+    AudioBuffer<float> a, b;
+    BOOST_REQUIRE (readSamples (first.getFile(), a));
+    BOOST_REQUIRE (readSamples (second.getFile(), b));
+    BOOST_REQUIRE_EQUAL (a.getNumSamples(), 11025);
+    BOOST_REQUIRE_EQUAL (a.getNumSamples(), b.getNumSamples());
+    BOOST_REQUIRE (a.getMagnitude (0, 0, a.getNumSamples()) > 0.4f);
+    for (int c = 0; c < a.getNumChannels(); ++c)
+        for (int i = 0; i < a.getNumSamples(); ++i)
+            BOOST_REQUIRE_EQUAL (a.getSample (c, i), b.getSample (c, i));
+}
+
+BOOST_AUTO_TEST_CASE (RendersLoadedSession)
+{
+    auto* const context = test::context();
+    static bool providerAdded = false;
+    if (! providerAdded)
+        context->plugins().getNodeFactory().add (new ToneProvider());
+    providerAdded = true;
+
+    auto* const graphs = context->services().find<EngineService>();
+    BOOST_REQUIRE (graphs != nullptr);
+
+    // nodes load asynchronously, the same as opening a session in the app.
+    bool loaded = false;
+    SignalConnection connection = graphs->sigGraphsLoaded.connect ([&loaded]() { loaded = true; });
+    BOOST_REQUIRE (context->session()->loadData (makeToneSession()));
+    graphs->sessionReloaded();
+    for (int i = 0; i < 250 && ! loaded; ++i)
+        MessageManager::getInstance()->runDispatchLoopUntil (20);
+    connection.disconnect();
+    BOOST_REQUIRE (loaded);
+
+    TemporaryFile output (".wav");
+    AudioEngine::OfflineRender options;
+    options.output = output.getFile();
+    options.sampleRate = 44100.0;
+    options.blockSize = 512;
+    options.lengthSeconds = 0.25;
+    options.tailSeconds = 0.0;
+    const auto result = context->audio()->renderOffline (options);
+
+    context->session()->loadData (ValueTree (types::Session));
+    graphs->sessionReloaded();
+
+    BOOST_REQUIRE (result.wasOk());
+    AudioBuffer<float> rendered;
+    BOOST_REQUIRE (readSamples (output.getFile(), rendered));
+    BOOST_REQUIRE_EQUAL (rendered.getNumSamples(), 11025);
+    BOOST_REQUIRE (rendered.getMagnitude (0, 0, rendered.getNumSamples()) > 0.4f);
+}
+
+BOOST_AUTO_TEST_CASE (Cancel)
+{
+    Context context (RunMode::Standalone);
+    TemporaryFile output (".wav");
+    AudioEngine::OfflineRender options;
+    options.output = output.getFile();
+    options.lengthSeconds = 10.0;
+    options.progress = [] (double progress) { return progress < 0.1; };
+    BOOST_REQUIRE (context.audio()->renderOffline (options).failed());
+}
+
+BOOST_AUTO_TEST_CASE (RejectsBadOutput)
+{
+    Context context (RunMode::Standalone);
+    AudioEngine::OfflineRender options;
+    options.lengthSeconds = 1.0;
+
+    TemporaryFile mp3 (".mp3");
+    options.output = mp3.getFile();
+    BOOST_REQUIRE (context.audio()->renderOffline (options).failed());
+
+    // no graphs to write stems for.
+    TemporaryFile wav (".wav");
+    options.output = wav.getFile();
+    options.stems = true;
+    BOOST_REQUIRE (context.audio()->renderOffline (options).failed());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
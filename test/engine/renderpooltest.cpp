@@ -0,0 +1,174 @@
+
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+#include "engine/renderpool.hpp"
+
+using namespace element;
+
+namespace {
+/** Claims task indexes until none are left. */
+struct CountingJob : public RenderPool::Job {
+    explicit CountingJob (int total) : numTasks (total), counts (new std::atomic<int>[(size_t) total])
+    {
+        for (int i = 0; i < numTasks; ++i)
+            counts[i].store (0);
+    }
+
+    void perform() noexcept override
+    {
+        int index;
+        while ((index = next.fetch_add (1)) < numTasks)
+            counts[index].fetch_add (1);
+    }
+
+    const int numTasks;
+    std::unique_ptr<std::atomic<int>[]> counts;
+    std::atomic<int> next { 0 };
+};
+
+struct CountingTasks : public RenderPool::Tasks {
+    explicit CountingTasks (int total) : numTasks (total), counts (new std::atomic<int>[(size_t) total])
+    {
+        for (int i = 0; i < numTasks; ++i)
+            counts[i].store (0);
+    }
+
+    void perform (int index) noexcept override { counts[index].fetch_add (1); }
+
+    bool allOnce() const
+    {
+        for (int i = 0; i < numTasks; ++i)
+            if (counts[i].load() != 1)
+                return false;
+        return true;
+    }
+
+    const int numTasks;
+    std::unique_ptr<std::atomic<int>[]> counts;
+};
+
+/** Runs tasks from one thread of a job while the others wait for it. */
+struct TasksInJob : public RenderPool::Job {
+    explicit TasksInJob (RenderPool& p) : pool (p), tasks (64) {}
+    void perform() noexcept override
+    {
+        if (claimed.exchange (true))
+        {
+            while (! finished.load())
+                if (! pool.helpWithTasks())
+                    std::this_thread::yield();
+            return;
+        }
+
+        ran.store (pool.runTasks (tasks, tasks.numTasks));
+        finished.store (true);
+    }
+
+    RenderPool& pool;
+    CountingTasks tasks;
+    std::atomic<bool> claimed { false }, finished { false }, ran { false };
+};
+
+struct NestedJob : public RenderPool::Job {
+    explicit NestedJob (RenderPool& p) : pool (p) {}
+    void perform() noexcept override
+    {
+        CountingJob inner (4);
+        if (pool.run (inner))
+            nestedRan.store (true);
+    }
+
+    RenderPool& pool;
+    std::atomic<bool> nestedRan { false };
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (RenderPoolTest)
+
+BOOST_AUTO_TEST_CASE (NoWorkers)
+{
+    RenderPool pool;
+    CountingJob job (8);
+    BOOST_REQUIRE_EQUAL (pool.getNumWorkers(), 0);
+    BOOST_REQUIRE (! pool.run (job));
+    BOOST_REQUIRE_EQUAL (job.next.load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE (PerformsEveryTaskOnce)
+{
+    if (RenderPool::getMaxWorkers() <= 0)
+        return;
+
+    RenderPool pool;
+    pool.setNumWorkers (RenderPool::getMaxWorkers());
+    BOOST_REQUIRE (pool.getNumWorkers() > 0);
+
+    for (int block = 0; block < 64; ++block)
+    {
+        CountingJob job (257);
+        BOOST_REQUIRE (pool.run (job));
+        for (int i = 0; i < job.numTasks; ++i)
+            BOOST_REQUIRE_EQUAL (job.counts[i].load(), 1);
+    }
+
+    pool.setNumWorkers (0);
+    BOOST_REQUIRE_EQUAL (pool.getNumWorkers(), 0);
+}
+
+BOOST_AUTO_TEST_CASE (NestedRunsAreRejected)
+{
+    if (RenderPool::getMaxWorkers() <= 0)
+        return;
+
+    RenderPool pool;
+    pool.setNumWorkers (1);
+    NestedJob job (pool);
+    BOOST_REQUIRE (pool.run (job));
+    BOOST_REQUIRE (! job.nestedRan.load());
+}
+
+BOOST_AUTO_TEST_CASE (TasksNeedWorkers)
+{
+    RenderPool pool;
+    CountingTasks tasks (8);
+    BOOST_REQUIRE (! pool.runTasks (tasks, tasks.numTasks));
+    BOOST_REQUIRE_EQUAL (tasks.counts[0].load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE (PerformsEveryTaskInSetOnce)
+{
+    if (RenderPool::getMaxWorkers() <= 0)
+        return;
+
+    RenderPool pool;
+    pool.setNumWorkers (RenderPool::getMaxWorkers());
+
+    for (int block = 0; block < 64; ++block)
+    {
+        CountingTasks tasks (33);
+        BOOST_REQUIRE (pool.runTasks (tasks, tasks.numTasks));
+        BOOST_REQUIRE (tasks.allOnce());
+    }
+
+    const auto stats = pool.getStats();
+    BOOST_REQUIRE_EQUAL (stats.taskSets, (juce::int64) 64);
+    BOOST_REQUIRE_EQUAL (stats.tasks, (juce::int64) 64 * 33);
+    BOOST_REQUIRE (stats.stolenTasks <= stats.tasks);
+}
+
+BOOST_AUTO_TEST_CASE (TasksRunInsideJobs)
+{
+    if (RenderPool::getMaxWorkers() <= 0)
+        return;
+
+    RenderPool pool;
+    pool.setNumWorkers (RenderPool::getMaxWorkers());
+    TasksInJob job (pool);
+    BOOST_REQUIRE (pool.run (job));
+    BOOST_REQUIRE (job.ran.load());
+    BOOST_REQUIRE (job.tasks.allOnce());
+    BOOST_REQUIRE_EQUAL (pool.getStats().jobs, (juce::int64) 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,74 @@
+
+#include <boost/test/unit_test.hpp>
+#include "engine/renderprofile.hpp"
+
+using namespace element;
+
+namespace {
+int64 ticksForMicros (double micros)
+{
+    return (int64) (micros * 1.0e-6 * (double) Time::getHighResolutionTicksPerSecond());
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (RenderProfileTest)
+
+BOOST_AUTO_TEST_CASE (Empty)
+{
+    RenderProfile profile;
+    const auto stats = profile.getStats();
+    BOOST_REQUIRE_EQUAL (stats.blocks, (int64) 0);
+    BOOST_REQUIRE_EQUAL (stats.avgMicros, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE (Statistics)
+{
+    RenderProfile profile;
+    // 100 blocks taking 1..100us, each with a 1000us budget.
+    for (int i = 1; i <= 100; ++i)
+        profile.record (ticksForMicros (i), 48, 48000.0);
+
+    const auto stats = profile.getStats();
+    BOOST_REQUIRE_EQUAL (stats.blocks, (int64) 100);
+    BOOST_REQUIRE_CLOSE (stats.minMicros, 1.0, 1.0);
+    BOOST_REQUIRE_CLOSE (stats.maxMicros, 100.0, 1.0);
+    BOOST_REQUIRE_CLOSE (stats.avgMicros, 50.5, 1.0);
+    BOOST_REQUIRE (stats.p99Micros >= 98.0 && stats.p99Micros <= 100.5);
+    BOOST_REQUIRE_CLOSE (stats.budgetPercent, 5.05, 1.0);
+    BOOST_REQUIRE_CLOSE (stats.peakBudgetPercent, 10.0, 1.0);
+}
+
+BOOST_AUTO_TEST_CASE (WindowAndReset)
+{
+    RenderProfile profile;
+    for (int i = 0; i < RenderProfile::windowSize; ++i)
+        profile.record (ticksForMicros (500.0), 64, 48000.0);
+    BOOST_REQUIRE_CLOSE (profile.getStats().maxMicros, 500.0, 1.0);
+
+    // older blocks fall out of the window.
+    for (int i = 0; i < RenderProfile::windowSize; ++i)
+        profile.record (ticksForMicros (10.0), 64, 48000.0);
+    const auto stats = profile.getStats();
+    BOOST_REQUIRE_CLOSE (stats.maxMicros, 10.0, 1.0);
+    BOOST_REQUIRE_EQUAL (stats.blocks, (int64) RenderProfile::windowSize * 2);
+
+    profile.reset();
+    BOOST_REQUIRE_EQUAL (profile.getStats().blocks, (int64) 0);
+}
+
+BOOST_AUTO_TEST_CASE (FullRingKeepsNewest)
+{
+    RenderProfile profile;
+    // nobody reads while the ring fills, the oldest blocks are overwritten.
+    for (int i = 0; i < 1000; ++i)
+        profile.record (ticksForMicros (500.0), 64, 48000.0);
+    for (int i = 0; i < 1000; ++i)
+        profile.record (ticksForMicros (1.0), 64, 48000.0);
+
+    const auto stats = profile.getStats();
+    BOOST_REQUIRE (stats.dropped > 0);
+    BOOST_REQUIRE_EQUAL (stats.blocks + stats.dropped, (int64) 2000);
+    BOOST_REQUIRE_CLOSE (stats.maxMicros, 1.0, 1.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
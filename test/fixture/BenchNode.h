@@ -0,0 +1,63 @@
+#pragma once
+
+#include <element/portcount.hpp>
+#include <element/processor.hpp>
+
+namespace element {
+
+/** A node with any mix of ports that does a little work on each of them.
+    Used to build synthetic graphs for benchmarks. */
+class BenchNode : public Processor {
+public:
+    BenchNode (int audioIns, int audioOuts, int midiIns = 0, int midiOuts = 0, int cvIns = 0, int cvOuts = 0, int atomIns = 0, int atomOuts = 0)
+        : Processor (0)
+    {
+        count.set (PortType::Audio, audioIns, audioOuts);
+        count.set (PortType::Midi, midiIns, midiOuts);
+        count.set (PortType::CV, cvIns, cvOuts);
+        count.set (PortType::Atom, atomIns, atomOuts);
+        setName ("Bench");
+        BenchNode::refreshPorts();
+    }
+
+    void prepareToRender (double newSampleRate, int newBlockSize) override
+    {
+        setRenderDetails (newSampleRate, newBlockSize);
+    }
+
+    void releaseResources() override {}
+
+    bool wantsContext() const noexcept override { return true; }
+    void render (RenderContext& rc) override
+    {
+        rc.audio.applyGain (0.5f);
+        rc.cv.applyGain (0.5f);
+    }
+
+    void renderBypassed (RenderContext&) override {}
+
+    int getNumPrograms() const override { return 1; }
+    int getCurrentProgram() const override { return 0; }
+    const String getProgramName (int) const override { return "program"; }
+    void setCurrentProgram (int) override {}
+
+    void getState (MemoryBlock&) override {}
+    void setState (const void*, int) override {}
+
+    void getPluginDescription (PluginDescription& desc) const override
+    {
+        desc.pluginFormatName = "Element";
+        desc.fileOrIdentifier = "element.benchNode";
+        desc.manufacturerName = "Element";
+    }
+
+    void refreshPorts() override { setPorts (count.toPortList()); }
+
+protected:
+    void initialize() override {}
+
+private:
+    PortCount count;
+};
+
+} // namespace element
@@ -0,0 +1,117 @@
+
+#include <boost/test/unit_test.hpp>
+#include "lv2/workthread.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+class TestWorker final : public WorkerBase
+{
+public:
+    TestWorker (WorkerPool& pool, int delayMs = 0)
+        : WorkerBase (pool, 1024), delay (delayMs) {}
+    ~TestWorker() { stopWork(); }
+
+    bool waitForRequests (int count, int timeoutMs = 5000) const
+    {
+        const auto start = Time::getMillisecondCounter();
+        while (requests.load() < count)
+        {
+            if (Time::getMillisecondCounter() - start > (uint32) timeoutMs)
+                return false;
+            Thread::sleep (1);
+        }
+        return true;
+    }
+
+    std::atomic<int> requests { 0 }, responses { 0 }, concurrent { 0 }, maxConcurrent { 0 };
+    std::atomic<int> lastValue { -1 };
+    std::atomic<bool> ordered { true };
+
+protected:
+    void processRequest (uint32_t size, const void* data) override
+    {
+        const auto now = concurrent.fetch_add (1) + 1;
+        if (now > maxConcurrent.load())
+            maxConcurrent.store (now);
+
+        int value = -1;
+        if (size == sizeof (value))
+            std::memcpy (&value, data, sizeof (value));
+        if (value != lastValue.load() + 1)
+            ordered.store (false);
+        lastValue.store (value);
+
+        if (delay > 0)
+            Thread::sleep (delay);
+        respondToWork (size, data);
+        concurrent.fetch_sub (1);
+        requests.fetch_add (1);
+    }
+
+    void processResponse (uint32_t, const void*) override { responses.fetch_add (1); }
+
+private:
+    const int delay;
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (WorkerPoolTest)
+
+BOOST_AUTO_TEST_CASE (RequestsAndResponses)
+{
+    WorkerPool pool ("test_worker", 2, 4096);
+    TestWorker worker (pool);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        BOOST_REQUIRE (worker.scheduleWork (sizeof (i), &i));
+        if (i % 20 == 19)
+            worker.waitForRequests (i + 1);
+    }
+
+    BOOST_REQUIRE (worker.waitForRequests (100));
+    BOOST_REQUIRE (worker.ordered.load());
+    BOOST_REQUIRE_EQUAL (worker.maxConcurrent.load(), 1);
+
+    worker.processWorkResponses();
+    BOOST_REQUIRE_EQUAL (worker.responses.load(), 100);
+}
+
+BOOST_AUTO_TEST_CASE (SlowWorkerDoesNotBlockOthers)
+{
+    WorkerPool pool ("test_worker", 2, 4096);
+    TestWorker slow (pool, 200), fast (pool);
+
+    int value = 0;
+    BOOST_REQUIRE (slow.scheduleWork (sizeof (value), &value));
+    Thread::sleep (10);
+
+    for (int i = 0; i < 10; ++i)
+        BOOST_REQUIRE (fast.scheduleWork (sizeof (i), &i));
+
+    // handled by the other thread while the slow one is still working.
+    BOOST_REQUIRE (fast.waitForRequests (10, 150));
+    BOOST_REQUIRE (slow.waitForRequests (1));
+}
+
+BOOST_AUTO_TEST_CASE (FullQueueRejects)
+{
+    WorkerPool pool ("test_worker", 1, 64);
+    TestWorker blocker (pool, 100), worker (pool);
+
+    int value = 0;
+    BOOST_REQUIRE (blocker.scheduleWork (sizeof (value), &value));
+    Thread::sleep (10);
+
+    // the only thread is busy, so the queue fills up.
+    int accepted = 0;
+    for (int i = 0; i < 64; ++i)
+        if (worker.scheduleWork (sizeof (i), &i))
+            ++accepted;
+    BOOST_REQUIRE (accepted > 0 && accepted < 64);
+    BOOST_REQUIRE (worker.waitForRequests (accepted));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
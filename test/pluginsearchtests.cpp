@@ -0,0 +1,122 @@
+#include <boost/test/unit_test.hpp>
+
+#include "pluginsearch.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+PluginDescription makePlugin (const String& name, const String& manufacturer, const String& category, const String& format = "VST3")
+{
+    PluginDescription desc;
+    desc.name = name;
+    desc.manufacturerName = manufacturer;
+    desc.category = category;
+    desc.pluginFormatName = format;
+    desc.fileOrIdentifier = "/plugins/" + name + "." + format.toLowerCase();
+    desc.uniqueId = name.hashCode();
+    return desc;
+}
+
+Array<PluginDescription> makePlugins()
+{
+    Array<PluginDescription> types;
+    types.add (makePlugin ("ValhallaRoom", "Valhalla DSP", "Reverb"));
+    types.add (makePlugin ("Pro-Q 3", "FabFilter", "EQ"));
+    types.add (makePlugin ("Pro-R", "FabFilter", "Reverb"));
+    types.add (makePlugin ("Dragonfly Room Reverb", "Michael Willis", "Reverb", "LV2"));
+    types.add (makePlugin ("Surge XT", "Surge Synth Team", "Instrument", "CLAP"));
+    return types;
+}
+
+StringArray names (const Array<PluginDescription>& results)
+{
+    StringArray out;
+    for (const auto& desc : results)
+        out.add (desc.name);
+    return out;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (PluginSearchTests)
+
+BOOST_AUTO_TEST_CASE (Tokenize)
+{
+    const auto tokens = PluginSearchIndex::tokenize ("ValhallaRoom Pro-Q3");
+    BOOST_REQUIRE_EQUAL (tokens.joinIntoString (" "), String ("valhalla room pro q 3"));
+    BOOST_REQUIRE (PluginSearchIndex::tokenize (" -- ").isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE (Ranking)
+{
+    PluginSearchIndex index;
+    index.update (makePlugins());
+    BOOST_REQUIRE_EQUAL (index.size(), 5);
+    BOOST_REQUIRE (index.search ("").isEmpty());
+
+    // name matches rank above category matches, ties sort by name.
+    auto results = names (index.search ("room"));
+    BOOST_REQUIRE_EQUAL (results.joinIntoString ("|"), String ("Dragonfly Room Reverb|ValhallaRoom"));
+
+    results = names (index.search ("reverb"));
+    BOOST_REQUIRE_EQUAL (results.size(), 3);
+    BOOST_REQUIRE_EQUAL (results[0], String ("Dragonfly Room Reverb"));
+
+    // every word has to match, manufacturer included.
+    results = names (index.search ("fabfilter pro q"));
+    BOOST_REQUIRE_EQUAL (results.size(), 1);
+    BOOST_REQUIRE_EQUAL (results[0], String ("Pro-Q 3"));
+
+    results = names (index.search ("pr"));
+    BOOST_REQUIRE_EQUAL (results.size(), 2);
+    BOOST_REQUIRE_EQUAL (index.search ("fabfilter", 1).size(), 1);
+    BOOST_REQUIRE_EQUAL (index.search ("clap").size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE (CamelCasePrefix)
+{
+    PluginSearchIndex index;
+    index.update (makePlugins());
+
+    // "ro" only matches ValhallaRoom through its camel case split.
+    auto results = names (index.search ("ro"));
+    BOOST_REQUIRE_EQUAL (results.joinIntoString ("|"), String ("Dragonfly Room Reverb|ValhallaRoom"));
+
+    results = names (index.search ("valhalla ro"));
+    BOOST_REQUIRE_EQUAL (results.joinIntoString ("|"), String ("ValhallaRoom"));
+}
+
+BOOST_AUTO_TEST_CASE (Typos)
+{
+    PluginSearchIndex index;
+    index.update (makePlugins());
+    const auto results = names (index.search ("dragonfyl"));
+    BOOST_REQUIRE_EQUAL (results.size(), 1);
+    BOOST_REQUIRE_EQUAL (results[0], String ("Dragonfly Room Reverb"));
+    BOOST_REQUIRE (index.search ("xyzzy").isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE (IncrementalUpdates)
+{
+    PluginSearchIndex index;
+    auto types = makePlugins();
+    index.update (types);
+
+    types.remove (0);
+    types.add (makePlugin ("Vital", "Matt Tytel", "Instrument"));
+    types.getReference (0).name = "Pro-Q 4";
+    index.update (types);
+
+    BOOST_REQUIRE_EQUAL (index.size(), 5);
+    BOOST_REQUIRE (index.search ("valhalla").isEmpty());
+    BOOST_REQUIRE_EQUAL (index.search ("vital").size(), 1);
+    const auto results = names (index.search ("pro q"));
+    BOOST_REQUIRE_EQUAL (results.size(), 1);
+    BOOST_REQUIRE_EQUAL (results[0], String ("Pro-Q 4"));
+
+    index.update ({});
+    BOOST_REQUIRE_EQUAL (index.size(), 0);
+    BOOST_REQUIRE (index.search ("pro").isEmpty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
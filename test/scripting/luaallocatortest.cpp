@@ -0,0 +1,68 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include "scripting/luaallocator.hpp"
+#include "sol/sol.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (LuaAllocatorTest)
+
+BOOST_AUTO_TEST_CASE (ServesFromArena)
+{
+    LuaAllocator allocator (1024 * 1024);
+    {
+        sol::state lua (&sol::default_at_panic, &LuaAllocator::alloc, &allocator);
+        lua.open_libraries (sol::lib::base, sol::lib::string, sol::lib::table);
+        lua.script (R"(
+            local t = {}
+            for i = 1, 1000 do t[i] = tostring (i) .. 'x' end
+            result = #t
+        )");
+        BOOST_REQUIRE_EQUAL ((int) lua["result"], 1000);
+
+        const auto stats = allocator.getStats();
+        BOOST_REQUIRE (stats.bytesInUse > 0);
+        BOOST_REQUIRE (stats.arenaUsed > 0);
+        BOOST_REQUIRE (stats.peakBytesInUse >= stats.bytesInUse);
+        BOOST_REQUIRE_EQUAL (stats.fallbacks, 0);
+    }
+
+    BOOST_REQUIRE_EQUAL (allocator.getStats().bytesInUse, (size_t) 0);
+}
+
+BOOST_AUTO_TEST_CASE (FallsBackWhenFull)
+{
+    LuaAllocator allocator (64 * 1024);
+    sol::state lua (&sol::default_at_panic, &LuaAllocator::alloc, &allocator);
+    lua.open_libraries (sol::lib::base, sol::lib::string);
+    lua.script ("big = string.rep ('a', 200000)");
+    BOOST_REQUIRE_EQUAL (lua["big"].get<std::string>().size(), (size_t) 200000);
+    BOOST_REQUIRE (allocator.getStats().fallbacks > 0);
+}
+
+BOOST_AUTO_TEST_CASE (StepsCollectGarbage)
+{
+    LuaAllocator allocator;
+    sol::state lua (&sol::default_at_panic, &LuaAllocator::alloc, &allocator);
+    lua.open_libraries (sol::lib::base, sol::lib::string);
+    allocator.attach (lua.lua_state());
+    allocator.setStepBudget (1000.0);
+
+    lua.script (R"(
+        for i = 1, 20000 do local s = { i, tostring (i) } end
+    )");
+
+    const auto before = allocator.getStats().bytesInUse;
+    for (int i = 0; i < 1000 && allocator.getStats().gcCycles == 0; ++i)
+        allocator.step (lua.lua_state());
+
+    const auto stats = allocator.getStats();
+    BOOST_REQUIRE (stats.gcCycles > 0);
+    BOOST_REQUIRE (stats.gcSteps > 0);
+    BOOST_REQUIRE (stats.bytesInUse < before);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,136 @@
+
+#include <boost/test/unit_test.hpp>
+
+#include <element/node.hpp>
+#include "sessionarchive.hpp"
+
+using namespace element;
+
+namespace {
+MemoryBlock makeState (int size, int seed)
+{
+    MemoryBlock block ((size_t) size);
+    Random rng (seed);
+    for (int i = 0; i < size; ++i)
+        static_cast<uint8*> (block.getData())[i] = (uint8) rng.nextInt (256);
+    return block;
+}
+
+ValueTree makeSession (const MemoryBlock& first, const MemoryBlock& second)
+{
+    ValueTree session (types::Session);
+    session.setProperty (tags::name, "Archive", nullptr);
+    auto graphs = session.getOrCreateChildWithName (tags::graphs, nullptr);
+    auto graph = Node::createDefaultGraph ("Graph").data();
+    graphs.addChild (graph, -1, nullptr);
+
+    auto nodes = graph.getChildWithName (tags::nodes);
+    nodes.getChild (0).setProperty (tags::state, var (first), nullptr);
+    nodes.getChild (1).setProperty (tags::state, var (second), nullptr);
+    nodes.getChild (2).setProperty (tags::state, "small", nullptr);
+    return session;
+}
+
+const var& stateOf (const ValueTree& session, int index)
+{
+    return session.getChildWithName (tags::graphs).getChild (0).getChildWithName (tags::nodes).getChild (index).getProperty (tags::state);
+}
+
+/** Read an archive with every state decoded, as it would be saved. */
+ValueTree readDecoded (const File& file)
+{
+    auto data = SessionArchive::read (file);
+    Node::sanitizeProperties (data, true);
+    return data;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (SessionArchiveTests)
+
+BOOST_AUTO_TEST_CASE (RoundTrip)
+{
+    TemporaryFile temp (".els");
+    const auto first = makeState (4096, 1), second = makeState (10000, 2);
+    auto session = makeSession (first, second);
+
+    BOOST_REQUIRE (SessionArchive::write (session.createCopy(), temp.getFile()).wasOk());
+    BOOST_REQUIRE (SessionArchive::isArchive (temp.getFile()));
+
+    const auto loaded = readDecoded (temp.getFile());
+    BOOST_REQUIRE (loaded.isValid());
+    BOOST_REQUIRE (loaded.isEquivalentTo (session));
+    BOOST_REQUIRE (stateOf (loaded, 0).getBinaryData() != nullptr);
+    BOOST_REQUIRE (*stateOf (loaded, 1).getBinaryData() == second);
+    BOOST_REQUIRE_EQUAL (stateOf (loaded, 2).toString().toStdString(), "small");
+}
+
+BOOST_AUTO_TEST_CASE (StateDecodesOnRestore)
+{
+    TemporaryFile temp (".els");
+    const auto first = makeState (4096, 8), second = makeState (10000, 9);
+    BOOST_REQUIRE (SessionArchive::write (makeSession (first, second), temp.getFile()).wasOk());
+
+    // chunks stay compressed until the node asks for them.
+    const auto loaded = SessionArchive::read (temp.getFile());
+    BOOST_REQUIRE (SessionArchive::LazyState::fromVar (stateOf (loaded, 1)) != nullptr);
+    MemoryBlock block;
+    BOOST_REQUIRE (Node::decodeState (stateOf (loaded, 1), block));
+    BOOST_REQUIRE (block == second);
+
+    // saving a session that was never restored keeps the state.
+    TemporaryFile copy (".els");
+    BOOST_REQUIRE (SessionArchive::write (loaded.createCopy(), copy.getFile()).wasOk());
+    BOOST_REQUIRE (*stateOf (readDecoded (copy.getFile()), 0).getBinaryData() == first);
+}
+
+BOOST_AUTO_TEST_CASE (OnlyDirtyChunksAreWritten)
+{
+    TemporaryFile temp (".els");
+    const auto first = makeState (64 * 1024, 3), second = makeState (64 * 1024, 4);
+    auto session = makeSession (first, second);
+
+    BOOST_REQUIRE (SessionArchive::write (session.createCopy(), temp.getFile()).wasOk());
+    const auto initialSize = temp.getFile().getSize();
+
+    // unchanged: only a new index and structure get appended.
+    BOOST_REQUIRE (SessionArchive::write (session.createCopy(), temp.getFile()).wasOk());
+    BOOST_REQUIRE (temp.getFile().getSize() - initialSize < 4096);
+
+    const auto changed = makeState (64 * 1024, 5);
+    session.getChildWithName (tags::graphs).getChild (0).getChildWithName (tags::nodes).getChild (1).setProperty (tags::state, var (changed), nullptr);
+    const auto before = temp.getFile().getSize();
+    BOOST_REQUIRE (SessionArchive::write (session.createCopy(), temp.getFile()).wasOk());
+    BOOST_REQUIRE (temp.getFile().getSize() - before < 64 * 1024 + 4096);
+
+    const auto loaded = readDecoded (temp.getFile());
+    BOOST_REQUIRE (loaded.isEquivalentTo (session));
+    BOOST_REQUIRE (*stateOf (loaded, 1).getBinaryData() == changed);
+}
+
+BOOST_AUTO_TEST_CASE (TruncatedSaveFallsBack)
+{
+    TemporaryFile temp (".els");
+    const auto first = makeState (2048, 6), second = makeState (2048, 7);
+    auto session = makeSession (first, second);
+    BOOST_REQUIRE (SessionArchive::write (session.createCopy(), temp.getFile()).wasOk());
+
+    // simulate a save that died half way through appending.
+    {
+        FileOutputStream out (temp.getFile());
+        out.write ("CHNK", 4);
+        out.writeInt (0);
+    }
+
+    const auto loaded = readDecoded (temp.getFile());
+    BOOST_REQUIRE (loaded.isEquivalentTo (session));
+}
+
+BOOST_AUTO_TEST_CASE (NotAnArchive)
+{
+    TemporaryFile temp (".els");
+    temp.getFile().replaceWithText ("<?xml version=\"1.0\"?><session/>");
+    BOOST_REQUIRE (! SessionArchive::isArchive (temp.getFile()));
+    BOOST_REQUIRE (! SessionArchive::read (temp.getFile()).isValid());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
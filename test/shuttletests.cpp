@@ -1,8 +1,32 @@
-
 #include <boost/test/unit_test.hpp>
 #include <element/shuttle.hpp>
+#include <element/transport.hpp>
 
 using element::Shuttle;
+using element::TimeScale;
+using element::Transport;
+
+namespace {
+/** 120 bpm in 4/4, then 60 bpm from bar 4 (frame 352800 at 44.1k). */
+/** 100 bpm in 3/4, then 60 bpm from bar 4 (beat 12). */
+TimeScale makeTempoMap()
+{
+    TimeScale map;
+    map.setSampleRate (44100);
+    map.setTempo (100.0f);
+    map.setBeatsPerBar (3);
+    map.updateScale();
+    map.addNode (317520, 60.0f, 2, 3, 2);
+    return map;
+}
+
+void seek (Transport& transport, int64_t frame)
+{
+    transport.requestAudioFrame (frame);
+    transport.preProcess (0);
+    transport.postProcess (0);
+}
+} // namespace
 
 BOOST_AUTO_TEST_SUITE (ShuttleTests)
 
@@ -14,4 +38,69 @@ BOOST_AUTO_TEST_CASE (defaults)
     BOOST_REQUIRE_EQUAL (stl.getFramesPerBeat(), 44100.0 * 60.0 / stl.getTempo());
 }
 
+BOOST_AUTO_TEST_CASE (tempoMap)
+{
+    Transport transport;
+    transport.requestTempoMap (makeTempoMap());
+    transport.preProcess (0);
+    transport.postProcess (0);
+
+    // the map's first tempo and meter are not overwritten by the old ones.
+    BOOST_REQUIRE_EQUAL (transport.getTimeScale().nodes().count(), 2);
+    BOOST_REQUIRE_EQUAL (transport.getTempo(), 100.f);
+    BOOST_REQUIRE_EQUAL (transport.getBeatsPerBar(), 3);
+    BOOST_REQUIRE_EQUAL (transport.getMonitor()->tempo.get(), 100.0);
+    BOOST_REQUIRE_EQUAL (transport.getMonitor()->beatsPerBar.get(), 3);
+
+    BOOST_REQUIRE_CLOSE (transport.beatsFromFrame (317520), 12.0, 0.0001);
+    BOOST_REQUIRE_CLOSE (transport.beatsFromFrame (317520 + 44100), 13.0, 0.0001);
+    BOOST_REQUIRE_EQUAL (transport.frameFromBeats (13.0), 317520 + 44100);
+    BOOST_REQUIRE_EQUAL (transport.frameFromBeats (2.0), 52920);
+
+    // later requests still apply to the first node.
+    transport.requestTempo (90.0);
+    transport.preProcess (0);
+    transport.postProcess (0);
+    BOOST_REQUIRE_EQUAL (transport.getTempo(), 90.f);
+}
+
+BOOST_AUTO_TEST_CASE (splitsAtTempoChange)
+{
+    Transport transport;
+    transport.requestTempoMap (makeTempoMap());
+    seek (transport, 317520 - 100);
+    BOOST_REQUIRE_EQUAL (transport.getTempo(), 100.f);
+    BOOST_REQUIRE_EQUAL (transport.getFramesUntilChange (512), 100);
+
+    transport.advance (100);
+    BOOST_REQUIRE_EQUAL (transport.getTempo(), 60.f);
+    BOOST_REQUIRE_EQUAL (transport.getFramesUntilChange (512), 512);
+
+    auto pos = transport.getPosition();
+    BOOST_REQUIRE (pos.hasValue());
+    BOOST_REQUIRE_EQUAL (*pos->getBpm(), 60.0);
+    BOOST_REQUIRE_CLOSE (*pos->getPpqPosition(), 12.0, 0.0001);
+    BOOST_REQUIRE_EQUAL (*pos->getBarCount(), 4);
+    BOOST_REQUIRE_EQUAL (pos->getTimeSignature()->numerator, 3);
+
+    transport.advance (44100);
+    pos = transport.getPosition();
+    BOOST_REQUIRE_CLOSE (*pos->getPpqPosition(), 13.0, 0.0001);
+    BOOST_REQUIRE_CLOSE (*pos->getPpqPositionOfLastBarStart(), 12.0, 0.0001);
+
+    seek (transport, 0);
+    BOOST_REQUIRE_EQUAL (transport.getTempo(), 100.f);
+}
+
+BOOST_AUTO_TEST_CASE (splitsAtLoop)
+{
+    Transport transport;
+    transport.setLengthFrames (1000);
+    seek (transport, 900);
+    BOOST_REQUIRE_EQUAL (transport.getFramesUntilChange (512), 100);
+    transport.advance (100);
+    BOOST_REQUIRE_EQUAL (transport.getPositionFrames(), 0);
+    BOOST_REQUIRE_EQUAL (transport.getFramesUntilChange (512), 512);
+}
+
 BOOST_AUTO_TEST_SUITE_END()